@@ -34,8 +34,10 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 dnn::dnn(dnn_paras para,int client_id, int num_worker_threads, int staleness,std::string modelfile){
   num_layers=para.num_layers;
@@ -105,18 +107,16 @@ void dnn::sgd_mini_batch(int * idxes_batch, mat* weights, mat* biases, float ***
     int dim1=num_units_ineach_layer[l+1], dim2=num_units_ineach_layer[l];
     for(int j=0;j<dim1;j++){
       weights[l].Get(j, &row_acc);
-      const petuum::DenseRow<float>& r = row_acc.Get<petuum::DenseRow<float> >();
-      for(int i=0;i<dim2;i++)
-        local_weights[l][j][i]=r[i];
+      const float *r = row_acc.Get<petuum::DenseRow<float> >().GetData();
+      memcpy(local_weights[l][j], r, dim2*sizeof(float));
 	
     }
   }
   for(int l=0;l<num_layers-1;l++){
     int dim=num_units_ineach_layer[l+1];
     biases[l].Get(0, &row_acc);
-    const petuum::DenseRow<float>& r = row_acc.Get<petuum::DenseRow<float> >();
-    for(int j=0;j<dim;j++)
-      local_biases[l][j]=r[j];
+    const float *r = row_acc.Get<petuum::DenseRow<float> >().GetData();
+    memcpy(local_biases[l], r, dim*sizeof(float));
   }
 
   for(int i=0;i<size_minibatch;i++)
@@ -124,17 +124,22 @@ void dnn::sgd_mini_batch(int * idxes_batch, mat* weights, mat* biases, float ***
 	
   //update parameters
   float coeff_update=-stepsize/size_minibatch;
+  std::vector<float> row_update;
   for(int l=0;l<num_layers-1;l++){
     int dim1=num_units_ineach_layer[l+1], dim2=num_units_ineach_layer[l];
+    row_update.resize(dim2);
     for(int j=0;j<dim1;j++){
       for(int i=0;i<dim2;i++)
-        weights[l].Inc(j,i,coeff_update*delta_weights[l][j][i]);
+        row_update[i]=coeff_update*delta_weights[l][j][i];
+      weights[l].IncRow(j,row_update.data());
     }
   }
   for(int l=0;l<num_layers-1;l++){
     int dim=num_units_ineach_layer[l+1];
+    row_update.resize(dim);
     for(int j=0;j<dim;j++)
-      biases[l].Inc(0,j,coeff_update*delta_biases[l][j]);
+      row_update[j]=coeff_update*delta_biases[l][j];
+    biases[l].IncRow(0,row_update.data());
   }
 }
 
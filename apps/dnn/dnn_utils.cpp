@@ -36,7 +36,7 @@ void matrix_vector_multiply(mat W, float * a, float * b, int dim1, int dim2){
 
   for(int i=0;i<dim1;i++){
     W.Get(i, &row_acc);
-    const petuum::DenseRow<float>& r = row_acc.Get<petuum::DenseRow<float> >();
+    const float *r = row_acc.Get<petuum::DenseRow<float> >().GetData();
     float sum=0;
     for(int j=0;j<dim2;j++)
       sum+=r[j]*a[j];
@@ -47,7 +47,7 @@ void matrix_vector_multiply(mat W, float * a, float * b, int dim1, int dim2){
 void add_vector(float * a, mat b, int dim){
   petuum::RowAccessor row_acc;
   b.Get(0, &row_acc);
-  const petuum::DenseRow<float>& r = row_acc.Get<petuum::DenseRow<float> >();
+  const float *r = row_acc.Get<petuum::DenseRow<float> >().GetData();
   for(int i=0;i<dim;i++)
     a[i]+=r[i];
 }
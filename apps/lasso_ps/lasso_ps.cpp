@@ -205,7 +205,7 @@ void lasso_element(int a, int iter, int global_worker_id,
   // get beta value
   petuum::RowAccessor beta_acc;
   beta_table.Get(0, &beta_acc);
-  const petuum::DenseRow<float>& beta_val = beta_acc.Get<petuum::DenseRow<float> >();
+  const float *beta_val = beta_acc.Get<petuum::DenseRow<float> >().GetData();
 
   float new_beta = 0.0;
   float xvalue = 0.0;
@@ -113,11 +113,11 @@ void FastDocSampler::SampleOneDoc(LDADocument* doc) {
       q_sum_ = 0.;
       petuum::RowAccessor word_topic_row_acc;
       word_topic_table_.Get(it.Word(), &word_topic_row_acc);
-      const petuum::SortedVectorMapRow<int32_t>& word_topic_row =
-        word_topic_row_acc.Get<petuum::SortedVectorMapRow<int32_t> >();
+      const petuum::HybridCountRow<int32_t>& word_topic_row =
+        word_topic_row_acc.Get<petuum::HybridCountRow<int32_t> >();
 
       num_nonzero_q_terms_ = 0;
-      for (petuum::SortedVectorMapRow<int>::const_iterator wt_it =
+      for (petuum::HybridCountRow<int>::const_iterator wt_it =
           word_topic_row.cbegin(); !wt_it.is_end(); ++wt_it) {
         int32_t topic = wt_it->first;
         int32_t count = wt_it->second;
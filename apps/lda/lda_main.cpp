@@ -72,11 +72,11 @@ int main(int argc, char *argv[]) {
   table_group_config.consistency_model = petuum::SSPPush;
   table_group_config.aggressive_cpu = FLAGS_aggressive_cpu;
 
-  int32_t sorted_vector_map_row_type_id = 1;
+  int32_t hybrid_count_row_type_id = 1;
   int32_t dense_row_int_type_id = 2;
   int32_t dense_row_double_type_id = 3;
-  petuum::TableGroup::RegisterRow<petuum::SortedVectorMapRow<int32_t> >
-    (sorted_vector_map_row_type_id);
+  petuum::TableGroup::RegisterRow<petuum::HybridCountRow<int32_t> >
+    (hybrid_count_row_type_id);
   petuum::TableGroup::RegisterRow<petuum::DenseRow<int32_t> >
     (dense_row_int_type_id);
   petuum::TableGroup::RegisterRow<petuum::DenseRow<double> >
@@ -90,8 +90,9 @@ int main(int argc, char *argv[]) {
   petuum::ClientTableConfig wt_table_config;
   wt_table_config.table_info.table_staleness
     = FLAGS_word_topic_table_staleness;
-  wt_table_config.table_info.row_type = sorted_vector_map_row_type_id;
-  wt_table_config.table_info.row_capacity = 0;  // ignored.
+  wt_table_config.table_info.row_type = hybrid_count_row_type_id;
+  // Rows switch to a dense array of num_topics counts when occupied enough.
+  wt_table_config.table_info.row_capacity = FLAGS_num_topics;
   wt_table_config.process_cache_capacity =
     FLAGS_word_topic_table_process_cache_capacity;
   wt_table_config.thread_cache_capacity = 1;
@@ -105,6 +106,8 @@ int main(int argc, char *argv[]) {
     = FLAGS_summary_table_staleness;
   summary_table_config.table_info.row_type = dense_row_int_type_id;
   summary_table_config.table_info.row_capacity = FLAGS_num_topics;
+  // The hot summary row 0 would otherwise share a server with word 0.
+  summary_table_config.table_info.row_partition_type = petuum::HashPartition;
   summary_table_config.process_cache_capacity = 1;
   summary_table_config.thread_cache_capacity = 1;
   summary_table_config.oplog_capacity = 1;
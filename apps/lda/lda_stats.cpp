@@ -70,10 +70,10 @@ void LDAStats::ComputeWordLLH(int32_t ith_llh, int32_t iter) {
     petuum::RowAccessor word_topic_row_acc;
     word_topic_table_.Get(w, &word_topic_row_acc);
     const auto& word_topic_row =
-      word_topic_row_acc.Get<petuum::SortedVectorMapRow<int32_t> >();
+      word_topic_row_acc.Get<petuum::HybridCountRow<int32_t> >();
     if (word_topic_row.num_entries() > 0) {
       ++num_words_seen;  // increment only when word has non-zero tokens.
-      for (petuum::SortedVectorMapRow<int>::const_iterator wt_it =
+      for (petuum::HybridCountRow<int>::const_iterator wt_it =
           word_topic_row.cbegin(); !wt_it.is_end(); ++wt_it) {
         int count = wt_it->second;
         CHECK_LE(0, count) << "negative count.";
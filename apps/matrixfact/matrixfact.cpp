@@ -151,10 +151,8 @@ void sgd_element(int a, int iter, int global_worker_id,
     Rj_update[k] = -gradient * step_size;
   }
   // Commit updates to Petuum PS
-  for (int k = 0; k < FLAGS_K; ++k) {
-    L_table.Inc(i,k,Li_update[k]);
-    R_table.Inc(j,k,Rj_update[k]);
-  }
+  L_table.IncRow(i, Li_update.data());
+  R_table.IncRow(j, Rj_update.data());
 }
 
 // Initialize the Matrix Factorization solver
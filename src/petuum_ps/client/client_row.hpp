@@ -3,10 +3,10 @@
 // author: jinliang
 
 #include "petuum_ps/include/abstract_row.hpp"
+#include "petuum_ps/util/epoch_manager.hpp"
 
 #include <cstdint>
 #include <atomic>
-#include <memory>
 #include <boost/utility.hpp>
 #include <mutex>
 #include <glog/logging.h>
@@ -16,8 +16,9 @@ namespace petuum {
 // ClientRow is a wrapper on user-defined ROW data structure (e.g., vector,
 // map) with additional features:
 //
-// 1. Reference Counting: number of references used by application. Note the
-// copy in storage itself does not contribute to the count
+// 1. Lock-free reads: the ROW is published through an atomic pointer, and
+// replaced ROWs are reclaimed through EpochManager once no reader can be
+// using them.
 // 2. Row Metadata
 //
 // ClientRow does not provide thread-safety in itself. The locks are
@@ -26,12 +27,11 @@ class ClientRow : boost::noncopyable {
 public:
   // ClientRow takes ownership of row_data.
   ClientRow(int32_t clock __attribute__((unused)), AbstractRow* row_data):
-      num_refs_(0),
-      row_data_pptr_(new std::shared_ptr<AbstractRow>) {
-    (*row_data_pptr_).reset(row_data);
-  }
+      row_data_(row_data) { }
 
-  virtual ~ClientRow() {};
+  virtual ~ClientRow() {
+    delete row_data_.load(std::memory_order_relaxed);
+  }
 
   virtual void SetClock(int32_t clock __attribute__((unused))) { }
 
@@ -39,40 +39,27 @@ public:
     return -1;
   }
 
-  // Take row_data_pptr_ from other and destroy other. Existing ROW will not
-  // be accessible any more, but will stay alive until all RowAccessors
-  // referencing the ROW are destroyed. Accesses to SwapAndDestroy() and
-  // GetRowDataPtr() must be mutually exclusive as they the former modifies
-  // row_data_pptr_.
+  // Take the ROW from other and destroy other. Existing ROW will not be
+  // accessible any more, but will stay alive until all readers that might
+  // reference it have left their epoch. Writers must be mutually exclusive
+  // (ProcessStorage serializes them with its StripedLock); readers need not.
   virtual void SwapAndDestroy(ClientRow* other) {
-    row_data_pptr_.swap(other->row_data_pptr_);
+    AbstractRow *old_row_data = row_data_.exchange(
+        other->row_data_.exchange(0));
+    EpochManager::Retire(old_row_data);
     delete other;
   }
 
-  // GetRowDataPtr is not thread-safe, and must be protected by the
-  // StripedLock in ProcessStorage.
-  inline void GetRowDataPtr(std::shared_ptr<AbstractRow>* row_data_pptr) {
-    *row_data_pptr = *row_data_pptr_;
+  // The returned pointer stays valid until the caller calls
+  // EpochManager::Exit(), so the caller must be inside an epoch.
+  inline AbstractRow *GetRowData() const {
+    return row_data_.load(std::memory_order_acquire);
   }
 
-  // Whether this ClientRow has 0 reference count.
-  inline bool HasZeroRef() const { return (num_refs_ == 0); }
-
-  // Increment reference count (thread safe).
-  inline void IncRef() { ++num_refs_; }
-
-  // Decrement reference count (thread safe).
-  inline void DecRef() { --num_refs_; }
-
 private:  // private members
-  std::atomic<int32_t> num_refs_;
-
   // Row data stored in user-defined data structure ROW. We assume ROW to be
-  // thread-safe. (pptr stands for pointer to pointer).
-  //
-  // When ProcessStorage updates row_data_, it creates another
-  // shared_ptr<ROW> and store its address in row_data_pptr_.
-  std::unique_ptr<std::shared_ptr<AbstractRow> > row_data_pptr_;
+  // thread-safe.
+  std::atomic<AbstractRow*> row_data_;
 };
 
 }  // namespace petuum
@@ -6,6 +6,8 @@
 #include "petuum_ps/consistency/ssp_consistency_controller.hpp"
 #include "petuum_ps/consistency/ssp_push_consistency_controller.hpp"
 #include "petuum_ps/thread/context.hpp"
+#include "petuum_ps/thread/bg_workers.hpp"
+#include "petuum_ps/thread/oplog_send_budget.hpp"
 #include <cmath>
 
 namespace petuum {
@@ -14,24 +16,34 @@ ClientTable::ClientTable(int32_t table_id, const ClientTableConfig &config):
   table_id_(table_id), row_type_(config.table_info.row_type),
   sample_row_(ClassRegistry<AbstractRow>::GetRegistry().CreateObject(
     row_type_)),
+  row_capacity_(config.table_info.row_capacity),
+  staleness_(config.table_info.table_staleness),
   oplog_(table_id, std::ceil(static_cast<float>(config.oplog_capacity)
-      / GlobalContext::get_num_bg_threads()), sample_row_),
+      / GlobalContext::get_num_bg_threads()), sample_row_, row_capacity_),
   process_storage_(config.process_cache_capacity),
   oplog_index_(std::ceil(static_cast<float>(config.oplog_capacity)
-     / GlobalContext::get_num_bg_threads())) {
+     / GlobalContext::get_num_bg_threads()), config.oplog_dense_index_rows) {
+  // Row oplogs held back by the bg threads' send budget count against the
+  // staleness.
+  TableInfo read_table_info = config.table_info;
+  if (GlobalContext::get_oplog_bytes_per_clock() > 0) {
+    read_table_info.table_staleness
+        = OpLogSendBudget::GetReadStaleness(staleness_);
+  }
   switch (GlobalContext::get_consistency_model()) {
     case SSP:
       {
         consistency_controller_
-            = new SSPConsistencyController(config.table_info,
+            = new SSPConsistencyController(read_table_info,
               table_id, process_storage_, oplog_, sample_row_, thread_cache_,
               oplog_index_);
       }
       break;
     case SSPPush:
+    case SSPPushValueBound:
       {
         consistency_controller_
-            = new SSPPushConsistencyController(config.table_info,
+            = new SSPPushConsistencyController(read_table_info,
               table_id, process_storage_, oplog_, sample_row_, thread_cache_,
               oplog_index_);
       }
@@ -50,7 +62,8 @@ ClientTable::~ClientTable() {
 
 void ClientTable::RegisterThread() {
   if (thread_cache_.get() == 0)
-    thread_cache_.reset(new ThreadTable(sample_row_));
+    thread_cache_.reset(new ThreadTable(table_id_, sample_row_,
+      row_capacity_, oplog_index_));
 }
 
 void ClientTable::GetAsync(int32_t row_id) {
@@ -78,6 +91,10 @@ void ClientTable::ThreadBatchInc(int32_t row_id, const int32_t* column_ids,
     num_updates);
 }
 
+void ClientTable::ThreadIncRow(int32_t row_id, const void *updates) {
+  consistency_controller_->ThreadIncRow(row_id, updates, row_capacity_);
+}
+
 
 void ClientTable::Get(int32_t row_id, RowAccessor *row_accessor) {
   TIMER_BEGIN(table_id_, GET);
@@ -85,9 +102,15 @@ void ClientTable::Get(int32_t row_id, RowAccessor *row_accessor) {
   TIMER_END(table_id_, GET);
 }
 
+void ClientTable::GetBatch(const std::vector<int32_t> &row_ids,
+  RowAccessor *row_accessors) {
+  consistency_controller_->GetBatch(row_ids, row_accessors);
+}
+
 void ClientTable::Inc(int32_t row_id, int32_t column_id, const void *update) {
   TIMER_BEGIN(table_id_, INC);
   consistency_controller_->Inc(row_id, column_id, update);
+  CheckFlushOpLog(row_id, 1);
   TIMER_END(table_id_, INC);
 }
 
@@ -96,16 +119,45 @@ void ClientTable::BatchInc(int32_t row_id, const int32_t* column_ids,
   TIMER_BEGIN(table_id_, BATCH_INC);
   consistency_controller_->BatchInc(row_id, column_ids, updates,
     num_updates);
+  CheckFlushOpLog(row_id, num_updates);
   TIMER_END(table_id_, BATCH_INC);
 }
 
+void ClientTable::IncRow(int32_t row_id, const void *updates) {
+  TIMER_BEGIN(table_id_, INC_ROW);
+  consistency_controller_->IncRow(row_id, updates, row_capacity_);
+  CheckFlushOpLog(row_id, row_capacity_);
+  TIMER_END(table_id_, INC_ROW);
+}
+
 void ClientTable::Clock() {
   consistency_controller_->Clock();
 }
 
-cuckoohash_map<int32_t, bool> *ClientTable::GetAndResetOpLogIndex(
-    int32_t partition_num) {
-  return oplog_index_.ResetPartition(partition_num);
+void ClientTable::CheckFlushOpLog(int32_t row_id, int32_t num_updates) {
+  size_t oplog_flush_bytes = GlobalContext::get_oplog_flush_bytes();
+  if (oplog_flush_bytes == 0)
+    return;
+  int32_t partition_num = GlobalContext::GetBgPartitionNum(table_id_, row_id);
+  size_t num_bytes = (sizeof(int32_t) + sample_row_->get_update_size())
+      *num_updates;
+  if (!thread_cache_->CountOpLogBytes(partition_num, num_bytes,
+                                      oplog_flush_bytes))
+    return;
+  // The bg thread only sends the rows in the shared oplog index. Rows of
+  // other partitions are indexed early too, which is harmless.
+  thread_cache_->FlushOpLogIndex(oplog_index_);
+  BgWorkers::SendOpLogsBgThread(partition_num);
+}
+
+void ClientTable::GetAndResetOpLogIndex(int32_t partition_num,
+                                        std::vector<int32_t> *row_ids) {
+  oplog_index_.ResetPartition(partition_num, row_ids);
+}
+
+void ClientTable::AddOpLogIndex(int32_t partition_num,
+                                const std::vector<int32_t> &row_ids) {
+  oplog_index_.AddIndex(partition_num, row_ids);
 }
 
 }  // namespace petuum
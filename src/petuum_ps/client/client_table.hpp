@@ -31,14 +31,27 @@ public:
   void ThreadBatchInc(int32_t row_id, const int32_t* column_ids,
                       const void* updates,
                       int32_t num_updates);
+  // updates points to row_capacity updates, one per column.
+  void ThreadIncRow(int32_t row_id, const void *updates);
 
   void Get(int32_t row_id, RowAccessor *row_accessor);
+  void GetBatch(const std::vector<int32_t> &row_ids,
+    RowAccessor *row_accessors);
   void Inc(int32_t row_id, int32_t column_id, const void *update);
   void BatchInc(int32_t row_id, const int32_t* column_ids, const void* updates,
     int32_t num_updates);
+  // updates points to row_capacity updates, one per column.
+  void IncRow(int32_t row_id, const void *updates);
 
   void Clock();
-  cuckoohash_map<int32_t, bool> *GetAndResetOpLogIndex(int32_t client_table);
+  // Set row_ids to the rows of oplog partition partition_num indexed since
+  // the last call.
+  void GetAndResetOpLogIndex(int32_t partition_num,
+                             std::vector<int32_t> *row_ids);
+  // Index row_ids to be returned by the next GetAndResetOpLogIndex() of
+  // partition_num.
+  void AddOpLogIndex(int32_t partition_num,
+                     const std::vector<int32_t> &row_ids);
 
   ProcessStorage& get_process_storage () {
     return process_storage_;
@@ -56,16 +69,27 @@ public:
     return row_type_;
   }
 
+  int32_t get_staleness () const {
+    return staleness_;
+  }
+
 private:
   int32_t table_id_;
   int32_t row_type_;
   const AbstractRow* const sample_row_;
+  int32_t row_capacity_;
+  int32_t staleness_;
   TableOpLog oplog_;
   ProcessStorage process_storage_;
   AbstractConsistencyController *consistency_controller_;
 
   boost::thread_specific_ptr<ThreadTable> thread_cache_;
   TableOpLogIndex oplog_index_;
+
+  // Ask the bg thread of row_id to send its pending oplogs if this thread
+  // has added oplog_flush_bytes to its partition, see
+  // TableGroupConfig::oplog_flush_bytes.
+  void CheckFlushOpLog(int32_t row_id, int32_t num_updates);
 };
 
 }  // namespace petuum
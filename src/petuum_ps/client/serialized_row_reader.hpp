@@ -1,7 +1,9 @@
 // author: jinliang
 
 #include <boost/noncopyable.hpp>
+#include <vector>
 #include "petuum_ps/thread/context.hpp"
+#include "petuum_ps/thread/msg_codec.hpp"
 
 namespace petuum {
 
@@ -27,6 +29,10 @@ namespace petuum {
 // following. The latter happens only when the buffer reaches its memory
 // boundary.
 
+// Rows of tables with CompactCodec are encoded by MsgCompressor::EncodeRow()
+// and decoded by Next(); a decoded row is valid until the next call to
+// Next().
+
 class SerializedRowReader : boost::noncopyable {
 public:
   // does not take ownership
@@ -89,6 +95,13 @@ public:
         const void *data_mem = mem_ + offset_;
         offset_ += *row_size;
         //VLOG(0) << "mem read offset = " << offset_;
+        if (GlobalContext::GetTableMsgCodec(current_table_id_)
+            == CompactCodec) {
+          *row_size = MsgCompressor::GetDecodedRowSize(data_mem);
+          decoded_row_.resize(*row_size);
+          MsgCompressor::DecodeRow(data_mem, decoded_row_.data());
+          return decoded_row_.data();
+        }
         return data_mem;
       }
     }while(1);
@@ -99,6 +112,7 @@ private:
   size_t mem_size_;
   size_t offset_; // bytes to be read next
   int32_t current_table_id_;
+  std::vector<uint8_t> decoded_row_;
 };
 
 }  // namespace petuum
@@ -7,22 +7,12 @@
 
 #include <cstdint>
 #include <atomic>
-#include <memory>
 #include <boost/utility.hpp>
-#include <mutex>
 #include <glog/logging.h>
 
 namespace petuum {
 
-// ClientRow is a wrapper on user-defined ROW data structure (e.g., vector,
-// map) with additional features:
-//
-// 1. Reference Counting: number of references used by application. Note the
-// copy in storage itself does not contribute to the count
-// 2. Row Metadata
-//
-// ClientRow does not provide thread-safety in itself. The locks are
-// maintained in the storage and in (user-defined) ROW.
+// ClientRow that also records the clock of the row (see ClientRow).
 class SSPClientRow : public ClientRow {
 public:
   // ClientRow takes ownership of row_data.
@@ -31,28 +21,25 @@ public:
       clock_(clock){ }
 
   void SetClock(int32_t clock) {
-    std::unique_lock<std::mutex> ulock(clock_mtx_);
-    clock_ = clock;
+    clock_.store(clock, std::memory_order_release);
   }
 
+  // Atomic rather than mutex-protected so that reading the clock on the Get
+  // path does not write to the row's cache line.
   int32_t GetClock() const {
-    std::unique_lock<std::mutex> ulock(clock_mtx_);
-    return clock_;
+    return clock_.load(std::memory_order_acquire);
   }
 
-  // Take row_data_pptr_ from other and destroy other. Existing ROW will not
-  // be accessible any more, but will stay alive until all RowAccessors
-  // referencing the ROW are destroyed. Accesses to SwapAndDestroy() and
-  // GetRowDataPtr() must be mutually exclusive as they the former modifies
-  // row_data_pptr_.
+  // See ClientRow::SwapAndDestroy(). The clock is published after the new
+  // ROW so that a reader never sees a clock newer than the data.
   void SwapAndDestroy(ClientRow* other) {
-    clock_ = dynamic_cast<SSPClientRow*>(other)->clock_;
+    int32_t clock = dynamic_cast<SSPClientRow*>(other)->GetClock();
     ClientRow::SwapAndDestroy(other);
+    SetClock(clock);
   }
 
 private:  // private members
-  mutable std::mutex clock_mtx_;
-  int32_t clock_;
+  std::atomic<int32_t> clock_;
 };
 
 }  // namespace petuum
@@ -4,6 +4,8 @@
 #include "petuum_ps/server/server_threads.hpp"
 #include "petuum_ps/server/name_node_thread.hpp"
 #include "petuum_ps/thread/bg_workers.hpp"
+#include "petuum_ps/thread/msg_codec.hpp"
+#include "petuum_ps/thread/oplog_send_budget.hpp"
 #include <iostream>
 #include <algorithm>
 
@@ -55,8 +57,26 @@ int32_t TableGroup::Init(const TableGroupConfig &table_group_config,
     consistency_model,
     table_group_config.aggressive_cpu);
 
+  GlobalContext::SetRowMigration(table_group_config.row_migration,
+    table_group_config.row_migration_interval,
+    table_group_config.row_migration_imbalance);
+  GlobalContext::SetNumServerApplyThreads(
+    table_group_config.num_server_apply_threads);
+  GlobalContext::SetOpLogBytesPerClock(
+    table_group_config.oplog_bytes_per_clock);
+  GlobalContext::SetOpLogFlushBytes(table_group_config.oplog_flush_bytes);
+
   CommBus *comm_bus = new CommBus(local_id_min, local_id_max, 1);
   GlobalContext::comm_bus = comm_bus;
+  if (table_group_config.ipc_on_same_host) {
+    for (auto host_iter = host_map.cbegin(); host_iter != host_map.cend();
+         ++host_iter) {
+      if (comm_bus->IsLocalEntity(host_iter->first)) {
+        comm_bus->SetLocalHostIP(host_iter->second.ip);
+        break;
+      }
+    }
+  }
 
   int32_t init_thread_id = local_id_min
                            + GlobalContext::kInitThreadIDOffset;
@@ -101,6 +121,20 @@ void TableGroup::ShutDown() {
   for(auto iter = tables_.begin(); iter != tables_.end(); iter++){
     delete iter->second;
   }
+  if (MsgCompressor::get_oplog_bytes_saved() != 0
+      || MsgCompressor::get_push_row_bytes_saved() != 0) {
+    LOG(INFO) << "Bytes saved by CompactCodec: oplogs = "
+              << MsgCompressor::get_oplog_bytes_saved()
+              << " pushed rows = "
+              << MsgCompressor::get_push_row_bytes_saved();
+  }
+  if (OpLogSendBudget::get_rows_deferred() != 0) {
+    LOG(INFO) << "Oplogs deferred by oplog_bytes_per_clock: rows = "
+              << OpLogSendBudget::get_rows_deferred()
+              << " bytes = " << OpLogSendBudget::get_bytes_deferred()
+              << " rows sent overdue past the budget = "
+              << OpLogSendBudget::get_rows_overdue();
+  }
   PRINT_STATS();
 }
 
@@ -108,6 +142,9 @@ bool TableGroup::CreateTable(int32_t table_id,
   const ClientTableConfig& table_config) {
   TableGroup::max_table_staleness_ = std::max(TableGroup::max_table_staleness_,
       table_config.table_info.table_staleness);
+  // Set before the table exists so that bg and server threads see it.
+  GlobalContext::SetRowPartition(table_id, table_config.table_info);
+  GlobalContext::SetTableMsgFormat(table_id, table_config.table_info);
   return BgWorkers::CreateTable(table_id, table_config);
 }
 
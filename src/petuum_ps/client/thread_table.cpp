@@ -6,9 +6,15 @@
 
 namespace petuum {
 
-ThreadTable::ThreadTable(const AbstractRow *sample_row) :
+ThreadTable::ThreadTable(int32_t table_id, const AbstractRow *sample_row,
+                         int32_t row_capacity,
+                         TableOpLogIndex &table_oplog_index) :
+    table_id_(table_id),
+    table_oplog_index_(table_oplog_index),
     oplog_index_(GlobalContext::get_num_bg_threads()),
-    sample_row_(sample_row){ }
+    oplog_bytes_(GlobalContext::get_num_bg_threads(), 0),
+    sample_row_(sample_row),
+    row_capacity_(row_capacity) { }
 
 ThreadTable::~ThreadTable() {
   for (auto iter = row_storage_.begin(); iter != row_storage_.end(); iter++) {
@@ -24,12 +30,22 @@ ThreadTable::~ThreadTable() {
 
 void ThreadTable::IndexUpdate(int32_t row_id) {
   VLOG(0) << "oplog_index_.size() = " << oplog_index_.size();
-  int32_t partition_num = GlobalContext::GetBgPartitionNum(row_id);
+  int32_t partition_num = GlobalContext::GetBgPartitionNum(table_id_,
+    row_id);
   VLOG(0) << "partition_num = " << partition_num;
-  oplog_index_[partition_num][row_id] = true;
+  IndexUpdate(partition_num, row_id);
+}
+
+void ThreadTable::IndexUpdate(int32_t partition_num, int32_t row_id) {
+  if (table_oplog_index_.is_dense())
+    table_oplog_index_.AddDenseIndex(partition_num, row_id);
+  else
+    oplog_index_[partition_num][row_id] = true;
 }
 
 void ThreadTable::FlushOpLogIndex(TableOpLogIndex &table_oplog_index) {
+  if (table_oplog_index.is_dense())
+    return;
   for (int32_t i = 0; i < GlobalContext::get_num_bg_threads(); ++i) {
     const boost::unordered_map<int32_t, bool> &partition_oplog_index
         = oplog_index_[i];
@@ -38,6 +54,15 @@ void ThreadTable::FlushOpLogIndex(TableOpLogIndex &table_oplog_index) {
   }
 }
 
+bool ThreadTable::CountOpLogBytes(int32_t partition_num, size_t num_bytes,
+  size_t flush_bytes) {
+  oplog_bytes_[partition_num] += num_bytes;
+  if (oplog_bytes_[partition_num] < flush_bytes)
+    return false;
+  oplog_bytes_[partition_num] = 0;
+  return true;
+}
+
 AbstractRow *ThreadTable::GetRow(int32_t row_id) {
   boost::unordered_map<int32_t, AbstractRow* >::iterator row_iter
       = row_storage_.find(row_id);
@@ -77,8 +102,8 @@ void ThreadTable::Inc(int32_t row_id, int32_t column_id, const void *delta) {
   RowOpLog *row_oplog;
 
   if (oplog_iter == oplog_map_.end()) {
-    row_oplog = new RowOpLog(sample_row_->get_update_size(),
-                                      sample_row_);
+    row_oplog = CreateRowOpLog(sample_row_->get_update_size(),
+                               sample_row_, row_capacity_);
     oplog_map_[row_id] = row_oplog;
   } else {
     row_oplog = oplog_iter->second;
@@ -102,8 +127,8 @@ void ThreadTable::BatchInc(int32_t row_id, const int32_t *column_ids,
   RowOpLog *row_oplog;
 
   if (oplog_iter == oplog_map_.end()) {
-    row_oplog = new RowOpLog(sample_row_->get_update_size(),
-                                      sample_row_);
+    row_oplog = CreateRowOpLog(sample_row_->get_update_size(),
+                               sample_row_, row_capacity_);
     oplog_map_[row_id] = row_oplog;
   } else {
     row_oplog = oplog_iter->second;
@@ -124,13 +149,38 @@ void ThreadTable::BatchInc(int32_t row_id, const int32_t *column_ids,
   }
 }
 
+void ThreadTable::IncRow(int32_t row_id, const void *deltas,
+                         int32_t num_updates) {
+  boost::unordered_map<int32_t, RowOpLog* >::iterator oplog_iter
+      = oplog_map_.find(row_id);
+
+  RowOpLog *row_oplog;
+
+  if (oplog_iter == oplog_map_.end()) {
+    row_oplog = CreateRowOpLog(sample_row_->get_update_size(),
+                               sample_row_, row_capacity_);
+    oplog_map_[row_id] = row_oplog;
+  } else {
+    row_oplog = oplog_iter->second;
+  }
+
+  row_oplog->IncRow(deltas, num_updates);
+
+  boost::unordered_map<int32_t, AbstractRow* >::iterator row_iter
+      = row_storage_.find(row_id);
+  if (row_iter != row_storage_.end()) {
+    row_iter->second->ApplyDenseBatchIncUnsafe(deltas, num_updates);
+  }
+}
+
 void ThreadTable::FlushCache(ProcessStorage &process_storage,
                              TableOpLog &table_oplog) {
   for (auto oplog_iter = oplog_map_.begin(); oplog_iter != oplog_map_.end();
        oplog_iter++) {
 
     int32_t row_id = oplog_iter->first;
-    int32_t partition_num = GlobalContext::GetBgPartitionNum(row_id);
+    int32_t partition_num = GlobalContext::GetBgPartitionNum(table_id_,
+      row_id);
     RowAccessor row_accessor;
     bool found = process_storage.Find(row_id, &row_accessor);
 
@@ -138,7 +188,7 @@ void ThreadTable::FlushCache(ProcessStorage &process_storage,
     void *delta = oplog_iter->second->BeginIterate(&column_id);
     while (delta != 0) {
       table_oplog.Inc(row_id, column_id, delta);
-      oplog_index_[partition_num][row_id] = true;
+      IndexUpdate(partition_num, row_id);
       if (found) {
         row_accessor.GetRowData()->ApplyInc(column_id, delta);
       }
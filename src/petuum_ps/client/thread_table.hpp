@@ -13,24 +13,39 @@ namespace petuum {
 
 class ThreadTable : boost::noncopyable {
 public:
-  explicit ThreadTable(const AbstractRow *sample_row);
+  // Rows are indexed into table_oplog_index directly if it is dense.
+  ThreadTable(int32_t table_id, const AbstractRow *sample_row,
+    int32_t row_capacity, TableOpLogIndex &table_oplog_index);
   ~ThreadTable();
   void IndexUpdate(int32_t row_id);
   void FlushOpLogIndex(TableOpLogIndex &oplog_index);
+  // Count num_bytes of updates added to oplog partition partition_num and
+  // return true, restarting the count, once the count reaches flush_bytes.
+  bool CountOpLogBytes(int32_t partition_num, size_t num_bytes,
+    size_t flush_bytes);
 
   AbstractRow *GetRow(int32_t row_id);
   void InsertRow(int32_t row_id, const AbstractRow *to_insert);
   void Inc(int32_t row_id, int32_t column_id, const void *delta);
   void BatchInc(int32_t row_id, const int32_t *column_ids,
     const void *deltas, int32_t num_updates);
+  void IncRow(int32_t row_id, const void *deltas, int32_t num_updates);
 
   void FlushCache(ProcessStorage &process_storage, TableOpLog &table_oplog);
 
 private:
+  void IndexUpdate(int32_t partition_num, int32_t row_id);
+
+  int32_t table_id_;
+  TableOpLogIndex &table_oplog_index_;
   std::vector<boost::unordered_map<int32_t, bool> > oplog_index_;
+  // Bytes of updates added to each oplog partition since CountOpLogBytes()
+  // last returned true for it.
+  std::vector<size_t> oplog_bytes_;
   boost::unordered_map<int32_t, AbstractRow* > row_storage_;
   boost::unordered_map<int32_t, RowOpLog* > oplog_map_;
   const AbstractRow *sample_row_;
+  int32_t row_capacity_;
 };
 
 }
@@ -12,6 +12,7 @@ namespace petuum {
 
 const std::string CommBus::kInProcPrefix("inproc://comm_bus");
 const std::string CommBus::kInterProcPrefix("tcp://");
+const std::string CommBus::kIpcPrefix("ipc:///tmp/comm_bus:");
 
 void CommBus::MakeInProcAddr(int32_t entity_id, std::string *result) {
   std::stringstream ss;
@@ -27,6 +28,23 @@ void CommBus::MakeInterProcAddr(const std::string &network_addr,
   *result += network_addr;
 }
 
+void CommBus::MakeIpcAddr(const std::string &network_addr,
+  std::string *result) {
+  *result = kIpcPrefix;
+  *result += network_addr;
+}
+
+bool CommBus::IsLocalHostAddr(const std::string &network_addr) {
+  if (local_host_ip_.empty())
+    return false;
+  return network_addr.substr(0, network_addr.find_last_of(':'))
+      == local_host_ip_;
+}
+
+void CommBus::SetLocalHostIP(const std::string &ip) {
+  local_host_ip_ = ip;
+}
+
 bool CommBus::IsLocalEntity(int32_t entity_id) {
   //VLOG(0) << "e_st_ = " << e_st_
   //	  << " e_end_ = " << e_end_;
@@ -125,6 +143,11 @@ void CommBus::ThreadRegister(const Config &config) {
     MakeInterProcAddr(config.network_addr_, &bind_addr);
 
     ZMQUtil::ZMQBind(sock, bind_addr);
+
+    if (IsLocalHostAddr(config.network_addr_)) {
+      MakeIpcAddr(config.network_addr_, &bind_addr);
+      ZMQUtil::ZMQBind(sock, bind_addr);
+    }
   }
 }
 
@@ -174,7 +197,10 @@ void CommBus::ConnectTo(int32_t entity_id, const std::string &network_addr,
   }
 
   std::string connect_addr;
-  MakeInterProcAddr(network_addr, &connect_addr);
+  if (IsLocalHostAddr(network_addr))
+    MakeIpcAddr(network_addr, &connect_addr);
+  else
+    MakeInterProcAddr(network_addr, &connect_addr);
   int32_t zmq_id = ZMQUtil::EntityID2ZmqID(entity_id);
   ZMQUtil::ZMQConnectSend(sock, connect_addr, zmq_id, connect_msg, size);
 }
@@ -236,6 +262,15 @@ size_t CommBus::SendInProc(int32_t entity_id, zmq::message_t &msg) {
   return nbytes;
 }
 
+size_t CommBus::SendInterProc(int32_t entity_id, zmq::message_t &msg) {
+  zmq::socket_t *sock = thr_info_->interproc_sock_.get();
+
+  int32_t recv_id = ZMQUtil::EntityID2ZmqID(entity_id);
+  size_t nbytes = ZMQUtil::ZMQSend(sock, recv_id, msg, 0);
+
+  return nbytes;
+}
+
 
 void CommBus::Recv(int32_t *entity_id, zmq::message_t *msg) {
   if (thr_info_->pollitems_.get() == NULL) {
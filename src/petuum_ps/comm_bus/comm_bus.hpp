@@ -87,6 +87,13 @@ public:
 
   bool IsLocalEntity(int32_t entity_id);
 
+  // Remote entities whose network address has this ip are reached through
+  // ZMQ's ipc:// transport rather than tcp://, and kInterProc sockets at
+  // such an address listen on both. Messages take the same path through
+  // ZMQ either way, including their copies. Must be called before any thread
+  // registers.
+  void SetLocalHostIP(const std::string &ip);
+
   // This function must be called before any other functions.
   // A "happen-before" relation must be established between this
   // function and other functions.
@@ -113,6 +120,7 @@ public:
   // msg is nollified
   size_t Send(int32_t entity_id, zmq::message_t &msg);
   size_t SendInProc(int32_t entity_id, zmq::message_t &msg);
+  size_t SendInterProc(int32_t entity_id, zmq::message_t &msg);
 
   void Recv(int32_t *entity_id, zmq::message_t *msg);
   bool RecvAsync(int32_t *entity_id, zmq::message_t *msg);
@@ -142,15 +150,21 @@ private:
   static void MakeInProcAddr(int32_t entity_id, std::string *result);
   static void MakeInterProcAddr(const std::string &network_addr,
       std::string *result);
+  static void MakeIpcAddr(const std::string &network_addr,
+      std::string *result);
+  bool IsLocalHostAddr(const std::string &network_addr);
 
   static void SetUpRouterSocket(zmq::socket_t *sock, int32_t id,
   int num_bytes_send_buff, int num_bytes_recv_buff);
   static const std::string kInProcPrefix;
   static const std::string kInterProcPrefix;
+  static const std::string kIpcPrefix;
   zmq::context_t *zmq_ctx_;
   // denote the range of entity IDs that are local, inclusive
   int32_t e_st_;
   int32_t e_end_;
+  // Empty if SetLocalHostIP() is not called.
+  std::string local_host_ip_;
   boost::thread_specific_ptr<ThreadCommInfo> thr_info_;
 };
 }   // namespace petuum
@@ -233,9 +233,11 @@ size_t ZMQUtil::ZMQSend(zmq::socket_t *sock, int32_t zmq_id, const void *data,
 }
 
 size_t ZMQUtil::ZMQSend(zmq::socket_t *sock, zmq::message_t &msg, int flag){
-  size_t nbytes;
+  // send() returns whether msg was sent and empties it if so.
+  size_t nbytes = msg.size();
   try{
-    nbytes = sock->send(msg, flag);
+    if (!sock->send(msg, flag))
+      nbytes = 0;
   }catch(zmq::error_t &e){
     switch(e.num()){
     case ENOTSUP:
@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <stdint.h>
 #include <time.h>
+#include <string>
 
 namespace petuum {
 
@@ -41,6 +42,7 @@ public:
     size_t len, int flag = 0);
 
   // msg is nollified during the call
+  // return msg's size if sent, 0 otherwise
   static size_t ZMQSend(zmq::socket_t *sock, zmq::message_t &msg, int flag = 0);
 
   static size_t ZMQSend(zmq::socket_t *sock, int32_t zmq_id, 
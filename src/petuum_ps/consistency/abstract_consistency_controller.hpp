@@ -45,6 +45,13 @@ public:
   // fresh in SSP. The result is returned in row_accessor.
   virtual void Get(int32_t row_id, RowAccessor* row_accessor) = 0;
 
+  // Read row_ids.size() rows and is blocked until all of them are valid.
+  // Rows that need to be fetched are requested together, with one round trip
+  // per bg thread. row_accessors points to an array of row_ids.size()
+  // RowAccessors; the i-th row is returned in row_accessors[i].
+  virtual void GetBatch(const std::vector<int32_t> &row_ids,
+    RowAccessor* row_accessors) = 0;
+
   // Increment (update) an entry. Does not take ownership of input argument
   // delta, which should be of template type UPDATE in Table. This may trigger
   // synchronization (e.g., in value-bound) and is blocked until consistency
@@ -55,6 +62,11 @@ public:
   virtual void BatchInc(int32_t row_id, const int32_t* column_ids,
     const void* updates, int32_t num_updates) = 0;
 
+  // Increment columns 0 to num_updates - 1 of a row by the dense array
+  // updates, with one oplog lookup for the whole row.
+  virtual void IncRow(int32_t row_id, const void* updates,
+    int32_t num_updates) = 0;
+
   // Read a row in the table and is blocked until a valid row is obtained
   // (e.g., from server). A row is valid if, for example, it is sufficiently
   // fresh in SSP. The result is returned in row_accessor.
@@ -71,6 +83,9 @@ public:
   virtual void ThreadBatchInc(int32_t row_id, const int32_t* column_ids,
     const void* updates, int32_t num_updates) = 0;
 
+  virtual void ThreadIncRow(int32_t row_id, const void* updates,
+    int32_t num_updates) = 0;
+
   virtual void Clock() = 0;
 
 protected:    // common class members for all controller modules.
@@ -21,6 +21,41 @@ SSPConsistencyController::SSPConsistencyController(const TableInfo& info,
   table_id_(table_id),
   staleness_(info.table_staleness) { }
 
+void SSPConsistencyController::GetAsync(int32_t row_id) {
+  // Look for row_id in process_storage_.
+  int32_t stalest_clock = std::max(0, ThreadContext::get_clock() - staleness_);
+
+  {
+    RowAccessor row_accessor;
+    bool found = process_storage_.Find(row_id, &row_accessor);
+    if (found && (row_accessor.GetClientRow()->GetClock() >= stalest_clock))
+      return;
+  }
+
+  if (pending_async_get_cnt_.get() == 0) {
+    pending_async_get_cnt_.reset(new size_t);
+    *pending_async_get_cnt_ = 0;
+  }
+
+  if (*pending_async_get_cnt_ == kMaxPendingAsyncGetCnt) {
+    BgWorkers::GetAsyncRowRequestReply();
+    *pending_async_get_cnt_ -= 1;
+  }
+
+  BgWorkers::RequestRowAsync(table_id_, row_id, stalest_clock);
+  *pending_async_get_cnt_ += 1;
+}
+
+void SSPConsistencyController::WaitPendingAsnycGet() {
+  if (pending_async_get_cnt_.get() == 0)
+    return;
+
+  while(*pending_async_get_cnt_ > 0) {
+    BgWorkers::GetAsyncRowRequestReply();
+    *pending_async_get_cnt_ -= 1;
+  }
+}
+
 void SSPConsistencyController::Get(int32_t row_id, RowAccessor* row_accessor) {
   // Look for row_id in process_storage_.
   int32_t stalest_clock = std::max(0, ThreadContext::get_clock() - staleness_);
@@ -60,12 +95,57 @@ void SSPConsistencyController::Get(int32_t row_id, RowAccessor* row_accessor) {
     stalest_clock);
 }
 
+void SSPConsistencyController::GetBatch(const std::vector<int32_t> &row_ids,
+  RowAccessor* row_accessors) {
+  // Replies to outstanding GetAsync() must not be mistaken for the batch
+  // reply.
+  WaitPendingAsnycGet();
+
+  int32_t stalest_clock = std::max(0, ThreadContext::get_clock() - staleness_);
+
+  std::vector<int32_t> rows_to_request;
+  for (size_t i = 0; i < row_ids.size(); ++i) {
+    bool found = process_storage_.Find(row_ids[i], &row_accessors[i]);
+    if (!found
+        || row_accessors[i].GetClientRow()->GetClock() < stalest_clock)
+      rows_to_request.push_back(row_ids[i]);
+  }
+
+  if (rows_to_request.empty())
+    return;
+
+  std::sort(rows_to_request.begin(), rows_to_request.end());
+  rows_to_request.erase(std::unique(rows_to_request.begin(),
+                                    rows_to_request.end()),
+                        rows_to_request.end());
+
+  // Do not hold the rows found so far while blocked on the bg thread, as
+  // that delays the reclamation of replaced and evicted rows. They are
+  // looked up again below.
+  for (size_t i = 0; i < row_ids.size(); ++i) {
+    row_accessors[i].Clear();
+  }
+
+  TIMER_BEGIN(table_id_, SSP_ROW_REQUEST);
+  BgWorkers::RequestRowBatch(table_id_, rows_to_request, stalest_clock);
+  TIMER_END(table_id_, SSP_ROW_REQUEST);
+
+  for (size_t i = 0; i < row_ids.size(); ++i) {
+    bool found = process_storage_.Find(row_ids[i], &row_accessors[i]);
+    if (!found
+        || row_accessors[i].GetClientRow()->GetClock() < stalest_clock)
+      Get(row_ids[i], &row_accessors[i]);
+  }
+}
+
 void SSPConsistencyController::Inc(int32_t row_id, int32_t column_id,
     const void* delta) {
 
-  thread_cache_->IndexUpdate(row_id);
-
   oplog_.Inc(row_id,column_id, delta);
+  // Index after the oplog write: the bg thread may reset the index and
+  // take the row's oplog at any time, and an update written after that
+  // must find the index bit cleared.
+  thread_cache_->IndexUpdate(row_id);
 
   RowAccessor row_accessor;
   bool found = process_storage_.Find(row_id, &row_accessor);
@@ -77,8 +157,8 @@ void SSPConsistencyController::Inc(int32_t row_id, int32_t column_id,
 void SSPConsistencyController::BatchInc(int32_t row_id,
   const int32_t* column_ids, const void* updates, int32_t num_updates) {
 
-  thread_cache_->IndexUpdate(row_id);
   oplog_.BatchInc(row_id, column_ids, updates, num_updates);
+  thread_cache_->IndexUpdate(row_id);
 
   RowAccessor row_accessor;
   bool found = process_storage_.Find(row_id, &row_accessor);
@@ -88,6 +168,21 @@ void SSPConsistencyController::BatchInc(int32_t row_id,
   }
 }
 
+void SSPConsistencyController::IncRow(int32_t row_id, const void* updates,
+  int32_t num_updates) {
+
+  TIMER_BEGIN(table_id_, SSP_INC_ROW);
+  oplog_.IncRow(row_id, updates, num_updates);
+  thread_cache_->IndexUpdate(row_id);
+
+  RowAccessor row_accessor;
+  bool found = process_storage_.Find(row_id, &row_accessor);
+  if (found) {
+    row_accessor.GetRowData()->ApplyDenseBatchInc(updates, num_updates);
+  }
+  TIMER_END(table_id_, SSP_INC_ROW);
+}
+
 void SSPConsistencyController::ThreadGet(int32_t row_id,
   ThreadRowAccessor* row_accessor) {
 
@@ -155,6 +250,13 @@ void SSPConsistencyController::ThreadBatchInc(int32_t row_id,
   thread_cache_->BatchInc(row_id, column_ids, updates, num_updates);
 }
 
+void SSPConsistencyController::ThreadIncRow(int32_t row_id, const void* updates,
+  int32_t num_updates) {
+  TIMER_BEGIN(table_id_, SSP_THREAD_INC_ROW);
+  thread_cache_->IncRow(row_id, updates, num_updates);
+  TIMER_END(table_id_, SSP_THREAD_INC_ROW);
+}
+
 void SSPConsistencyController::Clock() {
   // order is important
   thread_cache_->FlushCache(process_storage_, oplog_);
@@ -3,6 +3,7 @@
 #include "petuum_ps/consistency/abstract_consistency_controller.hpp"
 #include "petuum_ps/oplog/oplog.hpp"
 #include "petuum_ps/util/vector_clock_mt.hpp"
+#include <boost/thread/tss.hpp>
 #include <utility>
 #include <vector>
 #include <cstdint>
@@ -20,19 +21,26 @@ public:
     boost::thread_specific_ptr<ThreadTable> &thread_cache,
     TableOpLogIndex &oplog_index);
 
-  void GetAsync(int32_t row_id) { }
-  void WaitPendingAsnycGet() { }
+  void GetAsync(int32_t row_id);
+  void WaitPendingAsnycGet();
 
   // Check freshness; make request and block if too stale or row_id not found
   // in storage.
   void Get(int32_t row_id, RowAccessor* row_accessor);
 
+  // Request all missing or stale rows in one batch and block until they are
+  // available.
+  void GetBatch(const std::vector<int32_t> &row_ids,
+    RowAccessor* row_accessors);
+
   // Return immediately.
   void Inc(int32_t row_id, int32_t column_id, const void* delta);
 
   void BatchInc(int32_t row_id, const int32_t* column_ids, const void* updates,
     int32_t num_updates);
 
+  void IncRow(int32_t row_id, const void* updates, int32_t num_updates);
+
   void ThreadGet(int32_t row_id, ThreadRowAccessor* row_accessor);
 
   void ThreadInc(int32_t row_id, int32_t column_id, const void* delta);
@@ -41,6 +49,8 @@ public:
   void ThreadBatchInc(int32_t row_id, const int32_t* column_ids,
     const void* updates, int32_t num_updates);
 
+  void ThreadIncRow(int32_t row_id, const void* updates, int32_t num_updates);
+
   void Clock();
 
 private:  // private methods
@@ -54,6 +64,9 @@ private:
 
   // SSP staleness parameter.
   int32_t staleness_;
+
+  static const size_t kMaxPendingAsyncGetCnt = 256;
+  boost::thread_specific_ptr<size_t> pending_async_get_cnt_;
 };
 
 }  // namespace petuum
@@ -4,6 +4,7 @@
 #include "petuum_ps/thread/bg_workers.hpp"
 #include "petuum_ps/util/stats.hpp"
 #include <glog/logging.h>
+#include <algorithm>
 
 namespace petuum {
 
@@ -82,12 +83,56 @@ void SSPPushConsistencyController::Get(int32_t row_id,
   }while(!found);
 }
 
+void SSPPushConsistencyController::GetBatch(
+  const std::vector<int32_t> &row_ids, RowAccessor* row_accessors) {
+  // Replies to outstanding GetAsync() must not be mistaken for the batch
+  // reply.
+  WaitPendingAsnycGet();
+
+  int32_t stalest_clock = std::max(0, ThreadContext::get_clock() - staleness_);
+
+  if(BgWorkers::GetSystemClock() < stalest_clock)
+    BgWorkers::WaitSystemClock(stalest_clock);
+
+  std::vector<int32_t> rows_to_request;
+  for (size_t i = 0; i < row_ids.size(); ++i) {
+    if (!process_storage_.Find(row_ids[i], &row_accessors[i]))
+      rows_to_request.push_back(row_ids[i]);
+  }
+
+  if (rows_to_request.empty())
+    return;
+
+  std::sort(rows_to_request.begin(), rows_to_request.end());
+  rows_to_request.erase(std::unique(rows_to_request.begin(),
+                                    rows_to_request.end()),
+                        rows_to_request.end());
+
+  // Do not hold the rows found so far while blocked on the bg thread, as
+  // that delays the reclamation of replaced and evicted rows. They are
+  // looked up again below.
+  for (size_t i = 0; i < row_ids.size(); ++i) {
+    row_accessors[i].Clear();
+  }
+
+  TIMER_BEGIN(table_id_, SSP_ROW_REQUEST);
+  BgWorkers::RequestRowBatch(table_id_, rows_to_request, stalest_clock);
+  TIMER_END(table_id_, SSP_ROW_REQUEST);
+
+  for (size_t i = 0; i < row_ids.size(); ++i) {
+    if (!process_storage_.Find(row_ids[i], &row_accessors[i]))
+      Get(row_ids[i], &row_accessors[i]);
+  }
+}
+
 void SSPPushConsistencyController::Inc(int32_t row_id, int32_t column_id,
     const void* delta) {
 
-  thread_cache_->IndexUpdate(row_id);
-
   oplog_.Inc(row_id,column_id, delta);
+  // Index after the oplog write: the bg thread may reset the index and
+  // take the row's oplog at any time, and an update written after that
+  // must find the index bit cleared.
+  thread_cache_->IndexUpdate(row_id);
 
   RowAccessor row_accessor;
   bool found = process_storage_.Find(row_id, &row_accessor);
@@ -99,14 +144,14 @@ void SSPPushConsistencyController::Inc(int32_t row_id, int32_t column_id,
 void SSPPushConsistencyController::BatchInc(int32_t row_id,
   const int32_t* column_ids, const void* updates, int32_t num_updates) {
 
-  TIMER_BEGIN(table_id_, SSPPUSH_BATCH_INC_THR_UPDATE_INDEX);
-  thread_cache_->IndexUpdate(row_id);
-  TIMER_END(table_id_, SSPPUSH_BATCH_INC_THR_UPDATE_INDEX);
-
   TIMER_BEGIN(table_id_, SSPPUSH_BATCH_INC_OPLOG);
   oplog_.BatchInc(row_id, column_ids, updates, num_updates);
   TIMER_END(table_id_, SSPPUSH_BATCH_INC_OPLOG);
 
+  TIMER_BEGIN(table_id_, SSPPUSH_BATCH_INC_THR_UPDATE_INDEX);
+  thread_cache_->IndexUpdate(row_id);
+  TIMER_END(table_id_, SSPPUSH_BATCH_INC_THR_UPDATE_INDEX);
+
   TIMER_BEGIN(table_id_, SSPPUSH_BATCH_INC_PROCESS_STORAGE);
   RowAccessor row_accessor;
   bool found = process_storage_.Find(row_id, &row_accessor);
@@ -117,6 +162,26 @@ void SSPPushConsistencyController::BatchInc(int32_t row_id,
   TIMER_END(table_id_, SSPPUSH_BATCH_INC_PROCESS_STORAGE);
 }
 
+void SSPPushConsistencyController::IncRow(int32_t row_id, const void* updates,
+  int32_t num_updates) {
+
+  TIMER_BEGIN(table_id_, SSPPUSH_INC_ROW_OPLOG);
+  oplog_.IncRow(row_id, updates, num_updates);
+  TIMER_END(table_id_, SSPPUSH_INC_ROW_OPLOG);
+
+  TIMER_BEGIN(table_id_, SSPPUSH_INC_ROW_THR_UPDATE_INDEX);
+  thread_cache_->IndexUpdate(row_id);
+  TIMER_END(table_id_, SSPPUSH_INC_ROW_THR_UPDATE_INDEX);
+
+  TIMER_BEGIN(table_id_, SSPPUSH_INC_ROW_PROCESS_STORAGE);
+  RowAccessor row_accessor;
+  bool found = process_storage_.Find(row_id, &row_accessor);
+  if (found) {
+    row_accessor.GetRowData()->ApplyDenseBatchInc(updates, num_updates);
+  }
+  TIMER_END(table_id_, SSPPUSH_INC_ROW_PROCESS_STORAGE);
+}
+
 void SSPPushConsistencyController::ThreadGet(int32_t row_id,
   ThreadRowAccessor* row_accessor) {
   // Look for row_id in process_storage_.
@@ -170,6 +235,13 @@ void SSPPushConsistencyController::ThreadBatchInc(int32_t row_id,
   TIMER_END(table_id_, SSPPUSH_THREAD_BATCH_INC);
 }
 
+void SSPPushConsistencyController::ThreadIncRow(int32_t row_id, const void* updates,
+  int32_t num_updates) {
+  TIMER_BEGIN(table_id_, SSPPUSH_THREAD_INC_ROW);
+  thread_cache_->IncRow(row_id, updates, num_updates);
+  TIMER_END(table_id_, SSPPUSH_THREAD_INC_ROW);
+}
+
 void SSPPushConsistencyController::Clock() {
   // order is important
   thread_cache_->FlushCache(process_storage_, oplog_);
@@ -28,12 +28,19 @@ public:
   // in storage.
   void Get(int32_t row_id, RowAccessor* row_accessor);
 
+  // Request all missing or stale rows in one batch and block until they are
+  // available.
+  void GetBatch(const std::vector<int32_t> &row_ids,
+    RowAccessor* row_accessors);
+
   // Return immediately.
   void Inc(int32_t row_id, int32_t column_id, const void* delta);
 
   void BatchInc(int32_t row_id, const int32_t* column_ids, const void* updates,
     int32_t num_updates);
 
+  void IncRow(int32_t row_id, const void* updates, int32_t num_updates);
+
   void ThreadGet(int32_t row_id, ThreadRowAccessor* row_accessor);
 
   void ThreadInc(int32_t row_id, int32_t column_id, const void* delta);
@@ -42,6 +49,8 @@ public:
   void ThreadBatchInc(int32_t row_id, const int32_t* column_ids,
     const void* updates, int32_t num_updates);
 
+  void ThreadIncRow(int32_t row_id, const void* updates, int32_t num_updates);
+
 
   void Clock();
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <boost/thread.hpp>
+#include <cmath>
 #include <vector>
 #include <boost/shared_array.hpp>
 
@@ -50,6 +51,32 @@ public:
   virtual void ApplyBatchIncUnsafe(const int32_t *column_ids,
     const void* update_batch, int32_t num_updates) = 0;
 
+  // Same as ApplyBatchInc() and ApplyBatchIncUnsafe() with column ids
+  // 0, 1, ..., num_updates - 1. Row types with dense storage should override
+  // these to avoid materializing the column ids.
+  virtual void ApplyDenseBatchInc(const void* update_batch,
+    int32_t num_updates) {
+    std::vector<int32_t> column_ids(num_updates);
+    for (int32_t i = 0; i < num_updates; ++i)
+      column_ids[i] = i;
+    ApplyBatchInc(column_ids.data(), update_batch, num_updates);
+  }
+
+  virtual void ApplyDenseBatchIncUnsafe(const void* update_batch,
+    int32_t num_updates) {
+    std::vector<int32_t> column_ids(num_updates);
+    for (int32_t i = 0; i < num_updates; ++i)
+      column_ids[i] = i;
+    ApplyBatchIncUnsafe(column_ids.data(), update_batch, num_updates);
+  }
+
+  // Magnitude of a batch of updates (e.g. the sum of their absolute values),
+  // used by value-bounded consistency models to measure how far a row has
+  // drifted. Rows whose updates are plain numbers can return
+  // SumAbsUpdates(). Need not be thread-safe.
+  virtual double GetUpdatesMagnitude(const int32_t *column_ids,
+    const void* update_batch, int32_t num_updates) const = 0;
+
   // Aggregate update1 and update2 by summation and substraction (update1 -
   // update2), outputing to update2. column_id is optionally used in case
   // updates are applied differently for different column of a row.
@@ -63,9 +90,41 @@ public:
   virtual void SubtractUpdates(int32_t column_id, void *update1,
     const void* update2) const = 0;
 
+  // AddUpdates() over two arrays of num_updates updates, column i being the
+  // i-th update of each array.
+  virtual void AddDenseUpdates(void* updates1, const void* updates2,
+    int32_t num_updates) const {
+    size_t update_size = get_update_size();
+    uint8_t *updates1_uint8 = reinterpret_cast<uint8_t*>(updates1);
+    const uint8_t *updates2_uint8 = reinterpret_cast<const uint8_t*>(updates2);
+    for (int32_t i = 0; i < num_updates; ++i) {
+      AddUpdates(i, updates1_uint8 + update_size*i,
+                 updates2_uint8 + update_size*i);
+    }
+  }
+
   // Initialize update. Initialized update represents "zero update".
   // In other words, 0 + u = u (0 is the zero update).
   virtual void InitUpdate(int32_t column_id, void* zero) const = 0;
+
+  // Whether column ids of this row type are dense in [0, row capacity), so
+  // pending updates are better kept in a flat array than in a map (see
+  // DenseRowOpLog).
+  virtual bool HasDenseUpdates() const {
+    return false;
+  }
+
+protected:
+  // L1 norm of num_updates contiguous updates of arithmetic type V.
+  template<typename V>
+  static double SumAbsUpdates(const void* update_batch, int32_t num_updates) {
+    const V *typed_updates = reinterpret_cast<const V*>(update_batch);
+    double magnitude = 0;
+    for (int32_t i = 0; i < num_updates; ++i) {
+      magnitude += std::fabs(static_cast<double>(typed_updates[i]));
+    }
+    return magnitude;
+  }
 };
 
 }   // namespace petuum
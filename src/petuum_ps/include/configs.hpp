@@ -17,14 +17,78 @@ enum ConsistencyModel {
   // Assumes that all clients have the same number of bg threads.
   SSPPush = 1,
 
+  // SSPPush where the server additionally defers pushing a row until the
+  // accumulated magnitude of updates to that row reaches the table's
+  // value_bound, and pushes it right away (without waiting for the clock to
+  // advance) once it does.
   SSPPushValueBound = 2
 };
 
+// How the rows of a table are assigned to servers and, within a client, to
+// bg threads. The same partitioning is applied to both, with N being the
+// number of servers or of bg threads respectively.
+enum RowPartitionType {
+  // row_id % N.
+  ModuloPartition = 0,
+
+  // Hash of (table_id, row_id) % N. Breaks up strided row ids and keeps the
+  // same (e.g. hot) row id of different tables on different servers.
+  HashPartition = 1,
+
+  // Row ids in [0, TableInfo::row_partition_range) are split into N
+  // contiguous ranges of equal size; larger row ids go to the last one.
+  RangePartition = 2,
+
+  // TableInfo::row_partition_func.
+  CustomPartition = 3
+};
+
+// How the oplogs sent to servers and the rows pushed by servers are encoded
+// on the wire.
+enum MsgCodec {
+  // Raw int32 row and column ids and raw updates and row data.
+  RawCodec = 0,
+
+  // Row and column ids are delta and varint encoded, updates of all zero
+  // bytes are dropped, and the remaining updates and pushed rows are
+  // compressed by eliding runs of zero bytes. Dropping zero updates requires
+  // an update of all zero bytes to be a no-op, which holds for the built-in
+  // row types.
+  CompactCodec = 1
+};
+
+// Precision of the updates in the oplogs sent to servers, for tables whose
+// updates are float (e.g. DenseRow<float>). Lower precisions scale the
+// updates of each row by its largest magnitude before rounding them. The
+// rounding error of a row is kept in the client's oplog and sent with the
+// row's next update, so the accumulated updates are not biased.
+enum UpdatePrecision {
+  FullPrecision = 0,
+
+  // IEEE 754 half precision.
+  HalfPrecision = 1,
+
+  // Signed 8-bit integers.
+  Int8Precision = 2
+};
+
+// Return the partition in [0, num_partitions) row_id of table_id belongs
+// to. Must be deterministic and the same on every process.
+typedef int32_t (*RowPartitionFunc)(int32_t table_id, int32_t row_id,
+  int32_t num_partitions);
+
 struct TableGroupConfig {
 
   TableGroupConfig():
       aggressive_clock(false),
-      aggressive_cpu(false){ }
+      aggressive_cpu(false),
+      row_migration(false),
+      row_migration_interval(10),
+      row_migration_imbalance(1.5),
+      num_server_apply_threads(1),
+      oplog_bytes_per_clock(0),
+      oplog_flush_bytes(0),
+      ipc_on_same_host(false) { }
 
   // ================= Global Parameters ===================
   // Global parameters have to be the same across all processes.
@@ -78,10 +142,60 @@ struct TableGroupConfig {
   // In Async+pushing,
   int32_t server_ring_size;
 
+  // If set to true, servers report their per-row load every
+  // row_migration_interval server clocks and the name node moves the hottest
+  // rows of the busiest server to the least busy one whenever the busiest
+  // server's load exceeds row_migration_imbalance times the mean load.
+  // Has to be the same across all processes.
+  bool row_migration;
+  int32_t row_migration_interval;
+  double row_migration_imbalance;
+
+  // Number of threads each local server thread applies oplogs with. The rows
+  // of every server table are sharded among them and each oplog message is
+  // applied by all of them in parallel before the server handles its next
+  // message. 1 applies oplogs on the server thread itself.
+  int32_t num_server_apply_threads;
+
+  // Upper bound of the oplog bytes this process sends per clock, split
+  // evenly among its bg threads. Rows with the largest update magnitude are
+  // sent first and the others stay in the oplog for later clocks, but no
+  // row is held back for more than staleness / 2 clocks of its table. To
+  // keep the staleness bound, a nonzero value makes every table read with
+  // staleness - staleness / 2 instead, so all processes must use the same
+  // value; tables with staleness below 2 are never held back. The oplog
+  // flush of TableGroup::GlobalBarrier() is not limited. 0 sends all pending
+  // oplogs at every clock.
+  size_t oplog_bytes_per_clock;
+
+  // If nonzero, an app thread that has added oplog_flush_bytes bytes of
+  // updates (4 bytes per column id plus the update size per update) to the
+  // oplog partition of a table's bg thread since that partition was last
+  // flushed by it asks the bg thread to send its pending oplogs without
+  // waiting for the clock, so that long clocks stream their updates to the
+  // servers while computing. These flushes are not limited by
+  // oplog_bytes_per_clock.
+  size_t oplog_flush_bytes;
+
+  // If set to true, processes whose host_map entries have the same ip talk
+  // through Unix domain sockets instead of loopback TCP. Only the socket
+  // type changes: messages are still copied through the kernel, there is no
+  // shared memory between the processes. Has to be the same across all
+  // processes on a host.
+  bool ipc_on_same_host;
+
 };
 
 // TableInfo is shared between client and server.
 struct TableInfo {
+  TableInfo():
+      value_bound(0),
+      row_partition_type(ModuloPartition),
+      row_partition_range(0),
+      row_partition_func(0),
+      msg_codec(RawCodec),
+      update_precision(FullPrecision) { }
+
   // table_staleness is used for SSP and ClockVAP.
   int32_t table_staleness;
 
@@ -93,10 +207,36 @@ struct TableInfo {
   // in vector-backed dense row it is the max number of columns. This
   // parameter is ignored for sparse row.
   int32_t row_capacity;
+
+  // value_bound is used for SSPPushValueBound. A server row is pushed to
+  // subscribed clients once the sum of absolute values of the updates applied
+  // to it since the last push reaches value_bound. 0 pushes every updated row.
+  double value_bound;
+
+  // Row partitioning, see RowPartitionType. Every process must create the
+  // table with the same partitioning.
+  RowPartitionType row_partition_type;
+
+  // Used by RangePartition; typically the number of rows.
+  int32_t row_partition_range;
+
+  // Used by CustomPartition.
+  RowPartitionFunc row_partition_func;
+
+  // Encoding of the table's oplog and server push messages. Every process
+  // must create the table with the same codec.
+  MsgCodec msg_codec;
+
+  // Precision of the table's oplog updates. Every process must create the
+  // table with the same precision.
+  UpdatePrecision update_precision;
 };
 
 // ClientTableConfig is used by client only.
 struct ClientTableConfig {
+  ClientTableConfig():
+      oplog_dense_index_rows(0) { }
+
   TableInfo table_info;
 
   // In # of rows.
@@ -108,6 +248,12 @@ struct ClientTableConfig {
   // Estimated upper bound # of pending oplogs in terms of # of rows. For SSP
   // this is the # of rows all threads collectively touches in a Clock().
   int32_t oplog_capacity;
+
+  // If positive, the table's row ids are in [0, oplog_dense_index_rows) and
+  // the rows with pending oplogs are indexed by a bitmap of that many bits
+  // per bg thread, which app threads set directly, instead of by hash maps.
+  // Suits tables whose rows are mostly all updated, e.g. dense matrices.
+  int32_t oplog_dense_index_rows;
 };
 
 }  // namespace petuum
@@ -5,5 +5,7 @@
 #include <petuum_ps/include/configs.hpp>
 #include <petuum_ps/storage/dense_row.hpp>
 #include <petuum_ps/storage/sparse_row.hpp>
+#include <petuum_ps/storage/flat_sparse_row.hpp>
+#include <petuum_ps/storage/hybrid_count_row.hpp>
 #include <petuum_ps/storage/sorted_vector_map_row.hpp>
 #include <petuum_ps/util/utils.hpp>
@@ -2,6 +2,7 @@
 
 #include "petuum_ps/include/abstract_row.hpp"
 #include "petuum_ps/client/client_row.hpp"
+#include "petuum_ps/util/epoch_manager.hpp"
 #include <boost/utility.hpp>
 #include <vector>
 #include <utility>
@@ -11,8 +12,11 @@ namespace petuum {
 class ProcessStorage;
 
 // RowAccessor is a "smart pointer" for ROW: row_accessor.Get() gives a const
-// reference.  We disallow copying of RowAccessor to avoid unnecessary
-// manipulation of reference count.
+// reference. While it holds a row, the owning thread stays inside an
+// EpochManager epoch, which keeps the row alive without touching any shared
+// reference count. A RowAccessor must therefore be released by the thread
+// that obtained it, and should not be held for long, as it delays the
+// reclamation of replaced and evicted rows.
 class RowAccessor : boost::noncopyable {
 public:
   RowAccessor() : client_row_ptr_(0), row_data_ptr_(0) { }
@@ -24,7 +28,7 @@ public:
   // lifetime of this RowAccessor.
   template<typename ROW>
   inline const ROW& Get() {
-    return *(dynamic_cast<ROW*>(row_data_ptr_.get()));
+    return *(dynamic_cast<ROW*>(row_data_ptr_));
   }
 
 private:
@@ -36,20 +40,20 @@ private:
 
   void Clear() {
     if (client_row_ptr_ != 0) {
-      client_row_ptr_->DecRef();
       client_row_ptr_ = 0;
-      row_data_ptr_.reset();
+      row_data_ptr_ = 0;
+      EpochManager::Exit();
     }
   }
 
-  // Does not take ownership of client_row_ptr. Note that accesses to
-  // ClientRow::SwapAndDestroy() and ClientRow::GetRowDataPtr() must be
-  // mutually exclusive as the former modifies ClientRow::row_data_pptr_.
+  // Does not take ownership of client_row_ptr. The caller must have called
+  // Clear() and then EpochManager::Enter() before looking up client_row_ptr;
+  // RowAccessor takes over that epoch and exits it in Clear(). Clearing first
+  // lets the thread leave the epoch of a previously held row, so a reused
+  // RowAccessor does not keep the thread in its first epoch.
   inline void SetClientRow(ClientRow* client_row_ptr) {
-    Clear();
     client_row_ptr_ = client_row_ptr;
-    client_row_ptr_->IncRef();
-    client_row_ptr_->GetRowDataPtr(&row_data_ptr_);
+    row_data_ptr_ = client_row_ptr_->GetRowData();
   }
 
   // Return client row which will stay alive throughout the lifetime of
@@ -59,12 +63,12 @@ private:
   }
 
   AbstractRow *GetRowData() {
-    return row_data_ptr_.get();
+    return row_data_ptr_;
   }
 
   ClientRow* client_row_ptr_;
 
-  std::shared_ptr<AbstractRow> row_data_ptr_;
+  AbstractRow *row_data_ptr_;
 };
 
 class ThreadRowAccessor : boost::noncopyable {
@@ -93,12 +93,24 @@ public:
       update_batch.GetUpdates(), update_batch.GetBatchSize());
   }
 
+  void ThreadIncRow(int32_t row_id, const UPDATE* dense_delta){
+    system_table_->ThreadIncRow(row_id, dense_delta);
+  }
+
   // row_accessor helps maintain the reference count to prevent premature
   // cache eviction. The lock
   void Get(int32_t row_id, RowAccessor* row_accessor){
     system_table_->Get(row_id, row_accessor);
   }
 
+  // Read a set of rows; rows that are missing or too stale are fetched in a
+  // single batched request. row_accessors must point to an array of
+  // row_ids.size() RowAccessors, e.g. std::vector<RowAccessor>::data().
+  void GetBatch(const std::vector<int32_t> &row_ids,
+    RowAccessor* row_accessors){
+    system_table_->GetBatch(row_ids, row_accessors);
+  }
+
   void Inc(int32_t row_id, int32_t column_id, UPDATE update){
     system_table_->Inc(row_id, column_id, &update);
   }
@@ -108,6 +120,13 @@ public:
       update_batch.GetUpdates(), update_batch.GetBatchSize());
   }
 
+  // Increment every column of a row. dense_delta points to row_capacity
+  // updates, the i-th being the update of column i. Meant for row types with
+  // dense columns such as DenseRow.
+  void IncRow(int32_t row_id, const UPDATE* dense_delta){
+    system_table_->IncRow(row_id, dense_delta);
+  }
+
   int32_t get_row_type() const {
     return system_table_->get_row_type();
   }
@@ -29,12 +29,12 @@ namespace petuum {
 class TableOpLog : boost::noncopyable {
 public:
   TableOpLog(int32_t table_id, int32_t partitioned_oplog_capacity,
-    const AbstractRow *sample_row):
+    const AbstractRow *sample_row, int32_t row_capacity):
       table_id_(table_id),
       oplog_partitions_(GlobalContext::get_num_bg_threads()) {
       for (int32_t i = 0; i < GlobalContext::get_num_bg_threads(); ++i) {
         oplog_partitions_[i] = new OpLogPartition(partitioned_oplog_capacity,
-          sample_row, table_id);
+          sample_row, table_id, row_capacity);
       }
     }
 
@@ -45,29 +45,40 @@ public:
   }
 
   void Inc(int32_t row_id, int32_t column_id, const void *delta) {
-    int32_t partition_num = GlobalContext::GetBgPartitionNum(row_id);
+    int32_t partition_num = GlobalContext::GetBgPartitionNum(table_id_,
+      row_id);
     oplog_partitions_[partition_num]->Inc(row_id, column_id, delta);
   }
 
   void BatchInc(int32_t row_id, const int32_t *column_ids, const void *deltas,
     int32_t num_updates) {
-    int32_t partition_num = GlobalContext::GetBgPartitionNum(row_id);
+    int32_t partition_num = GlobalContext::GetBgPartitionNum(table_id_,
+      row_id);
     oplog_partitions_[partition_num]->BatchInc(row_id, column_ids, deltas,
       num_updates);
   }
 
+  void IncRow(int32_t row_id, const void *deltas, int32_t num_updates) {
+    int32_t partition_num = GlobalContext::GetBgPartitionNum(table_id_,
+      row_id);
+    oplog_partitions_[partition_num]->IncRow(row_id, deltas, num_updates);
+  }
+
   bool FindOpLog(int32_t row_id, OpLogAccessor *oplog_accessor) {
-    int32_t partition_num = GlobalContext::GetBgPartitionNum(row_id);
+    int32_t partition_num = GlobalContext::GetBgPartitionNum(table_id_,
+      row_id);
     return oplog_partitions_[partition_num]->FindOpLog(row_id, oplog_accessor);
   }
 
   void FindInsertOpLog(int32_t row_id, OpLogAccessor *oplog_accessor) {
-    int32_t partition_num = GlobalContext::GetBgPartitionNum(row_id);
+    int32_t partition_num = GlobalContext::GetBgPartitionNum(table_id_,
+      row_id);
     oplog_partitions_[partition_num]->FindInsertOpLog(row_id, oplog_accessor);
   }
 
   bool GetEraseOpLog(int32_t row_id, RowOpLog **row_oplog_ptr) {
-    int32_t partition_num = GlobalContext::GetBgPartitionNum(row_id);
+    int32_t partition_num = GlobalContext::GetBgPartitionNum(table_id_,
+      row_id);
     return oplog_partitions_[partition_num]->GetEraseOpLog(row_id,
                                                           row_oplog_ptr);
   }
@@ -75,7 +86,8 @@ public:
   bool GetEraseOpLogIf(int32_t row_id,
                        OpLogPartition::GetOpLogTestFunc test,
                        void *test_args, RowOpLog **row_oplog_ptr) {
-    int32_t partition_num = GlobalContext::GetBgPartitionNum(row_id);
+    int32_t partition_num = GlobalContext::GetBgPartitionNum(table_id_,
+      row_id);
     return oplog_partitions_[partition_num]->GetEraseOpLogIf(row_id, test,
                                                             test_args,
                                                             row_oplog_ptr);
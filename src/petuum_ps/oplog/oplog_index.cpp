@@ -1,5 +1,6 @@
 
 #include "petuum_ps/oplog/oplog_index.hpp"
+#include <utility>
 
 namespace petuum {
 
@@ -7,19 +8,22 @@ PartitionOpLogIndex::PartitionOpLogIndex(size_t capacity):
     capacity_(capacity),
     locks_(GlobalContext::get_lock_pool_size()),
     shared_oplog_index_(new cuckoohash_map<int32_t, bool>
+                    (capacity*GlobalContext::get_cuckoo_expansion_factor())),
+    reset_oplog_index_(new cuckoohash_map<int32_t, bool>
                     (capacity*GlobalContext::get_cuckoo_expansion_factor())){ }
 
 PartitionOpLogIndex::~PartitionOpLogIndex() {
   delete shared_oplog_index_;
+  delete reset_oplog_index_;
 }
 
-PartitionOpLogIndex::PartitionOpLogIndex(PartitionOpLogIndex && other) {
-  cuckoohash_map<int32_t, bool> *tmp_index_ptr = shared_oplog_index_;
-  size_t tmp_capacity = capacity_;
-  shared_oplog_index_ = other.shared_oplog_index_;
-  other.shared_oplog_index_ = tmp_index_ptr;
-  capacity_ = other.capacity_;
-  other.capacity_ = tmp_capacity;
+PartitionOpLogIndex::PartitionOpLogIndex(PartitionOpLogIndex && other):
+    capacity_(other.capacity_),
+    locks_(GlobalContext::get_lock_pool_size()),
+    shared_oplog_index_(other.shared_oplog_index_),
+    reset_oplog_index_(other.reset_oplog_index_) {
+  other.shared_oplog_index_ = 0;
+  other.reset_oplog_index_ = 0;
 }
 
 void PartitionOpLogIndex::AddIndex(const boost::unordered_map<int32_t, bool>
@@ -33,18 +37,58 @@ void PartitionOpLogIndex::AddIndex(const boost::unordered_map<int32_t, bool>
   smtx_.unlock_shared();
 }
 
-cuckoohash_map<int32_t, bool> *PartitionOpLogIndex::Reset() {
+void PartitionOpLogIndex::Reset(std::vector<int32_t> *row_ids) {
+  reset_oplog_index_->clear();
   smtx_.lock();
-  cuckoohash_map<int32_t, bool> *old_index = shared_oplog_index_;
-  shared_oplog_index_ = new cuckoohash_map<int32_t, bool>
-                    (capacity_*GlobalContext::get_cuckoo_expansion_factor());
+  std::swap(shared_oplog_index_, reset_oplog_index_);
   smtx_.unlock();
-  return old_index;
+
+  row_ids->clear();
+  for (auto iter = reset_oplog_index_->cbegin(); !iter.is_end(); iter++) {
+    row_ids->push_back(iter->first);
+  }
+}
+
+DenseOpLogIndex::DenseOpLogIndex(int32_t num_rows):
+    num_rows_(num_rows),
+    num_words_((num_rows + 63) / 64),
+    words_(new std::atomic<uint64_t>[num_words_]) {
+  for (int32_t i = 0; i < num_words_; ++i) {
+    words_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+DenseOpLogIndex::~DenseOpLogIndex() {
+  delete[] words_;
+}
+
+void DenseOpLogIndex::Reset(std::vector<int32_t> *row_ids) {
+  row_ids->clear();
+  for (int32_t i = 0; i < num_words_; ++i) {
+    if (words_[i].load(std::memory_order_relaxed) == 0)
+      continue;
+    // Bits set after the exchange are read by the next Reset().
+    uint64_t word = words_[i].exchange(0, std::memory_order_acquire);
+    while (word != 0) {
+      row_ids->push_back(i*64 + __builtin_ctzll(word));
+      word &= word - 1;
+    }
+  }
 }
 
-TableOpLogIndex::TableOpLogIndex(size_t capacity) {
+TableOpLogIndex::TableOpLogIndex(size_t capacity, int32_t dense_num_rows) {
   for (int32_t i = 0; i < GlobalContext::get_num_bg_threads(); ++i) {
-    partition_oplog_index_.emplace_back(capacity);
+    if (dense_num_rows > 0)
+      dense_oplog_index_.push_back(new DenseOpLogIndex(dense_num_rows));
+    else
+      partition_oplog_index_.emplace_back(capacity);
+  }
+}
+
+TableOpLogIndex::~TableOpLogIndex() {
+  for (auto iter = dense_oplog_index_.begin();
+       iter != dense_oplog_index_.end(); iter++) {
+    delete *iter;
   }
 }
 
@@ -54,9 +98,27 @@ void TableOpLogIndex::AddIndex(int32_t partition_num,
   partition_oplog_index_[partition_num].AddIndex(oplog_index);
 }
 
-cuckoohash_map<int32_t, bool> *TableOpLogIndex::ResetPartition(
-    int32_t partition_num) {
-  return partition_oplog_index_[partition_num].Reset();
+void TableOpLogIndex::AddIndex(int32_t partition_num,
+                               const std::vector<int32_t> &row_ids) {
+  if (is_dense()) {
+    for (auto iter = row_ids.cbegin(); iter != row_ids.cend(); iter++) {
+      dense_oplog_index_[partition_num]->AddIndex(*iter);
+    }
+    return;
+  }
+  boost::unordered_map<int32_t, bool> oplog_index;
+  for (auto iter = row_ids.cbegin(); iter != row_ids.cend(); iter++) {
+    oplog_index[*iter] = true;
+  }
+  partition_oplog_index_[partition_num].AddIndex(oplog_index);
+}
+
+void TableOpLogIndex::ResetPartition(int32_t partition_num,
+                                     std::vector<int32_t> *row_ids) {
+  if (is_dense())
+    dense_oplog_index_[partition_num]->Reset(row_ids);
+  else
+    partition_oplog_index_[partition_num].Reset(row_ids);
 }
 
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <atomic>
 #include <libcuckoo/cuckoohash_map.hh>
 #include <boost/unordered_map.hpp>
 #include <stdint.h>
@@ -17,21 +18,66 @@ public:
   PartitionOpLogIndex(PartitionOpLogIndex && other);
   ~PartitionOpLogIndex();
   void AddIndex(const boost::unordered_map<int32_t, bool> &oplog_index);
-  cuckoohash_map<int32_t, bool> *Reset();
+  // Set row_ids to the rows indexed since the last Reset(). The index is
+  // double buffered so that Reset() reuses the map it swapped out last time.
+  void Reset(std::vector<int32_t> *row_ids);
 private:
   size_t capacity_;
   SharedMutex smtx_;
   StripedLock<int32_t> locks_;
   cuckoohash_map<int32_t, bool> *shared_oplog_index_;
+  // Swapped out by the last Reset().
+  cuckoohash_map<int32_t, bool> *reset_oplog_index_;
+};
+
+// Index of a partition of a table whose row ids are in [0, num_rows), one
+// bit per row. App threads set bits without locking and Reset() clears the
+// words it reads, so it costs a word per 64 rows.
+class DenseOpLogIndex : boost::noncopyable {
+public:
+  explicit DenseOpLogIndex(int32_t num_rows);
+  ~DenseOpLogIndex();
+
+  void AddIndex(int32_t row_id) {
+    CHECK(row_id >= 0 && row_id < num_rows_) << "row_id = " << row_id
+      << " is out of the dense oplog index range [0, " << num_rows_ << ")";
+    std::atomic<uint64_t> &word = words_[row_id >> 6];
+    uint64_t mask = static_cast<uint64_t>(1) << (row_id & 63);
+    // Rows are mostly updated many times per clock.
+    if ((word.load(std::memory_order_relaxed) & mask) == 0)
+      word.fetch_or(mask, std::memory_order_release);
+  }
+
+  // Set row_ids to the rows indexed since the last Reset().
+  void Reset(std::vector<int32_t> *row_ids);
+
+private:
+  int32_t num_rows_;
+  int32_t num_words_;
+  std::atomic<uint64_t> *words_;
 };
 
 class TableOpLogIndex : boost::noncopyable{
 public:
-  explicit TableOpLogIndex(size_t capacity);
+  // If dense_num_rows is positive, row ids are in [0, dense_num_rows) and
+  // each partition is indexed by a DenseOpLogIndex.
+  TableOpLogIndex(size_t capacity, int32_t dense_num_rows);
+  ~TableOpLogIndex();
   void AddIndex(int32_t partition_num,
                 const boost::unordered_map<int32_t, bool> &oplog_index);
-  cuckoohash_map<int32_t, bool> *ResetPartition(int32_t partition_num);
+  // Index rows of partition_num whose oplogs were not updated by app threads.
+  void AddIndex(int32_t partition_num, const std::vector<int32_t> &row_ids);
+  bool is_dense() const {
+    return !dense_oplog_index_.empty();
+  }
+  // Only for dense indexes.
+  void AddDenseIndex(int32_t partition_num, int32_t row_id) {
+    dense_oplog_index_[partition_num]->AddIndex(row_id);
+  }
+  // Set row_ids to the rows of partition_num indexed since its last reset.
+  void ResetPartition(int32_t partition_num, std::vector<int32_t> *row_ids);
 private:
   std::vector<PartitionOpLogIndex> partition_oplog_index_;
+  std::vector<DenseOpLogIndex*> dense_oplog_index_;
 };
 }
@@ -4,12 +4,13 @@
 namespace petuum {
 
 OpLogPartition::OpLogPartition(int capacity, const AbstractRow *sample_row,
-                               int32_t table_id):
+                               int32_t table_id, int32_t row_capacity):
   update_size_(sample_row->get_update_size()),
   locks_(GlobalContext::get_lock_pool_size()),
   oplog_map_(capacity * GlobalContext::get_cuckoo_expansion_factor()),
   sample_row_(sample_row),
-  table_id_(table_id) { }
+  table_id_(table_id),
+  row_capacity_(row_capacity) { }
 
 OpLogPartition::~OpLogPartition() {
   cuckoohash_map<int32_t, RowOpLog* >::iterator iter = oplog_map_.begin();
@@ -22,7 +23,7 @@ void OpLogPartition::Inc(int32_t row_id, int32_t column_id, const void *delta) {
   locks_.Lock(row_id);
   RowOpLog *row_oplog = 0;
   if(!oplog_map_.find(row_id, row_oplog)){
-    row_oplog = new RowOpLog(update_size_, sample_row_);
+    row_oplog = CreateRowOpLog(update_size_, sample_row_, row_capacity_);
     oplog_map_.insert(row_id, row_oplog);
   }
 
@@ -36,7 +37,7 @@ void OpLogPartition::BatchInc(int32_t row_id, const int32_t *column_ids,
   locks_.Lock(row_id);
   RowOpLog *row_oplog = 0;
   if(!oplog_map_.find(row_id, row_oplog)){
-    row_oplog = new RowOpLog(update_size_, sample_row_);
+    row_oplog = CreateRowOpLog(update_size_, sample_row_, row_capacity_);
     oplog_map_.insert(row_id, row_oplog);
   }
 
@@ -50,6 +51,19 @@ void OpLogPartition::BatchInc(int32_t row_id, const int32_t *column_ids,
   locks_.Unlock(row_id);
 }
 
+void OpLogPartition::IncRow(int32_t row_id, const void *deltas,
+  int32_t num_updates) {
+  locks_.Lock(row_id);
+  RowOpLog *row_oplog = 0;
+  if(!oplog_map_.find(row_id, row_oplog)){
+    row_oplog = CreateRowOpLog(update_size_, sample_row_, row_capacity_);
+    oplog_map_.insert(row_id, row_oplog);
+  }
+
+  row_oplog->IncRow(deltas, num_updates);
+  locks_.Unlock(row_id);
+}
+
 bool OpLogPartition::FindOpLog(int32_t row_id, OpLogAccessor *oplog_accessor) {
   locks_.Lock(row_id, oplog_accessor->get_unlock_ptr());
   RowOpLog *row_oplog;
@@ -67,7 +81,7 @@ void OpLogPartition::FindInsertOpLog(int32_t row_id,
   locks_.Lock(row_id, oplog_accessor->get_unlock_ptr());
   RowOpLog *row_oplog;
   if (!oplog_map_.find(row_id, row_oplog)) {
-    row_oplog = new RowOpLog(update_size_, sample_row_);
+    row_oplog = CreateRowOpLog(update_size_, sample_row_, row_capacity_);
     oplog_map_.insert(row_id, row_oplog);
   }
   oplog_accessor->set_row_oplog(row_oplog);
@@ -84,7 +98,7 @@ RowOpLog *OpLogPartition::FindOpLog(int row_id) {
 RowOpLog *OpLogPartition::FindInsertOpLog(int row_id) {
   RowOpLog *row_oplog;
   if (!oplog_map_.find(row_id, row_oplog)) {
-    row_oplog = new RowOpLog(update_size_, sample_row_);
+    row_oplog = CreateRowOpLog(update_size_, sample_row_, row_capacity_);
     oplog_map_.insert(row_id, row_oplog);
   }
   return row_oplog;
@@ -53,13 +53,15 @@ class OpLogPartition : boost::noncopyable {
 public:
   OpLogPartition();
   OpLogPartition(int32_t capacity, const AbstractRow *sample_row,
-                 int32_t table_id);
+                 int32_t table_id, int32_t row_capacity);
   ~OpLogPartition();
 
   // exclusive access
   void Inc(int32_t row_id, int32_t column_id, const void *delta);
   void BatchInc(int32_t row_id, const int32_t *column_ids,
     const void *deltas, int32_t num_updates);
+  // deltas holds the updates of columns 0 to num_updates - 1.
+  void IncRow(int32_t row_id, const void *deltas, int32_t num_updates);
 
   // Guaranteed exclusive accesses to the same row id.
   bool FindOpLog(int32_t row_id, OpLogAccessor *oplog_accessor);
@@ -81,6 +83,7 @@ private:
   cuckoohash_map<int32_t,  RowOpLog*> oplog_map_;
   const AbstractRow *sample_row_;
   int32_t table_id_;
+  int32_t row_capacity_;
 };
 
 }   // namespace petuum
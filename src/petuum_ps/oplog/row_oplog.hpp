@@ -2,22 +2,49 @@
 #pragma once
 
 #include <stdint.h>
+#include <vector>
 #include <boost/unordered_map.hpp>
+#include <boost/noncopyable.hpp>
 
 #include "petuum_ps/include/abstract_row.hpp"
 
 namespace petuum {
 
+// Pending updates of one row, keyed by column id. Each update is
+// update_size bytes and is initialized by sample_row->InitUpdate().
 class RowOpLog : boost::noncopyable {
 public:
-  RowOpLog(uint32_t update_size, const AbstractRow *sample_row):
+  virtual ~RowOpLog() { }
+
+  // Return 0 if column col_id has no pending update.
+  virtual void* Find(int32_t col_id) = 0;
+
+  virtual void* FindCreate(int32_t col_id) = 0;
+
+  // Add deltas[i] to the update of column i, for i in [0, num_updates).
+  virtual void IncRow(const void *deltas, int32_t num_updates) = 0;
+
+  // Iterate over the pending updates. Return 0 at the end.
+  virtual void* BeginIterate(int32_t *column_id) = 0;
+
+  virtual void* Next(int32_t *column_id) = 0;
+
+  // Number of columns that have a pending update.
+  virtual int32_t GetSize() = 0;
+};
+
+// Keeps each column's update in a separately allocated buffer. Works for
+// any row type.
+class MapRowOpLog : public RowOpLog {
+public:
+  MapRowOpLog(uint32_t update_size, const AbstractRow *sample_row):
     update_size_(update_size),
     sample_row_(sample_row) { }
 
-  ~RowOpLog() {
+  ~MapRowOpLog() {
     boost::unordered_map<int32_t, void*>::iterator iter = oplogs_.begin();
     for (; iter != oplogs_.end(); iter++) {
-      delete reinterpret_cast<uint8_t*>(iter->second);
+      delete[] reinterpret_cast<uint8_t*>(iter->second);
     }
   }
 
@@ -42,6 +69,14 @@ public:
     return iter->second;
   }
 
+  void IncRow(const void *deltas, int32_t num_updates) {
+    const uint8_t *deltas_uint8 = reinterpret_cast<const uint8_t*>(deltas);
+    for (int32_t i = 0; i < num_updates; ++i) {
+      sample_row_->AddUpdates(i, FindCreate(i),
+                              deltas_uint8 + update_size_*i);
+    }
+  }
+
   void* BeginIterate(int32_t *column_id) {
     iter_ = oplogs_.begin();
     if (iter_ == oplogs_.end()) {
@@ -70,4 +105,123 @@ private:
   const AbstractRow *sample_row_;
   boost::unordered_map<int32_t, void*>::iterator iter_;
 };
+
+// Keeps the updates of a row with a fixed number of columns in one
+// contiguous array, update_size*capacity bytes, and marks the touched
+// columns in a bitmap. Column ids must be in [0, capacity). Iteration is in
+// increasing column id order.
+class DenseRowOpLog : public RowOpLog {
+public:
+  DenseRowOpLog(uint32_t update_size, const AbstractRow *sample_row,
+                int32_t capacity):
+    update_size_(update_size),
+    sample_row_(sample_row),
+    capacity_(capacity),
+    oplogs_(new uint8_t[update_size*capacity]),
+    touched_((capacity + kBitsPerWord - 1) / kBitsPerWord, 0),
+    num_touched_(0),
+    iter_col_(0) { }
+
+  ~DenseRowOpLog() {
+    delete[] oplogs_;
+  }
+
+  void* Find(int32_t col_id) {
+    if (!IsTouched(col_id))
+      return 0;
+    return oplogs_ + update_size_*col_id;
+  }
+
+  void* FindCreate(int32_t col_id) {
+    void *update = oplogs_ + update_size_*col_id;
+    if (!IsTouched(col_id)) {
+      touched_[col_id / kBitsPerWord]
+          |= (uint64_t(1) << (col_id % kBitsPerWord));
+      ++num_touched_;
+      sample_row_->InitUpdate(col_id, update);
+    }
+    return update;
+  }
+
+  void IncRow(const void *deltas, int32_t num_updates) {
+    for (int32_t i = 0; i < num_updates; ++i) {
+      if (!IsTouched(i))
+        sample_row_->InitUpdate(i, oplogs_ + update_size_*i);
+    }
+    SetTouched(num_updates);
+    sample_row_->AddDenseUpdates(oplogs_, deltas, num_updates);
+  }
+
+  void* BeginIterate(int32_t *column_id) {
+    iter_col_ = -1;
+    return Next(column_id);
+  }
+
+  void* Next(int32_t *column_id) {
+    int32_t col_id = iter_col_ + 1;
+    size_t word_idx = col_id / kBitsPerWord;
+    if (word_idx >= touched_.size())
+      return 0;
+    uint64_t word = touched_[word_idx] >> (col_id % kBitsPerWord);
+    if (word == 0) {
+      do {
+        ++word_idx;
+        if (word_idx >= touched_.size())
+          return 0;
+      } while (touched_[word_idx] == 0);
+      word = touched_[word_idx];
+      col_id = word_idx * kBitsPerWord;
+    }
+    col_id += __builtin_ctzll(word);
+    iter_col_ = col_id;
+    *column_id = col_id;
+    return oplogs_ + update_size_*col_id;
+  }
+
+  int32_t GetSize(){
+    return num_touched_;
+  }
+
+private:
+  static const int32_t kBitsPerWord = 64;
+
+  bool IsTouched(int32_t col_id) const {
+    return (touched_[col_id / kBitsPerWord]
+            >> (col_id % kBitsPerWord)) & uint64_t(1);
+  }
+
+  // Mark columns [0, num_cols) as touched.
+  void SetTouched(int32_t num_cols) {
+    int32_t num_full_words = num_cols / kBitsPerWord;
+    for (int32_t i = 0; i < num_full_words; ++i)
+      touched_[i] = ~uint64_t(0);
+    int32_t num_rest = num_cols % kBitsPerWord;
+    if (num_rest > 0)
+      touched_[num_full_words] |= (uint64_t(1) << num_rest) - 1;
+
+    num_touched_ = 0;
+    for (size_t i = 0; i < touched_.size(); ++i)
+      num_touched_ += __builtin_popcountll(touched_[i]);
+  }
+
+  uint32_t update_size_;
+  const AbstractRow *sample_row_;
+  int32_t capacity_;
+  uint8_t *oplogs_;
+  std::vector<uint64_t> touched_;
+  int32_t num_touched_;
+  int32_t iter_col_;
+};
+
+// Choose the RowOpLog implementation by row type: rows that report dense
+// updates (AbstractRow::HasDenseUpdates()) get a DenseRowOpLog of
+// row_capacity columns, others a MapRowOpLog.
+inline RowOpLog *CreateRowOpLog(uint32_t update_size,
+                                const AbstractRow *sample_row,
+                                int32_t row_capacity) {
+  if (sample_row->HasDenseUpdates() && row_capacity > 0)
+    return new DenseRowOpLog(update_size, sample_row, row_capacity);
+  return new MapRowOpLog(update_size, sample_row);
+}
+
 }
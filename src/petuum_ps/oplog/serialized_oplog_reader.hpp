@@ -1,6 +1,14 @@
 // author: jinliang
 
 #include <boost/noncopyable.hpp>
+#include <boost/shared_array.hpp>
+#include <vector>
+#include <map>
+#include <string.h>
+
+#include "petuum_ps/thread/context.hpp"
+#include "petuum_ps/thread/msg_codec.hpp"
+#include "petuum_ps/thread/update_quantizer.hpp"
 
 namespace petuum {
 
@@ -13,16 +21,24 @@ namespace petuum {
 // 2. int32_t : table id
 // 3. size_t : update_size for this table
 // 4. serialized table, details in oplog_partition
+// Rows of tables with CompactCodec are encoded by MsgCompressor and rows of
+// tables with a quantized UpdatePrecision carry quantized updates
+// (UpdateQuantizer); Next() decodes both to float updates.
 
 class SerializedOpLogReader : boost::noncopyable {
 public:
   // does not take ownership
   SerializedOpLogReader(const void *oplog_ptr):
-    serialized_oplog_ptr_(reinterpret_cast<const uint8_t*>(oplog_ptr)) { }
+    serialized_oplog_ptr_(reinterpret_cast<const uint8_t*>(oplog_ptr)),
+    decoded_block_offset_(0),
+    decoded_block_size_(0) { }
   ~SerializedOpLogReader() {}
 
   bool Restart() {
     offset_ = 0;
+    decoded_blocks_.clear();
+    decoded_block_offset_ = 0;
+    decoded_block_size_ = 0;
     num_tables_left_ =
       *(reinterpret_cast<const int32_t*>(serialized_oplog_ptr_ + offset_));
     offset_ += sizeof(int32_t);
@@ -34,6 +50,9 @@ public:
     return true;
   }
 
+  // The returned updates and column_ids stay valid until Restart() or
+  // destruction, also for decoded rows, so that a whole message can be read
+  // before its updates are applied.
   const void *Next(int32_t *table_id, int32_t *row_id,
     int32_t const ** column_ids, int32_t *num_updates,
     bool *started_new_table) {
@@ -45,6 +64,10 @@ public:
       // can read from current row
       if (num_rows_left_in_current_table_ > 0) {
         *table_id = current_table_id_;
+        if (current_table_encoded_) {
+          --num_rows_left_in_current_table_;
+          return NextEncoded(row_id, column_ids, num_updates);
+        }
         *row_id = *(reinterpret_cast<const int32_t*>(serialized_oplog_ptr_
           + offset_));
         offset_ += sizeof(int32_t);
@@ -74,6 +97,11 @@ public:
     }
   }
 
+  // Update size of the table that the last Next() read from.
+  size_t get_update_size() const {
+    return update_size_;
+  }
+
 private:
   void StartNewTable() {
     current_table_id_ = *(reinterpret_cast<const int32_t*>(serialized_oplog_ptr_
@@ -88,14 +116,99 @@ private:
       *(reinterpret_cast<const int32_t*>(serialized_oplog_ptr_ + offset_));
     offset_ += sizeof(int32_t);
 
+    current_table_codec_ = GlobalContext::GetTableMsgCodec(current_table_id_);
+    current_table_precision_ = GlobalContext::GetTableUpdatePrecision(
+        current_table_id_);
+    current_table_encoded_ = (current_table_codec_ == CompactCodec
+                              || current_table_precision_ != FullPrecision);
+    prev_row_id_ = 0;
+
     VLOG(0) << "current_table_id = " << current_table_id_
 	    << " update_size = " << update_size_
 	    << " rows_left_in_current_table_ = "
 	    << num_rows_left_in_current_table_;
   }
 
+  const void *NextEncoded(int32_t *row_id, int32_t const ** column_ids,
+    int32_t *num_updates) {
+    bool quantized = (current_table_precision_ != FullPrecision);
+    const uint8_t *mem = serialized_oplog_ptr_ + offset_;
+    const void *updates;
+    if (current_table_codec_ == CompactCodec) {
+      mem = reinterpret_cast<const uint8_t*>(
+          MsgCompressor::DecodeRowOpLogHeader(mem, prev_row_id_, row_id,
+                                              num_updates));
+      prev_row_id_ = *row_id;
+      int32_t *decoded_column_ids = reinterpret_cast<int32_t*>(
+          AllocDecoded(sizeof(int32_t)*(*num_updates)));
+      size_t updates_size;
+      void *decoded_updates;
+      if (quantized) {
+        updates_size = UpdateQuantizer::GetQuantizedSize(
+            current_table_precision_, *num_updates);
+        quantized_updates_.resize(updates_size);
+        decoded_updates = quantized_updates_.data();
+      } else {
+        updates_size = update_size_*(*num_updates);
+        decoded_updates = AllocDecoded(updates_size);
+      }
+      mem = reinterpret_cast<const uint8_t*>(
+          MsgCompressor::DecodeRowOpLogUpdates(mem, *num_updates,
+            updates_size, decoded_column_ids, decoded_updates));
+      *column_ids = decoded_column_ids;
+      updates = decoded_updates;
+    } else {
+      *row_id = *(reinterpret_cast<const int32_t*>(mem));
+      mem += sizeof(int32_t);
+      *num_updates = *(reinterpret_cast<const int32_t*>(mem));
+      mem += sizeof(int32_t);
+      *column_ids = reinterpret_cast<const int32_t*>(mem);
+      mem += sizeof(int32_t)*(*num_updates);
+      updates = mem;
+      mem += UpdateQuantizer::GetQuantizedSize(current_table_precision_,
+                                               *num_updates);
+    }
+    offset_ = mem - serialized_oplog_ptr_;
+
+    if (quantized) {
+      float *dequantized = reinterpret_cast<float*>(
+          AllocDecoded(sizeof(float)*(*num_updates)));
+      UpdateQuantizer::Dequantize(current_table_precision_, updates,
+                                  *num_updates, dequantized);
+      updates = dequantized;
+    }
+    return updates;
+  }
+
+  // Allocate size bytes, aligned to 8 bytes, from the decoded blocks.
+  uint8_t *AllocDecoded(size_t size) {
+    size = (size + 7) & ~static_cast<size_t>(7);
+    if (decoded_block_offset_ + size > decoded_block_size_) {
+      decoded_block_size_ = size > kDecodedBlockSize ? size
+          : kDecodedBlockSize;
+      decoded_blocks_.push_back(boost::shared_array<uint8_t>(
+          new uint8_t[decoded_block_size_]));
+      decoded_block_offset_ = 0;
+    }
+    uint8_t *mem = decoded_blocks_.back().get() + decoded_block_offset_;
+    decoded_block_offset_ += size;
+    return mem;
+  }
+
+  static const size_t kDecodedBlockSize = 64*1024;
+
   const uint8_t *serialized_oplog_ptr_;
   size_t update_size_;
+  MsgCodec current_table_codec_;
+  UpdatePrecision current_table_precision_;
+  // The table's rows are read by NextEncoded().
+  bool current_table_encoded_;
+  // Quantized updates of the encoded row being decoded.
+  std::vector<uint8_t> quantized_updates_;
+  int32_t prev_row_id_;
+  std::vector<boost::shared_array<uint8_t> > decoded_blocks_;
+  size_t decoded_block_offset_;
+  size_t decoded_block_size_;
   int32_t offset_; // bytes to be read next
   int32_t num_tables_left_; // number of tables that I have not finished
                             //reading (might have started)
@@ -137,6 +250,25 @@ public:
     return mem_ + offset_map_[table_id];
   }
 
+  // table_size_map gives the number of bytes actually written for each
+  // table, at most the size passed to Init() (encoded and quantized tables
+  // are smaller than their bound). Move the tables to be contiguous and return
+  // the total size.
+  size_t Compact(const std::map<int32_t, size_t> &table_size_map) {
+    size_t total_size = sizeof(int32_t);
+    for (auto iter = table_size_map.cbegin(); iter != table_size_map.cend();
+         iter++) {
+      size_t table_size = iter->second + sizeof(int32_t) + sizeof(size_t);
+      size_t offset = offset_map_[iter->first];
+      if (offset != total_size) {
+        memmove(mem_ + total_size, mem_ + offset, table_size);
+        offset_map_[iter->first] = total_size;
+      }
+      total_size += table_size;
+    }
+    return total_size;
+  }
+
 private:
   std::map<int32_t, size_t> offset_map_;
   uint8_t *mem_;
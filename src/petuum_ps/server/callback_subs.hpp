@@ -35,9 +35,13 @@ public:
     return bit_changed;
   }
 
+  bool IsSubscribed(int32_t client_id) const {
+    return subscriptions_.test(client_id);
+  }
+
   bool AppendRowToBuffs(int32_t client_id_st,
     boost::unordered_map<int32_t, RecordBuff> *buffs,
-    const void *row_data, size_t row_size, int32_t row_id,
+    const void *row_data, size_t row_size, int32_t table_id, int32_t row_id,
     int32_t *failed_bg_id, int32_t *failed_client_id) {
     // Some simple tests show that iterating bitset isn't too bad.
     // For bitset size below 512, it takes 200~300 ns on an Intel i5 CPU.
@@ -49,7 +53,8 @@ public:
       if (subscriptions_.test(client_id)) {
         //VLOG(0) << "Append to client " << client_id;
         head_bg_id = GlobalContext::get_head_bg_id(client_id);
-        bg_id = head_bg_id + GlobalContext::GetBgPartitionNum(row_id);
+        bg_id = head_bg_id + GlobalContext::GetBgPartitionNum(table_id,
+                                                              row_id);
         //VLOG(0) << "Append to bg " << bg_id
         //      << " (*buffs).size() = " << (*buffs).size();
         bool suc = (*buffs)[bg_id].Append(row_id, row_data, row_size);
@@ -162,21 +162,35 @@ void NameNodeThread::SendCreatedAllTablesMsg() {
 bool NameNodeThread::HandleShutDownMsg(){
   // When num_shutdown_bgs reaches the total number of bg threads, the server
   // reply to each bg with a ShutDownReply message
-  int32_t &num_shutdown_bgs = name_node_context_->num_shutdown_bgs_;
-  ++num_shutdown_bgs;
-  if(num_shutdown_bgs == GlobalContext::get_num_total_bg_threads()){
-    ServerShutDownAckMsg shut_down_ack_msg;
-    size_t msg_size = shut_down_ack_msg.get_size();
-    int i;
-    for(i = 0; i < GlobalContext::get_num_total_bg_threads(); ++i){
-      int32_t bg_id = name_node_context_->bg_thread_ids_[i];
-      size_t sent_size = (comm_bus_->*CommBusSendAny)(bg_id,
-        shut_down_ack_msg.get_mem(), msg_size);
-      CHECK_EQ(msg_size, sent_size);
-    }
-    return true;
+  ++(name_node_context_->num_shutdown_bgs_);
+  return CheckShutDown();
+}
+
+bool NameNodeThread::CheckShutDown() {
+  if (name_node_context_->num_shutdown_bgs_
+      < GlobalContext::get_num_total_bg_threads())
+    return false;
+
+  ServerShutDownAckMsg shut_down_ack_msg;
+  size_t msg_size = shut_down_ack_msg.get_size();
+  if (GlobalContext::get_row_migration()) {
+    // Servers wait for the name node so that they keep serving a migration
+    // that is in progress.
+    if (name_node_context_->num_shutdown_servers_
+        < GlobalContext::get_num_servers()
+        || name_node_context_->row_migrating_)
+      return false;
+    SendToAllServers(shut_down_ack_msg.get_mem(), msg_size);
+  }
+
+  int i;
+  for(i = 0; i < GlobalContext::get_num_total_bg_threads(); ++i){
+    int32_t bg_id = name_node_context_->bg_thread_ids_[i];
+    size_t sent_size = (comm_bus_->*CommBusSendAny)(bg_id,
+      shut_down_ack_msg.get_mem(), msg_size);
+    CHECK_EQ(msg_size, sent_size);
   }
-  return false;
+  return true;
 }
 
 void NameNodeThread::HandleCreateTable(int32_t sender_id,
@@ -190,6 +204,7 @@ void NameNodeThread::HandleCreateTable(int32_t sender_id,
     table_info.table_staleness = create_table_msg.get_staleness();
     table_info.row_type = create_table_msg.get_row_type();
     table_info.row_capacity = create_table_msg.get_row_capacity();
+    table_info.value_bound = create_table_msg.get_value_bound();
     name_node_context_->server_obj_.CreateTable(table_id, table_info);
 
     create_table_map[table_id]; // access it to call default constructor
@@ -234,11 +249,88 @@ void NameNodeThread::HandleCreateTableReply(
   }
 }
 
+void NameNodeThread::HandleServerLoadReport(int32_t server_id,
+  ServerLoadReportMsg &load_report_msg) {
+  ServerLoad &server_load = name_node_context_->server_loads_[server_id];
+  server_load.total_load = load_report_msg.get_total_load();
+  server_load.hot_rows.clear();
+  const int32_t *data = load_report_msg.get_data();
+  for (int32_t i = 0; i < load_report_msg.get_num_rows(); ++i) {
+    server_load.hot_rows.push_back({data[3*i], data[3*i + 1], data[3*i + 2]});
+  }
+
+  if ((int32_t) name_node_context_->server_loads_.size()
+      == GlobalContext::get_num_servers()) {
+    MigrateHotRows();
+    name_node_context_->server_loads_.clear();
+  }
+}
+
+void NameNodeThread::MigrateHotRows() {
+  if (name_node_context_->row_migrating_
+      || name_node_context_->num_shutdown_bgs_ > 0
+      || GlobalContext::get_num_servers() < 2)
+    return;
+
+  std::map<int32_t, ServerLoad> &server_loads
+      = name_node_context_->server_loads_;
+  int64_t total_load = 0;
+  auto busiest_iter = server_loads.begin();
+  auto idlest_iter = server_loads.begin();
+  for (auto load_iter = server_loads.begin(); load_iter != server_loads.end();
+       load_iter++) {
+    total_load += load_iter->second.total_load;
+    if (load_iter->second.total_load > busiest_iter->second.total_load)
+      busiest_iter = load_iter;
+    if (load_iter->second.total_load < idlest_iter->second.total_load)
+      idlest_iter = load_iter;
+  }
+  double mean_load = static_cast<double>(total_load)
+                     / GlobalContext::get_num_servers();
+  if (busiest_iter->second.total_load
+      <= GlobalContext::get_row_migration_imbalance()*mean_load)
+    return;
+
+  // Move at most half of the difference so the destination does not end up
+  // busier than the source.
+  int64_t load_to_move = (busiest_iter->second.total_load
+                          - idlest_iter->second.total_load)/2;
+  std::vector<RowLoad> rows_to_move;
+  const std::vector<RowLoad> &hot_rows = busiest_iter->second.hot_rows;
+  for (auto row_iter = hot_rows.begin(); row_iter != hot_rows.end();
+       row_iter++) {
+    if (row_iter->load > load_to_move)
+      continue;
+    rows_to_move.push_back(*row_iter);
+    load_to_move -= row_iter->load;
+  }
+  if (rows_to_move.empty())
+    return;
+
+  RowMigrateMsg row_migrate_msg(rows_to_move.size());
+  row_migrate_msg.get_version() = ++(name_node_context_->routing_version_);
+  row_migrate_msg.get_src_server_id() = busiest_iter->first;
+  row_migrate_msg.get_dst_server_id() = idlest_iter->first;
+  int32_t *data = row_migrate_msg.get_data();
+  for (size_t i = 0; i < rows_to_move.size(); ++i) {
+    data[2*i] = rows_to_move[i].table_id;
+    data[2*i + 1] = rows_to_move[i].row_id;
+  }
+  VLOG(0) << "Migrate " << rows_to_move.size() << " rows from server "
+          << busiest_iter->first << " to server " << idlest_iter->first
+          << " version = " << row_migrate_msg.get_version();
+  name_node_context_->row_migrating_ = true;
+  SendToAllBgThreads(row_migrate_msg.get_mem(), row_migrate_msg.get_size());
+}
+
 void NameNodeThread::SetUpNameNodeContext(){
   name_node_context_.reset(new NameNodeContext);
   name_node_context_->bg_thread_ids_.resize(
     GlobalContext::get_num_total_bg_threads());
   name_node_context_->num_shutdown_bgs_ = 0;
+  name_node_context_->routing_version_ = 0;
+  name_node_context_->row_migrating_ = false;
+  name_node_context_->num_shutdown_servers_ = 0;
 }
 
 void NameNodeThread::SetUpCommBus() {
@@ -301,6 +393,48 @@ void *NameNodeThread::NameNodeThreadMain(void *thread_id){
 	HandleCreateTableReply(create_table_reply_msg);
 	break;
       }
+    case kServerLoadReport:
+      {
+	ServerLoadReportMsg load_report_msg(zmq_msg.data());
+	HandleServerLoadReport(sender_id, load_report_msg);
+	break;
+      }
+    case kMigratedRows:
+      {
+	// Servers are not connected to each other, relay to the destination.
+	MigratedRowsMsg migrated_rows_msg(zmq_msg.data());
+	int32_t dst_server_id = migrated_rows_msg.get_dst_server_id();
+	size_t sent_size = (comm_bus_->*CommBusSendAny)(dst_server_id,
+	  zmq_msg.data(), zmq_msg.size());
+	CHECK_EQ(sent_size, zmq_msg.size());
+	break;
+      }
+    case kRowMigrateDone:
+      {
+	RowMigrateDoneMsg row_migrate_done_msg(zmq_msg.data());
+	CHECK_EQ(row_migrate_done_msg.get_version(),
+	         name_node_context_->routing_version_);
+	name_node_context_->row_migrating_ = false;
+	bool shutdown = CheckShutDown();
+	if (shutdown) {
+	  VLOG(0) << "NameNode shutting down";
+	  comm_bus_->ThreadDeregister();
+	  return 0;
+	}
+	break;
+      }
+    case kServerShutDownAck:
+      {
+	// The server will not report its load any more.
+	++(name_node_context_->num_shutdown_servers_);
+	bool shutdown = CheckShutDown();
+	if (shutdown) {
+	  VLOG(0) << "NameNode shutting down";
+	  comm_bus_->ThreadDeregister();
+	  return 0;
+	}
+	break;
+      }
     default:
       LOG(FATAL) << "Unrecognized message type " << msg_type
 		 << " sender = " << sender_id;
@@ -48,6 +48,12 @@ private:
     }
   };
 
+  struct ServerLoad {
+    int64_t total_load;
+    // In descending order of load.
+    std::vector<RowLoad> hot_rows;
+  };
+
   // server context is specific to the server thread
   struct NameNodeContext {
     std::vector<int32_t> bg_thread_ids_;
@@ -56,6 +62,16 @@ private:
     Server server_obj_;
 
     int32_t num_shutdown_bgs_;
+
+    /* Row migration */
+    // Load reports of the current round, indexed by server id.
+    std::map<int32_t, ServerLoad> server_loads_;
+    // Version of the routing after the latest migration; 0 is the static
+    // row partitioning.
+    int32_t routing_version_;
+    // At most one migration is in progress at a time.
+    bool row_migrating_;
+    int32_t num_shutdown_servers_;
   };
 
   static void *NameNodeThreadMain(void *server_thread_info);
@@ -76,11 +92,22 @@ private:
 
   static void SendToAllBgThreads(void *msg, size_t msg_size);
   static bool HandleShutDownMsg(); // returns true if the server may shut down
+  // Acknowledges shut down to all bg threads (and servers if rows may be
+  // migrated) once all bg threads have shut down and no migration is in
+  // progress. Returns true if the name node may shut down.
+  static bool CheckShutDown();
   static void HandleCreateTable(int32_t sender_id,
     CreateTableMsg &create_table_msg);
   static void HandleCreateTableReply(
     CreateTableReplyMsg &create_table_reply_msg);
 
+  /* Row migration */
+  static void HandleServerLoadReport(int32_t server_id,
+    ServerLoadReportMsg &load_report_msg);
+  // Once all servers reported their load, move hot rows from the busiest
+  // server to the least busy one if the load is imbalanced.
+  static void MigrateHotRows();
+
   static pthread_barrier_t init_barrier;
   static pthread_t thread_;
   static boost::thread_specific_ptr<NameNodeContext> name_node_context_;
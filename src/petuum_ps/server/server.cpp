@@ -3,13 +3,21 @@
 #include "petuum_ps/server/server.hpp"
 #include "petuum_ps/util/class_register.hpp"
 #include "petuum_ps/oplog/serialized_oplog_reader.hpp"
+#include <algorithm>
 #include <utility>
 
 namespace petuum {
 
-Server::Server() {}
+Server::Server():
+    apply_threads_(0) { }
 
-Server::~Server() {}
+Server::~Server() {
+  delete apply_threads_;
+  for (auto iter = deferred_migrated_rows_.begin();
+       iter != deferred_migrated_rows_.end(); iter++) {
+    delete *iter;
+  }
+}
 
 void Server::AddClientBgPair(int32_t client_id, int32_t bg_id) {
   client_bg_map_[client_id].push_back(bg_id);
@@ -32,7 +40,8 @@ void Server::Init() {
 }
 
 void Server::CreateTable(int32_t table_id, TableInfo &table_info){
-  auto ret = tables_.emplace(table_id, std::move(ServerTable(table_info)));
+  auto ret = tables_.emplace(table_id,
+    std::move(ServerTable(table_id, table_info)));
   CHECK(ret.second);
 }
 
@@ -43,11 +52,12 @@ ServerRow *Server::FindCreateRow(int32_t table_id, int32_t row_id){
 
   ServerTable &server_table = iter->second;
   ServerRow *server_row = server_table.FindRow(row_id);
-  if(server_row != 0)
-    return server_row;
-
-  server_row = server_table.CreateRow(row_id);
+  if(server_row == 0)
+    server_row = server_table.CreateRow(row_id);
 
+  // Rows are looked up here to reply row requests, which count towards the
+  // row's load.
+  server_row->IncLoad();
   return server_row;
 }
 
@@ -95,8 +105,13 @@ void Server::GetFulfilledRowRequests(std::vector<ServerRowRequest> *requests) {
 
   for (auto bg_iter = bg_row_requests.begin(); bg_iter != bg_row_requests.end();
     bg_iter++) {
-    requests->insert(requests->end(), bg_iter->second.begin(),
-      bg_iter->second.end());
+    for (auto request_iter = bg_iter->second.begin();
+         request_iter != bg_iter->second.end(); request_iter++) {
+      if (IsRowMigrating(request_iter->table_id, request_iter->row_id))
+        held_row_requests_.push_back(*request_iter);
+      else
+        requests->push_back(*request_iter);
+    }
   }
 
   clock_bg_row_requests_.erase(clock);
@@ -122,20 +137,45 @@ void Server::ApplyOpLog(const void *oplog, int32_t bg_thread_id,
   const void *updates = oplog_reader.Next(&table_id, &row_id, &column_ids,
     &num_updates, &started_new_table);
 
-  ServerTable *server_table;
+  ServerTable *server_table = 0;
   if (updates != 0) {
     auto table_iter = tables_.find(table_id);
     server_table = &(table_iter->second);
   }
 
+  // The name node's Server never applies oplogs, so the apply threads are
+  // started on first use.
+  int32_t num_apply_threads = GlobalContext::get_num_server_apply_threads();
+  if (num_apply_threads > 1 && apply_threads_ == 0) {
+    apply_threads_ = new ServerApplyThreads(num_apply_threads);
+    apply_slices_.resize(num_apply_threads);
+  }
+
   while (updates != 0) {
-    bool found
-      = server_table->ApplyRowOpLog(row_id, column_ids, updates, num_updates);
-    //VLOG(0) << "Update row_id = " << row_id
-    //	    << " num_updates = " << num_updates;
-    if (!found) {
-      server_table->CreateRow(row_id);
-      server_table->ApplyRowOpLog(row_id, column_ids, updates, num_updates);
+    if (!rows_migrating_in_.empty()
+        && rows_migrating_in_.count(std::make_pair(table_id, row_id)) > 0) {
+      // Applied once the row arrives.
+      size_t updates_size = num_updates*oplog_reader.get_update_size();
+      const uint8_t *updates_begin = reinterpret_cast<const uint8_t*>(updates);
+      stashed_oplogs_.push_back(StashedRowOpLog());
+      StashedRowOpLog &stashed_oplog = stashed_oplogs_.back();
+      stashed_oplog.table_id = table_id;
+      stashed_oplog.row_id = row_id;
+      stashed_oplog.num_updates = num_updates;
+      stashed_oplog.column_ids.assign(column_ids, column_ids + num_updates);
+      stashed_oplog.updates.assign(updates_begin,
+                                   updates_begin + updates_size);
+    } else {
+      ServerRowOpLog row_oplog = {server_table, row_id, column_ids, updates,
+                                  num_updates};
+      //VLOG(0) << "Update row_id = " << row_id
+      //	    << " num_updates = " << num_updates;
+      if (apply_threads_ != 0) {
+        apply_slices_[server_table->GetShardNum(row_id)].push_back(
+            row_oplog);
+      } else {
+        ServerApplyThreads::ApplyRowOpLog(row_oplog);
+      }
     }
 
     updates = oplog_reader.Next(&table_id, &row_id, &column_ids,
@@ -147,6 +187,9 @@ void Server::ApplyOpLog(const void *oplog, int32_t bg_thread_id,
       server_table = &(table_iter->second);
     }
   }
+  // Clock and row requests are handled after all updates are applied.
+  if (apply_threads_ != 0)
+    apply_threads_->Apply(&apply_slices_);
   VLOG(0) << "Read and Apply Update Done";
 }
 
@@ -158,7 +201,336 @@ int32_t Server::GetBgVersion(int32_t bg_thread_id) {
   return bg_version_map_[bg_thread_id];
 }
 
-void Server::CreateSendServerPushRowMsgs(PushMsgSendFunc PushMsgSend) {
+int64_t Server::GetAndResetLoads(int32_t max_num_rows,
+  std::vector<RowLoad> *hot_rows) {
+  hot_rows->clear();
+  int64_t total_load = 0;
+  for (auto table_iter = tables_.begin(); table_iter != tables_.end();
+       table_iter++) {
+    total_load += table_iter->second.GetAndResetRowLoads(hot_rows);
+  }
+  size_t num_hot_rows = std::min(hot_rows->size(),
+                                 static_cast<size_t>(max_num_rows));
+  std::partial_sort(hot_rows->begin(), hot_rows->begin() + num_hot_rows,
+    hot_rows->end(), [](const RowLoad &a, const RowLoad &b) {
+      return a.load > b.load; });
+  hot_rows->resize(num_hot_rows);
+  return total_load;
+}
+
+bool Server::AckRowMigrateOut(int32_t version, const int32_t *rows,
+  int32_t num_rows) {
+  RowMigration &migration = migrations_out_[version];
+  if (migration.num_acks++ == 0) {
+    for (int32_t i = 0; i < num_rows; ++i) {
+      int32_t table_id = rows[2*i];
+      int32_t row_id = rows[2*i + 1];
+      migration.rows.push_back(std::make_pair(table_id, row_id));
+      rows_migrating_out_.insert(std::make_pair(table_id, row_id));
+
+      auto table_iter = tables_.find(table_id);
+      CHECK(table_iter != tables_.end());
+      ServerRow *server_row = table_iter->second.FindRow(row_id);
+      if (server_row == 0)
+        server_row = table_iter->second.CreateRow(row_id);
+      server_row->SetMigrating(true);
+    }
+  }
+  return (migration.num_acks == GlobalContext::get_num_total_bg_threads());
+}
+
+void Server::AckRowMigrateIn(int32_t version, const int32_t *rows,
+  int32_t num_rows) {
+  RowMigration &migration = migrations_in_[version];
+  // The rows may already be here if they were shipped before this server
+  // heard from any bg thread.
+  if (migration.num_acks++ == 0 && !migration.installed) {
+    for (int32_t i = 0; i < num_rows; ++i) {
+      rows_migrating_in_.insert(std::make_pair(rows[2*i], rows[2*i + 1]));
+    }
+  }
+  if (migration.installed
+      && migration.num_acks == GlobalContext::get_num_total_bg_threads())
+    migrations_in_.erase(version);
+}
+
+bool Server::IsRowMigrating(int32_t table_id, int32_t row_id) {
+  if (rows_migrating_out_.empty() && rows_migrating_in_.empty())
+    return false;
+  std::pair<int32_t, int32_t> row_key(table_id, row_id);
+  return (rows_migrating_out_.count(row_key) > 0
+          || rows_migrating_in_.count(row_key) > 0);
+}
+
+void Server::HoldRowRequest(int32_t bg_id, int32_t table_id, int32_t row_id,
+  int32_t clock) {
+  ServerRowRequest server_row_request;
+  server_row_request.bg_id = bg_id;
+  server_row_request.table_id = table_id;
+  server_row_request.row_id = row_id;
+  server_row_request.clock = clock;
+  held_row_requests_.push_back(server_row_request);
+}
+
+MigratedRowsMsg *Server::CreateMigratedRowsMsg(int32_t version,
+  int32_t dst_server_id) {
+  auto migration_iter = migrations_out_.find(version);
+  CHECK(migration_iter != migrations_out_.end());
+  const std::vector<std::pair<int32_t, int32_t> > &rows
+      = migration_iter->second.rows;
+
+  HoldPendingRowRequests();
+  std::set<std::pair<int32_t, int32_t> > row_set(rows.begin(), rows.end());
+  std::vector<ServerRowRequest> requests;
+  std::vector<ServerRowRequest> requests_to_hold;
+  for (auto request_iter = held_row_requests_.begin();
+       request_iter != held_row_requests_.end(); request_iter++) {
+    if (row_set.count(std::make_pair(request_iter->table_id,
+                                     request_iter->row_id)) > 0)
+      requests.push_back(*request_iter);
+    else
+      requests_to_hold.push_back(*request_iter);
+  }
+  held_row_requests_.swap(requests_to_hold);
+
+  std::vector<ServerRow*> server_rows(rows.size());
+  std::vector<std::vector<int32_t> > subscribers(rows.size());
+  size_t msg_size = 0;
+  for (size_t i = 0; i < rows.size(); ++i) {
+    auto table_iter = tables_.find(rows[i].first);
+    server_rows[i] = table_iter->second.FindRow(rows[i].second);
+    CHECK(server_rows[i] != 0);
+    for (int32_t client_id = 0; client_id < GlobalContext::get_num_clients();
+         ++client_id) {
+      if (server_rows[i]->IsSubscribed(client_id))
+        subscribers[i].push_back(client_id);
+    }
+    msg_size += sizeof(int32_t) + sizeof(int32_t) + sizeof(int32_t)
+                + subscribers[i].size()*sizeof(int32_t) + sizeof(size_t)
+                + server_rows[i]->SerializedSize();
+  }
+  msg_size += requests.size()*4*sizeof(int32_t)
+      + bg_version_map_.size()*2*sizeof(int32_t);
+
+  MigratedRowsMsg *msg = new MigratedRowsMsg(msg_size);
+  msg->get_version() = version;
+  msg->get_dst_server_id() = dst_server_id;
+  msg->get_num_rows() = rows.size();
+  msg->get_num_requests() = requests.size();
+  msg->get_num_bg_versions() = bg_version_map_.size();
+
+  uint8_t *mem = reinterpret_cast<uint8_t*>(msg->get_data());
+  size_t offset = 0;
+  for (auto bg_iter = bg_version_map_.begin();
+       bg_iter != bg_version_map_.end(); bg_iter++) {
+    int32_t *bg_version_ptr = reinterpret_cast<int32_t*>(mem + offset);
+    bg_version_ptr[0] = bg_iter->first;
+    bg_version_ptr[1] = bg_iter->second;
+    offset += 2*sizeof(int32_t);
+  }
+  for (size_t i = 0; i < rows.size(); ++i) {
+    *(reinterpret_cast<int32_t*>(mem + offset)) = rows[i].first;
+    offset += sizeof(int32_t);
+    *(reinterpret_cast<int32_t*>(mem + offset)) = rows[i].second;
+    offset += sizeof(int32_t);
+    *(reinterpret_cast<int32_t*>(mem + offset)) = subscribers[i].size();
+    offset += sizeof(int32_t);
+    if (!subscribers[i].empty())
+      memcpy(mem + offset, subscribers[i].data(),
+             subscribers[i].size()*sizeof(int32_t));
+    offset += subscribers[i].size()*sizeof(int32_t);
+    size_t *row_size_ptr = reinterpret_cast<size_t*>(mem + offset);
+    offset += sizeof(size_t);
+    *row_size_ptr = server_rows[i]->Serialize(mem + offset);
+    offset += *row_size_ptr;
+  }
+  for (size_t i = 0; i < requests.size(); ++i) {
+    int32_t *request_ptr = reinterpret_cast<int32_t*>(mem + offset);
+    request_ptr[0] = requests[i].bg_id;
+    request_ptr[1] = requests[i].table_id;
+    request_ptr[2] = requests[i].row_id;
+    request_ptr[3] = requests[i].clock;
+    offset += 4*sizeof(int32_t);
+  }
+  // SerializedSize() is an upper bound.
+  msg->get_avai_size() = offset;
+
+  for (size_t i = 0; i < rows.size(); ++i) {
+    tables_.find(rows[i].first)->second.EraseRow(rows[i].second);
+    rows_migrating_out_.erase(rows[i]);
+  }
+  migrations_out_.erase(migration_iter);
+  return msg;
+}
+
+bool Server::InstallMigratedRows(MigratedRowsMsg &migrated_rows_msg,
+  std::vector<ServerRowRequest> *requests) {
+  requests->clear();
+  // The name node relays the rows independently of the oplogs bg threads
+  // send here, so the rows may hold updates of versions this server has
+  // not received. Replies stamped with this server's versions would then
+  // make clients apply those updates again.
+  if (!HasBgVersions(migrated_rows_msg)) {
+    MigratedRowsMsg *msg_copy
+        = new MigratedRowsMsg(migrated_rows_msg.get_avai_size());
+    memcpy(msg_copy->get_mem(), migrated_rows_msg.get_mem(),
+           migrated_rows_msg.get_size());
+    deferred_migrated_rows_.push_back(msg_copy);
+    return false;
+  }
+  DoInstallMigratedRows(migrated_rows_msg, requests);
+  return true;
+}
+
+void Server::InstallDeferredMigratedRows(
+  std::vector<ServerRowRequest> *requests,
+  std::vector<int32_t> *migration_versions) {
+  requests->clear();
+  migration_versions->clear();
+  if (deferred_migrated_rows_.empty())
+    return;
+
+  std::vector<MigratedRowsMsg*> msgs_to_defer;
+  std::vector<ServerRowRequest> installed_requests;
+  for (auto msg_iter = deferred_migrated_rows_.begin();
+       msg_iter != deferred_migrated_rows_.end(); msg_iter++) {
+    MigratedRowsMsg *msg = *msg_iter;
+    if (!HasBgVersions(*msg)) {
+      msgs_to_defer.push_back(msg);
+      continue;
+    }
+    DoInstallMigratedRows(*msg, &installed_requests);
+    requests->insert(requests->end(), installed_requests.begin(),
+                     installed_requests.end());
+    migration_versions->push_back(msg->get_version());
+    delete msg;
+  }
+  deferred_migrated_rows_.swap(msgs_to_defer);
+}
+
+bool Server::HasBgVersions(MigratedRowsMsg &migrated_rows_msg) {
+  const int32_t *bg_versions
+      = reinterpret_cast<const int32_t*>(migrated_rows_msg.get_data());
+  for (int32_t i = 0; i < migrated_rows_msg.get_num_bg_versions(); ++i) {
+    int32_t bg_id = bg_versions[2*i];
+    int32_t src_version = bg_versions[2*i + 1];
+    if (GetBgVersion(bg_id) < src_version)
+      return false;
+  }
+  return true;
+}
+
+void Server::DoInstallMigratedRows(MigratedRowsMsg &migrated_rows_msg,
+  std::vector<ServerRowRequest> *requests) {
+  requests->clear();
+  int32_t version = migrated_rows_msg.get_version();
+  int32_t num_rows = migrated_rows_msg.get_num_rows();
+  int32_t num_requests = migrated_rows_msg.get_num_requests();
+
+  const uint8_t *mem
+      = reinterpret_cast<const uint8_t*>(migrated_rows_msg.get_data());
+  size_t offset = migrated_rows_msg.get_num_bg_versions()*2*sizeof(int32_t);
+  for (int32_t i = 0; i < num_rows; ++i) {
+    int32_t table_id = *(reinterpret_cast<const int32_t*>(mem + offset));
+    offset += sizeof(int32_t);
+    int32_t row_id = *(reinterpret_cast<const int32_t*>(mem + offset));
+    offset += sizeof(int32_t);
+    int32_t num_subscribers
+        = *(reinterpret_cast<const int32_t*>(mem + offset));
+    offset += sizeof(int32_t);
+    const int32_t *subscribers
+        = reinterpret_cast<const int32_t*>(mem + offset);
+    offset += num_subscribers*sizeof(int32_t);
+    size_t row_size = *(reinterpret_cast<const size_t*>(mem + offset));
+    offset += sizeof(size_t);
+
+    auto table_iter = tables_.find(table_id);
+    CHECK(table_iter != tables_.end());
+    table_iter->second.EraseRow(row_id);
+    ServerRow *server_row = table_iter->second.CreateRow(row_id, mem + offset,
+                                                         row_size);
+    offset += row_size;
+    for (int32_t j = 0; j < num_subscribers; ++j) {
+      server_row->Subscribe(subscribers[j]);
+    }
+    // Updates the source held back from its subscribers.
+    server_row->MarkDirty();
+    rows_migrating_in_.erase(std::make_pair(table_id, row_id));
+  }
+
+  for (int32_t i = 0; i < num_requests; ++i) {
+    const int32_t *request_ptr = reinterpret_cast<const int32_t*>(mem + offset);
+    ServerRowRequest server_row_request;
+    server_row_request.bg_id = request_ptr[0];
+    server_row_request.table_id = request_ptr[1];
+    server_row_request.row_id = request_ptr[2];
+    server_row_request.clock = request_ptr[3];
+    requests->push_back(server_row_request);
+    offset += 4*sizeof(int32_t);
+  }
+
+  std::vector<StashedRowOpLog> stashed_oplogs;
+  for (auto oplog_iter = stashed_oplogs_.begin();
+       oplog_iter != stashed_oplogs_.end(); oplog_iter++) {
+    if (rows_migrating_in_.count(std::make_pair(oplog_iter->table_id,
+                                                oplog_iter->row_id)) > 0) {
+      stashed_oplogs.push_back(std::move(*oplog_iter));
+      continue;
+    }
+    ServerTable &server_table = tables_.find(oplog_iter->table_id)->second;
+    bool found = server_table.ApplyRowOpLog(oplog_iter->row_id,
+      oplog_iter->column_ids.data(), oplog_iter->updates.data(),
+      oplog_iter->num_updates);
+    CHECK(found);
+  }
+  stashed_oplogs_.swap(stashed_oplogs);
+
+  std::vector<ServerRowRequest> requests_to_hold;
+  for (auto request_iter = held_row_requests_.begin();
+       request_iter != held_row_requests_.end(); request_iter++) {
+    if (IsRowMigrating(request_iter->table_id, request_iter->row_id))
+      requests_to_hold.push_back(*request_iter);
+    else
+      requests->push_back(*request_iter);
+  }
+  held_row_requests_.swap(requests_to_hold);
+
+  RowMigration &migration = migrations_in_[version];
+  migration.installed = true;
+  if (migration.num_acks == GlobalContext::get_num_total_bg_threads())
+    migrations_in_.erase(version);
+}
+
+void Server::HoldPendingRowRequests() {
+  for (auto clock_iter = clock_bg_row_requests_.begin();
+       clock_iter != clock_bg_row_requests_.end(); clock_iter++) {
+    for (auto bg_iter = clock_iter->second.begin();
+         bg_iter != clock_iter->second.end(); bg_iter++) {
+      std::vector<ServerRowRequest> &bg_requests = bg_iter->second;
+      std::vector<ServerRowRequest> requests_to_keep;
+      for (auto request_iter = bg_requests.begin();
+           request_iter != bg_requests.end(); request_iter++) {
+        if (IsRowMigrating(request_iter->table_id, request_iter->row_id))
+          held_row_requests_.push_back(*request_iter);
+        else
+          requests_to_keep.push_back(*request_iter);
+      }
+      bg_requests.swap(requests_to_keep);
+    }
+  }
+}
+
+bool Server::HasRowsOverValueBound() {
+  for (auto table_iter = tables_.begin(); table_iter != tables_.end();
+       table_iter++) {
+    if (table_iter->second.HasRowsOverValueBound())
+      return true;
+  }
+  return false;
+}
+
+void Server::CreateSendServerPushRowMsgs(PushMsgSendFunc PushMsgSend,
+                                         bool clock_changed) {
   int32_t client_id = 0;
   boost::unordered_map<int32_t, RecordBuff> buffs;
   boost::unordered_map<int32_t, ServerPushRowMsg*> msg_map;
@@ -194,7 +566,7 @@ void Server::CreateSendServerPushRowMsgs(PushMsgSendFunc PushMsgSend) {
         int32_t *table_id_ptr = record_buff.GetMemPtrInt32();
         if (table_id_ptr == 0) {
           VLOG(0) << "Not enough space for table id, send out to " << bg_id;
-          PushMsgSend(bg_id, msg_map[bg_id], false);
+          PushMsgSend(bg_id, msg_map[bg_id], false, clock_changed);
           memset((msg_map[bg_id])->get_data(), 0, push_row_msg_data_size_);
           record_buff.ResetOffset();
           table_id_ptr = record_buff.GetMemPtrInt32();
@@ -217,7 +589,8 @@ void Server::CreateSendServerPushRowMsgs(PushMsgSendFunc PushMsgSend) {
       if (buff_end_ptr != 0)
         *buff_end_ptr = GlobalContext::get_serialized_table_end();
 
-      PushMsgSend(failed_bg_id, msg_map[failed_bg_id], false);
+      PushMsgSend(failed_bg_id, msg_map[failed_bg_id], false,
+                  clock_changed);
       //VLOG(0) << "PushMsgSend done()";
       memset((msg_map[failed_bg_id])->get_data(), 0, push_row_msg_data_size_);
       //VLOG(0) << "Reset memory";
@@ -244,7 +617,7 @@ void Server::CreateSendServerPushRowMsgs(PushMsgSendFunc PushMsgSend) {
           if (table_sep_ptr == 0) {
             VLOG(0) << "Not enough space for table separator, send out to "
               << bg_id;
-            PushMsgSend(bg_id, msg_map[bg_id], false);
+            PushMsgSend(bg_id, msg_map[bg_id], false, clock_changed);
             memset((msg_map[bg_id])->get_data(), 0, push_row_msg_data_size_);
             record_buff.ResetOffset();
           } else {
@@ -268,13 +641,13 @@ void Server::CreateSendServerPushRowMsgs(PushMsgSendFunc PushMsgSend) {
       if (table_end_ptr == 0) {
         VLOG(0) << "Not enough space for table end, send out to "
                 << bg_id;
-        PushMsgSend(bg_id, msg_map[bg_id], true);
+        PushMsgSend(bg_id, msg_map[bg_id], true, clock_changed);
         continue;
       }
       *table_end_ptr = GlobalContext::get_serialized_table_end();
       msg_map[bg_id]->get_avai_size() = buffs[bg_id].GetMemUsedSize();
       VLOG(0) << "End! Send msg out to " << bg_id;
-      PushMsgSend(bg_id, msg_map[bg_id], true);
+      PushMsgSend(bg_id, msg_map[bg_id], true, clock_changed);
       delete msg_map[bg_id];
     }
   }
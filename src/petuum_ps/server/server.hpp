@@ -3,6 +3,8 @@
 #pragma once
 
 #include <vector>
+#include <set>
+#include <utility>
 #include <pthread.h>
 #include <boost/unordered_map.hpp>
 #include "petuum_ps/include/table.hpp"
@@ -10,6 +12,7 @@
 #include "petuum_ps/include/abstract_row.hpp"
 #include "petuum_ps/util/vector_clock.hpp"
 #include "petuum_ps/server/server_table.hpp"
+#include "petuum_ps/server/server_apply_threads.hpp"
 #include "petuum_ps/thread/ps_msgs.hpp"
 
 namespace petuum {
@@ -46,10 +49,100 @@ public:
   int32_t GetBgVersion(int32_t bg_thread_id);
 
   typedef void (*PushMsgSendFunc)(int32_t bg_id, ServerPushRowMsg *msg,
-                                  bool is_last);
-  void CreateSendServerPushRowMsgs(PushMsgSendFunc PushMsgSender);
+                                  bool is_last, bool clock_changed);
+  // clock_changed is false when rows are pushed before the server clock
+  // advances (SSPPushValueBound).
+  void CreateSendServerPushRowMsgs(PushMsgSendFunc PushMsgSender,
+                                   bool clock_changed);
+  bool HasRowsOverValueBound();
+
+  // ======== Row migration ========
+  // Rows are migrated between servers as follows (see NameNodeThread):
+  // 1. Every bg thread switches the routing of the rows to the destination
+  // server and then acknowledges to both the source and the destination,
+  // so all messages it sent earlier reach the source first and all later
+  // ones go to the destination.
+  // 2. From the first acknowledgement on, the source holds the row requests
+  // for the rows and stops pushing them, and the destination stashes the
+  // updates for the rows and holds the requests for them.
+  // 3. Once all bg threads acknowledged, the source has applied all updates
+  // sent to it and ships the rows (with subscriptions and held requests) to
+  // the destination via the name node, along with the latest oplog version
+  // it received from each bg thread.
+  // 4. Once the destination has received those versions too, it installs
+  // the rows, applies the stashed updates and serves the requests. Replies
+  // and pushes carry the destination's versions, which then account for
+  // all updates in the shipped rows.
+  // A row is therefore never read on a server that misses updates another
+  // server has received, and SSP guarantees hold with either server's clock.
+
+  // Returns the total load since the last call and fills hot_rows with (at
+  // most max_num_rows of) the rows with the highest load, in descending
+  // order of load.
+  int64_t GetAndResetLoads(int32_t max_num_rows,
+    std::vector<RowLoad> *hot_rows);
+
+  // A bg thread acknowledged migration version, which moves num_rows rows
+  // ((table id, row id) pairs in rows) out of this server. Returns true
+  // when all bg threads have acknowledged it.
+  bool AckRowMigrateOut(int32_t version, const int32_t *rows,
+    int32_t num_rows);
+  // Same as above for the destination server.
+  void AckRowMigrateIn(int32_t version, const int32_t *rows,
+    int32_t num_rows);
+
+  bool IsRowMigrating(int32_t table_id, int32_t row_id);
+  // Hold a request for a migrating row until it is installed (or shipped
+  // with the row).
+  void HoldRowRequest(int32_t bg_id, int32_t table_id, int32_t row_id,
+    int32_t clock);
+
+  // Remove the rows of migration version from this server and pack them,
+  // together with the row requests pending on them, into a message.
+  MigratedRowsMsg *CreateMigratedRowsMsg(int32_t version,
+    int32_t dst_server_id);
+  // Install the migrated rows and apply the updates stashed for them. Fills
+  // requests with the row requests on them, held here or passed on by the
+  // source. Returns false if this server has not yet received the oplog
+  // versions the source had; the rows are then kept and installed by
+  // InstallDeferredMigratedRows().
+  bool InstallMigratedRows(MigratedRowsMsg &migrated_rows_msg,
+    std::vector<ServerRowRequest> *requests);
+  // Install the kept migrated rows whose oplog versions this server has
+  // received, see above. Fills migration_versions with their migration
+  // versions.
+  void InstallDeferredMigratedRows(std::vector<ServerRowRequest> *requests,
+    std::vector<int32_t> *migration_versions);
 
 private:
+  struct RowMigration {
+    RowMigration():
+        num_acks(0),
+        installed(false) { }
+
+    std::vector<std::pair<int32_t, int32_t> > rows;
+    int32_t num_acks;
+    // Destination only.
+    bool installed;
+  };
+
+  struct StashedRowOpLog {
+    int32_t table_id;
+    int32_t row_id;
+    int32_t num_updates;
+    std::vector<int32_t> column_ids;
+    std::vector<uint8_t> updates;
+  };
+
+  // Move the pending requests in clock_bg_row_requests_ on migrating rows to
+  // held_row_requests_.
+  void HoldPendingRowRequests();
+  // Whether this server has received from each bg thread the oplog versions
+  // the source had when it shipped the rows.
+  bool HasBgVersions(MigratedRowsMsg &migrated_rows_msg);
+  void DoInstallMigratedRows(MigratedRowsMsg &migrated_rows_msg,
+    std::vector<ServerRowRequest> *requests);
+
   VectorClock client_clocks_;
   std::map<int32_t, VectorClock> client_vector_clock_map_;
   std::map<int32_t, std::vector<int32_t> > client_bg_map_;
@@ -65,6 +158,23 @@ private:
   // Assume a single row does not exceed this size!
   static const size_t kPushRowMsgSizeInit = 1*1024*1024;
   size_t push_row_msg_data_size_;
+
+  // Indexed by migration version.
+  std::map<int32_t, RowMigration> migrations_out_;
+  std::map<int32_t, RowMigration> migrations_in_;
+  // (table id, row id) of the rows that are being migrated.
+  std::set<std::pair<int32_t, int32_t> > rows_migrating_out_;
+  std::set<std::pair<int32_t, int32_t> > rows_migrating_in_;
+  std::vector<ServerRowRequest> held_row_requests_;
+  // Updates to rows in rows_migrating_in_.
+  std::vector<StashedRowOpLog> stashed_oplogs_;
+  // Copies of the MigratedRowsMsgs that arrived ahead of oplog versions.
+  std::vector<MigratedRowsMsg*> deferred_migrated_rows_;
+
+  // Null if oplogs are applied by the server thread alone.
+  ServerApplyThreads *apply_threads_;
+  // Indexed by shard number, reused across oplog messages.
+  std::vector<std::vector<ServerRowOpLog> > apply_slices_;
 };
 
 }  // namespace petuum
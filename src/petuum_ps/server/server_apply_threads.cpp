@@ -0,0 +1,88 @@
+#include "petuum_ps/server/server_apply_threads.hpp"
+#include <glog/logging.h>
+
+namespace petuum {
+
+ServerApplyThreads::ServerApplyThreads(int32_t num_threads):
+    threads_(num_threads - 1),
+    thread_infos_(num_threads - 1),
+    slices_(0),
+    generation_(0),
+    num_pending_threads_(0),
+    shut_down_(false) {
+  CHECK_GT(num_threads, 1);
+  for (int32_t i = 0; i < num_threads - 1; ++i) {
+    thread_infos_[i].apply_threads = this;
+    thread_infos_[i].thread_num = i + 1;
+    int ret = pthread_create(&threads_[i], NULL, ApplyThreadMain,
+      &thread_infos_[i]);
+    CHECK_EQ(ret, 0);
+  }
+}
+
+ServerApplyThreads::~ServerApplyThreads() {
+  {
+    std::unique_lock<std::mutex> lock(mtx_);
+    shut_down_ = true;
+  }
+  work_cv_.notify_all();
+  for (size_t i = 0; i < threads_.size(); ++i) {
+    int ret = pthread_join(threads_[i], NULL);
+    CHECK_EQ(ret, 0);
+  }
+}
+
+void ServerApplyThreads::Apply(
+  std::vector<std::vector<ServerRowOpLog> > *slices) {
+  CHECK_EQ(slices->size(), threads_.size() + 1);
+  {
+    std::unique_lock<std::mutex> lock(mtx_);
+    slices_ = slices;
+    num_pending_threads_ = threads_.size();
+    ++generation_;
+  }
+  work_cv_.notify_all();
+
+  ApplySlice(&(*slices)[0]);
+
+  std::unique_lock<std::mutex> lock(mtx_);
+  while (num_pending_threads_ > 0)
+    done_cv_.wait(lock);
+  slices_ = 0;
+}
+
+void *ServerApplyThreads::ApplyThreadMain(void *thread_info) {
+  ThreadInfo *info = reinterpret_cast<ThreadInfo*>(thread_info);
+  ServerApplyThreads *apply_threads = info->apply_threads;
+  uint64_t generation = 0;
+  while (1) {
+    std::vector<ServerRowOpLog> *slice;
+    {
+      std::unique_lock<std::mutex> lock(apply_threads->mtx_);
+      while (apply_threads->generation_ == generation
+             && !apply_threads->shut_down_)
+        apply_threads->work_cv_.wait(lock);
+      if (apply_threads->shut_down_)
+        return 0;
+      generation = apply_threads->generation_;
+      slice = &(*apply_threads->slices_)[info->thread_num];
+    }
+
+    ApplySlice(slice);
+
+    std::unique_lock<std::mutex> lock(apply_threads->mtx_);
+    if (--(apply_threads->num_pending_threads_) == 0)
+      apply_threads->done_cv_.notify_one();
+  }
+  return 0;
+}
+
+void ServerApplyThreads::ApplySlice(std::vector<ServerRowOpLog> *slice) {
+  for (auto oplog_iter = slice->begin(); oplog_iter != slice->end();
+       ++oplog_iter) {
+    ApplyRowOpLog(*oplog_iter);
+  }
+  slice->clear();
+}
+
+}  // namespace petuum
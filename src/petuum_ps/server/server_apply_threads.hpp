@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <pthread.h>
+#include <boost/noncopyable.hpp>
+
+#include "petuum_ps/server/server_table.hpp"
+
+namespace petuum {
+
+// Updates to one row, pointing into a ClientSendOpLogMsg.
+struct ServerRowOpLog {
+  ServerTable *server_table;
+  int32_t row_id;
+  const int32_t *column_ids;
+  const void *updates;
+  int32_t num_updates;
+};
+
+// A pool of threads that applies the oplogs a server thread receives. The
+// server thread deserializes an oplog message into one slice per thread,
+// each holding the updates to one shard of the server's tables (see
+// ServerTable::GetShardNum()), and blocks in Apply() until all slices are
+// applied. The server thread itself applies slice 0, so the server is never
+// accessed by more than one thread outside of Apply(). Only applying is
+// parallel: row requests that arrive meanwhile wait until Apply() returns.
+class ServerApplyThreads : boost::noncopyable {
+public:
+  explicit ServerApplyThreads(int32_t num_threads);
+  ~ServerApplyThreads();
+
+  // (*slices)[i] is applied by thread i; the slices are cleared on return.
+  void Apply(std::vector<std::vector<ServerRowOpLog> > *slices);
+
+  static void ApplyRowOpLog(const ServerRowOpLog &row_oplog) {
+    bool found = row_oplog.server_table->ApplyRowOpLog(row_oplog.row_id,
+      row_oplog.column_ids, row_oplog.updates, row_oplog.num_updates);
+    if (!found) {
+      row_oplog.server_table->CreateRow(row_oplog.row_id);
+      row_oplog.server_table->ApplyRowOpLog(row_oplog.row_id,
+        row_oplog.column_ids, row_oplog.updates, row_oplog.num_updates);
+    }
+  }
+
+private:
+  struct ThreadInfo {
+    ServerApplyThreads *apply_threads;
+    int32_t thread_num;
+  };
+
+  static void *ApplyThreadMain(void *thread_info);
+  static void ApplySlice(std::vector<ServerRowOpLog> *slice);
+
+  std::vector<pthread_t> threads_;
+  std::vector<ThreadInfo> thread_infos_;
+
+  std::mutex mtx_;
+  // Signaled when slices are ready or the threads should exit.
+  std::condition_variable work_cv_;
+  // Signaled when the last thread finishes its slice.
+  std::condition_variable done_cv_;
+  std::vector<std::vector<ServerRowOpLog> > *slices_;
+  // Incremented by every Apply() call.
+  uint64_t generation_;
+  int32_t num_pending_threads_;
+  bool shut_down_;
+};
+
+}  // namespace petuum
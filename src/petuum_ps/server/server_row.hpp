@@ -13,10 +13,18 @@ namespace petuum {
 // Allow move sematic for it to be stored in STL containers.
 class ServerRow : boost::noncopyable {
 public:
-  ServerRow() {}
+  ServerRow():
+      dirty_(false),
+      update_magnitude_(0),
+      load_(0),
+      migrating_(false) { }
   ServerRow(AbstractRow *row_data):
       row_data_(row_data),
-      num_clients_subscribed_(0) { }
+      num_clients_subscribed_(0),
+      dirty_(false),
+      update_magnitude_(0),
+      load_(0),
+      migrating_(false) { }
 
   ~ServerRow() {
     if(row_data_ != 0)
@@ -25,13 +33,71 @@ public:
 
   ServerRow(ServerRow && other):
       row_data_(other.row_data_),
-      num_clients_subscribed_(other.num_clients_subscribed_) {
+      num_clients_subscribed_(other.num_clients_subscribed_),
+      dirty_(other.dirty_),
+      update_magnitude_(other.update_magnitude_),
+      load_(other.load_),
+      migrating_(other.migrating_) {
     other.row_data_ = 0;
   }
 
   void ApplyBatchInc(const int32_t *column_ids,
     const void *update_batch, int32_t num_updates) {
     row_data_->ApplyBatchIncUnsafe(column_ids, update_batch, num_updates);
+    dirty_ = true;
+  }
+
+  // Same as ApplyBatchInc but also accumulates the magnitude of the updates
+  // so that value-bounded push can tell how far subscribers have drifted.
+  void ApplyBatchIncAccumMagnitude(const int32_t *column_ids,
+    const void *update_batch, int32_t num_updates) {
+    ApplyBatchInc(column_ids, update_batch, num_updates);
+    update_magnitude_ += row_data_->GetUpdatesMagnitude(column_ids,
+      update_batch, num_updates);
+  }
+
+  double get_update_magnitude() const {
+    return update_magnitude_;
+  }
+
+  // A row is dirty if it has been updated since it was last pushed to
+  // subscribers. Clients that subscribe later get the full row in the row
+  // request reply, so a clean row never needs to be pushed.
+  bool IsDirty() const {
+    return dirty_;
+  }
+
+  void ResetDirty() {
+    dirty_ = false;
+    update_magnitude_ = 0;
+  }
+
+  void MarkDirty() {
+    dirty_ = true;
+  }
+
+  // Number of oplog applications and row requests since the last
+  // ResetLoad(), used to find hot rows.
+  void IncLoad() {
+    ++load_;
+  }
+
+  int32_t get_load() const {
+    return load_;
+  }
+
+  void ResetLoad() {
+    load_ = 0;
+  }
+
+  // A row that is being migrated to another server is neither pushed nor
+  // used to reply row requests.
+  bool IsMigrating() const {
+    return migrating_;
+  }
+
+  void SetMigrating(bool migrating) {
+    migrating_ = migrating;
   }
 
   size_t SerializedSize() {
@@ -43,6 +109,10 @@ public:
     return row_data_->Serialize(bytes);
   }
 
+  void Deserialize(const void *data, size_t num_bytes) {
+    row_data_->Deserialize(data, num_bytes);
+  }
+
   void Subscribe(int32_t client_id) {
     if (callback_subs_.Subscribe(client_id))
       ++num_clients_subscribed_;
@@ -54,6 +124,10 @@ public:
     return (num_clients_subscribed_ == 0);
   }
 
+  bool IsSubscribed(int32_t client_id) const {
+    return callback_subs_.IsSubscribed(client_id);
+  }
+
   void Unsubscribe(int32_t client_id) {
     if (callback_subs_.Unsubscribe(client_id))
       --num_clients_subscribed_;
@@ -61,15 +135,21 @@ public:
 
   bool AppendRowToBuffs(int32_t client_id_st,
     boost::unordered_map<int32_t, RecordBuff> *buffs,
-    const void *row_data, size_t row_size, int32_t row_id,
+    const void *row_data, size_t row_size, int32_t table_id, int32_t row_id,
     int32_t *failed_bg_id, int32_t *failed_client_id) {
     return callback_subs_.AppendRowToBuffs(client_id_st, buffs, row_data,
-      row_size, row_id, failed_bg_id, failed_client_id);
+      row_size, table_id, row_id, failed_bg_id, failed_client_id);
   }
 
 private:
   CallBackSubs callback_subs_;
   AbstractRow *row_data_;
   size_t num_clients_subscribed_;
+  bool dirty_;
+  // Accumulated magnitude of updates since the last push, only maintained
+  // under SSPPushValueBound.
+  double update_magnitude_;
+  int32_t load_;
+  bool migrating_;
 };
 }
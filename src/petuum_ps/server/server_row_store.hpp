@@ -0,0 +1,239 @@
+#pragma once
+
+#include <stdint.h>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+#include "petuum_ps/server/server_row.hpp"
+
+namespace petuum {
+
+// Row storage of a ServerTable shard. ServerRows live in fixed-size slabs,
+// so a ServerRow never moves once created and iteration walks rows in
+// allocation order over contiguous memory. Row ids are mapped to slots by a
+// linear-probing open-addressing index; slots of erased rows are reused.
+class ServerRowStore : boost::noncopyable {
+public:
+  // Slots are numbered across slabs: slot s is in slab s / kSlabSize.
+  class iterator {
+  public:
+    iterator():
+        store_(0),
+        slot_(0) { }
+
+    int32_t row_id() const {
+      return store_->GetSlot(slot_)->row_id;
+    }
+
+    ServerRow &row() const {
+      return *(store_->GetSlot(slot_)->row());
+    }
+
+    iterator &operator++() {
+      ++slot_;
+      SkipFreeSlots();
+      return *this;
+    }
+
+    bool operator==(const iterator &other) const {
+      return slot_ == other.slot_;
+    }
+
+    bool operator!=(const iterator &other) const {
+      return slot_ != other.slot_;
+    }
+
+  private:
+    friend class ServerRowStore;
+
+    iterator(ServerRowStore *store, uint32_t slot):
+        store_(store),
+        slot_(slot) {
+      SkipFreeSlots();
+    }
+
+    void SkipFreeSlots() {
+      while (slot_ < store_->num_slots_ && !store_->GetSlot(slot_)->used)
+        ++slot_;
+    }
+
+    ServerRowStore *store_;
+    uint32_t slot_;
+  };
+
+  ServerRowStore():
+      num_slots_(0),
+      num_rows_(0),
+      num_erased_(0) { }
+
+  ~ServerRowStore() {
+    for (uint32_t slot = 0; slot < num_slots_; ++slot) {
+      Slot *row_slot = GetSlot(slot);
+      if (row_slot->used)
+        row_slot->row()->~ServerRow();
+    }
+    for (auto slab_iter = slabs_.begin(); slab_iter != slabs_.end();
+         ++slab_iter) {
+      ::operator delete(*slab_iter);
+    }
+  }
+
+  ServerRow *Find(int32_t row_id) {
+    if (num_rows_ == 0)
+      return 0;
+    uint32_t mask = index_.size() - 1;
+    for (uint32_t pos = Hash(row_id) & mask; ; pos = (pos + 1) & mask) {
+      uint32_t slot = index_[pos];
+      if (slot == kEmpty)
+        return 0;
+      if (slot != kErased && GetSlot(slot)->row_id == row_id)
+        return GetSlot(slot)->row();
+    }
+  }
+
+  // row_id must not be in the store. Takes ownership of row_data.
+  ServerRow *Insert(int32_t row_id, AbstractRow *row_data) {
+    if ((num_rows_ + num_erased_ + 1)*kMaxLoadDen
+        > index_.size()*kMaxLoadNum)
+      Rehash();
+
+    uint32_t slot;
+    if (!free_slots_.empty()) {
+      slot = free_slots_.back();
+      free_slots_.pop_back();
+    } else {
+      if (num_slots_ == slabs_.size()*kSlabSize)
+        AddSlab();
+      slot = num_slots_++;
+    }
+    Slot *row_slot = GetSlot(slot);
+    new (row_slot->row()) ServerRow(row_data);
+    row_slot->row_id = row_id;
+    row_slot->used = true;
+
+    uint32_t mask = index_.size() - 1;
+    uint32_t pos = Hash(row_id) & mask;
+    while (index_[pos] != kEmpty && index_[pos] != kErased)
+      pos = (pos + 1) & mask;
+    if (index_[pos] == kErased)
+      --num_erased_;
+    index_[pos] = slot;
+    ++num_rows_;
+    return row_slot->row();
+  }
+
+  // Does nothing if row_id is not in the store.
+  void Erase(int32_t row_id) {
+    if (num_rows_ == 0)
+      return;
+    uint32_t mask = index_.size() - 1;
+    for (uint32_t pos = Hash(row_id) & mask; ; pos = (pos + 1) & mask) {
+      uint32_t slot = index_[pos];
+      if (slot == kEmpty)
+        return;
+      if (slot != kErased && GetSlot(slot)->row_id == row_id) {
+        Slot *row_slot = GetSlot(slot);
+        row_slot->row()->~ServerRow();
+        row_slot->used = false;
+        free_slots_.push_back(slot);
+        index_[pos] = kErased;
+        ++num_erased_;
+        --num_rows_;
+        return;
+      }
+    }
+  }
+
+  size_t size() const {
+    return num_rows_;
+  }
+
+  iterator begin() {
+    return iterator(this, 0);
+  }
+
+  iterator end() {
+    return iterator(this, num_slots_);
+  }
+
+private:
+  struct Slot {
+    ServerRow *row() {
+      return reinterpret_cast<ServerRow*>(&row_mem);
+    }
+
+    std::aligned_storage<sizeof(ServerRow), alignof(ServerRow)>::type row_mem;
+    int32_t row_id;
+    bool used;
+  };
+
+  static const uint32_t kSlabSize = 1024;
+  static const uint32_t kEmpty = 0xffffffffu;
+  static const uint32_t kErased = 0xfffffffeu;
+  static const size_t kMinIndexSize = 16;
+  // The index is grown when occupied and erased entries exceed 7/10 of it.
+  static const size_t kMaxLoadNum = 7;
+  static const size_t kMaxLoadDen = 10;
+
+  // The MurmurHash3 finalizer. ServerTable picks the shard from the high
+  // bits of a multiplicative hash of the row id, so the index uses a hash
+  // whose low bits are independent of that.
+  static uint32_t Hash(int32_t row_id) {
+    uint32_t h = static_cast<uint32_t>(row_id);
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+  }
+
+  Slot *GetSlot(uint32_t slot) const {
+    return slabs_[slot / kSlabSize] + slot % kSlabSize;
+  }
+
+  void AddSlab() {
+    Slot *slab = static_cast<Slot*>(::operator new(sizeof(Slot)*kSlabSize));
+    for (uint32_t i = 0; i < kSlabSize; ++i)
+      slab[i].used = false;
+    slabs_.push_back(slab);
+  }
+
+  // Rebuild the index, dropping erased entries and doubling it if it is
+  // more than half full of rows.
+  void Rehash() {
+    size_t index_size = index_.size();
+    if (index_size < kMinIndexSize)
+      index_size = kMinIndexSize;
+    while ((num_rows_ + 1)*2 > index_size)
+      index_size *= 2;
+    index_.assign(index_size, static_cast<uint32_t>(kEmpty));
+    num_erased_ = 0;
+
+    uint32_t mask = index_size - 1;
+    for (uint32_t slot = 0; slot < num_slots_; ++slot) {
+      Slot *row_slot = GetSlot(slot);
+      if (!row_slot->used)
+        continue;
+      uint32_t pos = Hash(row_slot->row_id) & mask;
+      while (index_[pos] != kEmpty)
+        pos = (pos + 1) & mask;
+      index_[pos] = slot;
+    }
+  }
+
+  std::vector<Slot*> slabs_;
+  // Number of slots handed out so far, used or freed.
+  uint32_t num_slots_;
+  std::vector<uint32_t> free_slots_;
+
+  // Slot of each row, or kEmpty / kErased; the size is a power of 2.
+  std::vector<uint32_t> index_;
+  size_t num_rows_;
+  // Number of kErased entries in index_.
+  size_t num_erased_;
+};
+
+}  // namespace petuum
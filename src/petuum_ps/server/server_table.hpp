@@ -2,31 +2,56 @@
 
 #pragma once
 #include "petuum_ps/server/server_row.hpp"
+#include "petuum_ps/server/server_row_store.hpp"
+#include "petuum_ps/thread/msg_codec.hpp"
 #include "petuum_ps/util/class_register.hpp"
 #include <boost/unordered_map.hpp>
 #include <map>
+#include <vector>
 #include <utility>
 
 namespace petuum {
 
+struct RowLoad {
+  int32_t table_id;
+  int32_t row_id;
+  int32_t load;
+};
+
 class ServerTable : boost::noncopyable {
 public:
-  explicit ServerTable(const TableInfo &table_info):
+  ServerTable(int32_t table_id, const TableInfo &table_info):
+      table_id_(table_id),
       table_info_(table_info),
+      shards_(GlobalContext::get_num_server_apply_threads()),
+      value_bound_push_(GlobalContext::get_consistency_model()
+                        == SSPPushValueBound),
       tmp_row_buff_size_ (kTmpRowBuffSizeInit) {}
 
   // Move constructor: storage gets other's storage, leaving other
   // in an unspecified but valid state.
   ServerTable(ServerTable && other):
+    table_id_(other.table_id_),
     table_info_(other.table_info_),
-    storage_(std::move(other.storage_)) ,
+    shards_(std::move(other.shards_)) ,
+    value_bound_push_(other.value_bound_push_),
     tmp_row_buff_size_(other.tmp_row_buff_size_) { }
 
-  ServerRow *FindRow(int32_t row_id) {
-    auto row_iter = storage_.find(row_id);
-    if(row_iter == storage_.end())
+  // Rows are sharded among the server's apply threads. A shard is only
+  // modified by one thread at a time, so ApplyRowOpLog() and CreateRow() may
+  // be called concurrently for rows in different shards.
+  int32_t GetShardNum(int32_t row_id) const {
+    if (shards_.size() == 1)
       return 0;
-    return &(row_iter->second);
+    // Fibonacci hashing, so strided row ids (e.g. the rows of one server
+    // under ModuloPartition) spread over all shards. The high bits of the
+    // hash are mapped to [0, number of shards).
+    uint32_t hash = static_cast<uint32_t>(row_id) * 2654435761u;
+    return (static_cast<uint64_t>(hash) * shards_.size()) >> 32;
+  }
+
+  ServerRow *FindRow(int32_t row_id) {
+    return shards_[GetShardNum(row_id)].storage.Find(row_id);
   }
 
   ServerRow *CreateRow(int32_t row_id) {
@@ -34,23 +59,86 @@ public:
     AbstractRow *row_data
       = ClassRegistry<AbstractRow>::GetRegistry().CreateObject(row_type);
     row_data->Init(table_info_.row_capacity);
-    storage_.insert(std::make_pair(row_id, ServerRow(row_data)));
-    return &(storage_[row_id]);
+    return shards_[GetShardNum(row_id)].storage.Insert(row_id, row_data);
+  }
+
+  // Create a row from its serialized form (e.g. a row migrated from another
+  // server).
+  ServerRow *CreateRow(int32_t row_id, const void *row_data,
+    size_t row_size) {
+    ServerRow *server_row = CreateRow(row_id);
+    server_row->Deserialize(row_data, row_size);
+    return server_row;
+  }
+
+  void EraseRow(int32_t row_id) {
+    shards_[GetShardNum(row_id)].storage.Erase(row_id);
+  }
+
+  // Append the load of every row with non-zero load to loads and reset it.
+  // Rows being migrated are skipped. Returns the total load of the table.
+  int64_t GetAndResetRowLoads(std::vector<RowLoad> *loads) {
+    int64_t total_load = 0;
+    for (auto shard_iter = shards_.begin(); shard_iter != shards_.end();
+         ++shard_iter) {
+      RowStorage &storage = shard_iter->storage;
+      for (auto row_iter = storage.begin(); row_iter != storage.end();
+           ++row_iter) {
+        ServerRow &server_row = row_iter.row();
+        int32_t load = server_row.get_load();
+        if (load == 0)
+          continue;
+        server_row.ResetLoad();
+        total_load += load;
+        if (server_row.IsMigrating())
+          continue;
+        loads->push_back({table_id_, row_iter.row_id(), load});
+      }
+    }
+    return total_load;
   }
 
   bool ApplyRowOpLog(int32_t row_id, const int32_t *column_ids,
     const void *updates, int32_t num_updates){
-    auto row_iter = storage_.find(row_id);
-    if (row_iter == storage_.end()) {
+    Shard &shard = shards_[GetShardNum(row_id)];
+    ServerRow *server_row = shard.storage.Find(row_id);
+    if (server_row == 0) {
       //VLOG(0) << "Row " << row_id << " is not found!";
       return false;
     }
-    row_iter->second.ApplyBatchInc(column_ids, updates, num_updates);
+    server_row->IncLoad();
+    if (value_bound_push_) {
+      server_row->ApplyBatchIncAccumMagnitude(column_ids, updates,
+                                              num_updates);
+      if (server_row->get_update_magnitude() >= table_info_.value_bound)
+        shard.has_rows_over_value_bound = true;
+    } else {
+      server_row->ApplyBatchInc(column_ids, updates, num_updates);
+    }
     return true;
   }
 
+  // True if some row has accumulated enough updates to be pushed before the
+  // clock advances (SSPPushValueBound only).
+  bool HasRowsOverValueBound() const {
+    for (auto shard_iter = shards_.begin(); shard_iter != shards_.end();
+         ++shard_iter) {
+      if (shard_iter->has_rows_over_value_bound)
+        return true;
+    }
+    return false;
+  }
+
   void InitAppendTableToBuffs() {
-    row_iter_ = storage_.begin();
+    for (auto shard_iter = shards_.begin(); shard_iter != shards_.end();
+         ++shard_iter) {
+      shard_iter->has_rows_over_value_bound = false;
+    }
+    compact_codec_ = (GlobalContext::GetTableMsgCodec(table_id_)
+                      == CompactCodec);
+    shard_num_ = 0;
+    row_iter_ = shards_[0].storage.begin();
+    SkipEmptyShards();
     VLOG(0) << "tmp_row_buff_size_ = " << tmp_row_buff_size_;
     tmp_row_buff_ = new uint8_t[tmp_row_buff_size_];
   }
@@ -60,18 +148,24 @@ public:
     int32_t *failed_client_id, bool resume) {
 
     if (resume) {
-      bool append_row_suc = row_iter_->second.AppendRowToBuffs(client_id_st,
-        buffs, tmp_row_buff_, curr_row_size_, row_iter_->first,failed_bg_id,
-        failed_client_id);
+      bool append_row_suc = row_iter_.row().AppendRowToBuffs(client_id_st,
+        buffs, curr_row_data_, curr_row_size_, table_id_, row_iter_.row_id(),
+        failed_bg_id, failed_client_id);
       if (!append_row_suc)
         return false;
       ++row_iter_;
+      SkipEmptyShards();
     }
-    for (; row_iter_ != storage_.end(); ++row_iter_) {
-      if (row_iter_->second.NoClientSubscribed())
+    for (; row_iter_ != shards_[shard_num_].storage.end();
+         ++row_iter_, SkipEmptyShards()) {
+      // Only rows modified since the last push are sent out.
+      if (!ShouldPushRow(row_iter_.row()))
+        continue;
+      row_iter_.row().ResetDirty();
+      if (row_iter_.row().NoClientSubscribed())
         continue;
-      //VLOG(0) << "Appending row " << row_iter_->first;
-      curr_row_size_ = row_iter_->second.SerializedSize();
+      //VLOG(0) << "Appending row " << row_iter_.row_id();
+      curr_row_size_ = row_iter_.row().SerializedSize();
       //VLOG(0) << "Get serialized size = " << curr_row_size_;
       if (curr_row_size_ > tmp_row_buff_size_) {
         VLOG(0) << "Reallocate tmp_buff "
@@ -81,11 +175,14 @@ public:
         tmp_row_buff_size_ = curr_row_size_;
         tmp_row_buff_ = new uint8_t[curr_row_size_];
       }
-      curr_row_size_ = row_iter_->second.Serialize(tmp_row_buff_);
+      curr_row_size_ = row_iter_.row().Serialize(tmp_row_buff_);
       //VLOG(0) << "Serialize Done!, curr_row_size_ = " << curr_row_size_;
-      bool append_row_suc = row_iter_->second.AppendRowToBuffs(client_id_st,
-        buffs, tmp_row_buff_, curr_row_size_, row_iter_->first, failed_bg_id,
-        failed_client_id);
+      curr_row_data_ = tmp_row_buff_;
+      if (compact_codec_)
+        EncodeCurrRow();
+      bool append_row_suc = row_iter_.row().AppendRowToBuffs(client_id_st,
+        buffs, curr_row_data_, curr_row_size_, table_id_, row_iter_.row_id(),
+        failed_bg_id, failed_client_id);
       if (!append_row_suc)
         return false;
     }
@@ -95,14 +192,66 @@ public:
   }
 
 private:
+  typedef ServerRowStore RowStorage;
+
+  struct Shard {
+    Shard():
+        has_rows_over_value_bound(false) { }
+
+    RowStorage storage;
+    bool has_rows_over_value_bound;
+  };
+
+  // Replace the serialized row in tmp_row_buff_ with its CompactCodec
+  // encoding, which SerializedRowReader decodes.
+  void EncodeCurrRow() {
+    size_t max_size = MsgCompressor::GetMaxEncodedRowSize(curr_row_size_);
+    if (encoded_row_buff_.size() < max_size)
+      encoded_row_buff_.resize(max_size);
+    size_t encoded_size = MsgCompressor::EncodeRow(tmp_row_buff_,
+      curr_row_size_, encoded_row_buff_.data());
+    MsgCompressor::AddPushRowBytes(curr_row_size_, encoded_size);
+    curr_row_size_ = encoded_size;
+    curr_row_data_ = encoded_row_buff_.data();
+  }
+
+  // Move row_iter_ to the next shard while it is at the end of a shard that
+  // is not the last one.
+  void SkipEmptyShards() {
+    while (row_iter_ == shards_[shard_num_].storage.end()
+           && shard_num_ + 1 < shards_.size()) {
+      ++shard_num_;
+      row_iter_ = shards_[shard_num_].storage.begin();
+    }
+  }
+
+  // Rows not updated since the last push are skipped. Under
+  // SSPPushValueBound, updated rows are deferred until their accumulated
+  // update magnitude reaches the table's value bound. Migrating rows stay
+  // dirty and are pushed by the server they move to.
+  bool ShouldPushRow(const ServerRow &server_row) const {
+    if (!server_row.IsDirty() || server_row.IsMigrating())
+      return false;
+    if (value_bound_push_)
+      return server_row.get_update_magnitude() >= table_info_.value_bound;
+    return true;
+  }
+
+  int32_t table_id_;
   TableInfo table_info_;
-  boost::unordered_map<int32_t, ServerRow> storage_;
+  std::vector<Shard> shards_;
+  bool value_bound_push_;
 
   // used for appending rows to buffs
-  boost::unordered_map<int32_t, ServerRow>::iterator row_iter_;
+  size_t shard_num_;
+  RowStorage::iterator row_iter_;
   uint8_t *tmp_row_buff_;
   size_t tmp_row_buff_size_;
   static const size_t kTmpRowBuffSizeInit = 512;
+  bool compact_codec_;
+  std::vector<uint8_t> encoded_row_buff_;
+  // The row being appended, either in tmp_row_buff_ or encoded_row_buff_.
+  const uint8_t *curr_row_data_;
   size_t curr_row_size_;
 };
 
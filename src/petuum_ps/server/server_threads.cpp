@@ -20,6 +20,7 @@ CommBus::SendFunc ServerThreads::CommBusSendAny;
 CommBus::RecvAsyncFunc ServerThreads::CommBusRecvAsyncAny;
 CommBus *ServerThreads::comm_bus_;
 ServerThreads::ServerPushRowFunc ServerThreads::ServerPushRow;
+ServerThreads::ServerPushRowFunc ServerThreads::ServerEarlyPushRow;
 CommBus::RecvWrapperFunc ServerThreads::CommBusRecvAnyWrapper;
 ServerThreads::RowSubscribeFunc ServerThreads::RowSubscribe;
 
@@ -56,10 +57,17 @@ void ServerThreads::Init(int32_t id_st){
   switch(consistency_model) {
     case SSP:
       ServerPushRow = SSPServerPushRow;
+      ServerEarlyPushRow = SSPServerEarlyPushRow;
       RowSubscribe = SSPRowSubscribe;
       break;
     case SSPPush:
       ServerPushRow = SSPPushServerPushRow;
+      ServerEarlyPushRow = SSPServerEarlyPushRow;
+      RowSubscribe = SSPPushRowSubscribe;
+      break;
+    case SSPPushValueBound:
+      ServerPushRow = SSPPushServerPushRow;
+      ServerEarlyPushRow = SSPPushValueBoundServerEarlyPushRow;
       RowSubscribe = SSPPushRowSubscribe;
       break;
     default:
@@ -164,19 +172,37 @@ bool ServerThreads::HandleShutDownMsg(){
   // reply to each bg with a ShutDownReply message
   int32_t &num_shutdown_bgs = server_context_->num_shutdown_bgs_;
   ++num_shutdown_bgs;
-  if(num_shutdown_bgs == GlobalContext::get_num_total_bg_threads()){
+  if (num_shutdown_bgs == GlobalContext::get_num_total_bg_threads()
+      && GlobalContext::get_row_migration()) {
+    // No more load reports from this server. The name node replies once no
+    // rows are being migrated.
     ServerShutDownAckMsg shut_down_ack_msg;
-    size_t msg_size = shut_down_ack_msg.get_size();
-    int i;
-    for(i = 0; i < GlobalContext::get_num_total_bg_threads(); ++i){
-      int32_t bg_id = server_context_->bg_thread_ids_[i];
-      size_t sent_size = (comm_bus_->*CommBusSendAny)(bg_id,
-        shut_down_ack_msg.get_mem(), msg_size);
-      CHECK_EQ(msg_size, sent_size);
-    }
-    return true;
+    int32_t name_node_id = GlobalContext::get_name_node_id();
+    size_t sent_size = (comm_bus_->*CommBusSendAny)(name_node_id,
+      shut_down_ack_msg.get_mem(), shut_down_ack_msg.get_size());
+    CHECK_EQ(sent_size, shut_down_ack_msg.get_size());
+  }
+  return CheckShutDown();
+}
+
+bool ServerThreads::CheckShutDown() {
+  if (server_context_->num_shutdown_bgs_
+      < GlobalContext::get_num_total_bg_threads())
+    return false;
+  if (GlobalContext::get_row_migration()
+      && !server_context_->name_node_shutdown_acked_)
+    return false;
+
+  ServerShutDownAckMsg shut_down_ack_msg;
+  size_t msg_size = shut_down_ack_msg.get_size();
+  int i;
+  for(i = 0; i < GlobalContext::get_num_total_bg_threads(); ++i){
+    int32_t bg_id = server_context_->bg_thread_ids_[i];
+    size_t sent_size = (comm_bus_->*CommBusSendAny)(bg_id,
+      shut_down_ack_msg.get_mem(), msg_size);
+    CHECK_EQ(msg_size, sent_size);
   }
-  return false;
+  return true;
 }
 
 void ServerThreads::HandleCreateTable(int32_t sender_id,
@@ -194,6 +220,7 @@ void ServerThreads::HandleCreateTable(int32_t sender_id,
   table_info.table_staleness = create_table_msg.get_staleness();
   table_info.row_type = create_table_msg.get_row_type();
   table_info.row_capacity = create_table_msg.get_row_capacity();
+  table_info.value_bound = create_table_msg.get_value_bound();
   server_context_->server_obj_.CreateTable(table_id, table_info);
 }
 
@@ -202,6 +229,7 @@ void ServerThreads::SetUpServerContext(){
   server_context_->bg_thread_ids_.resize(
     GlobalContext::get_num_total_bg_threads());
   server_context_->num_shutdown_bgs_ = 0;
+  server_context_->name_node_shutdown_acked_ = false;
 }
 
 void ServerThreads::SetUpCommBus() {
@@ -229,6 +257,11 @@ void ServerThreads::HandleRowRequest(int32_t sender_id,
   int32_t table_id = row_request_msg.get_table_id();
   int32_t row_id = row_request_msg.get_row_id();
   int32_t clock = row_request_msg.get_clock();
+  if (server_context_->server_obj_.IsRowMigrating(table_id, row_id)) {
+    server_context_->server_obj_.HoldRowRequest(sender_id, table_id, row_id,
+      clock);
+    return;
+  }
   int32_t server_clock = server_context_->server_obj_.GetMinClock();
   if (server_clock < clock) {
     //VLOG(0) << "server clock = " << server_clock
@@ -274,6 +307,103 @@ void ServerThreads::ReplyRowRequest(int32_t bg_id, ServerRow *server_row,
   MemTransfer::TransferMem(comm_bus_, bg_id, &server_row_request_reply_msg);
 }
 
+void ServerThreads::HandleBatchRowRequest(int32_t sender_id,
+  BatchRowRequestMsg &batch_row_request_msg) {
+  int32_t table_id = batch_row_request_msg.get_table_id();
+  int32_t clock = batch_row_request_msg.get_clock();
+  int32_t num_rows = batch_row_request_msg.get_num_rows();
+  const int32_t *row_ids = batch_row_request_msg.get_row_ids();
+  int32_t server_clock = server_context_->server_obj_.GetMinClock();
+  if (server_clock < clock) {
+    // All rows in the batch wait for the same clock and will be replied
+    // together once it is reached.
+    for (int32_t i = 0; i < num_rows; ++i) {
+      server_context_->server_obj_.AddRowRequest(sender_id, table_id,
+        row_ids[i], clock);
+    }
+    return;
+  }
+
+  std::vector<ServerRowRequest> requests;
+  for (int32_t i = 0; i < num_rows; ++i) {
+    if (server_context_->server_obj_.IsRowMigrating(table_id, row_ids[i])) {
+      server_context_->server_obj_.HoldRowRequest(sender_id, table_id,
+        row_ids[i], clock);
+      continue;
+    }
+    ServerRowRequest server_row_request;
+    server_row_request.bg_id = sender_id;
+    server_row_request.table_id = table_id;
+    server_row_request.row_id = row_ids[i];
+    server_row_request.clock = clock;
+    requests.push_back(server_row_request);
+  }
+  if (requests.empty())
+    return;
+  uint32_t version = server_context_->server_obj_.GetBgVersion(sender_id);
+  ReplyBatchRowRequest(sender_id, requests, server_clock, version);
+}
+
+void ServerThreads::ReplyBatchRowRequest(int32_t bg_id,
+  const std::vector<ServerRowRequest> &requests, int32_t server_clock,
+  uint32_t version) {
+  int32_t client_id = GlobalContext::thread_id_to_client_id(bg_id);
+  std::vector<ServerRow*> server_rows(requests.size());
+  size_t msg_size = 0;
+  for (size_t i = 0; i < requests.size(); ++i) {
+    server_rows[i] = server_context_->server_obj_.FindCreateRow(
+        requests[i].table_id, requests[i].row_id);
+    RowSubscribe(server_rows[i], client_id);
+    msg_size += sizeof(int32_t) + sizeof(int32_t) + sizeof(size_t)
+                + server_rows[i]->SerializedSize();
+  }
+
+  ServerBatchRowRequestReplyMsg batch_reply_msg(msg_size);
+  batch_reply_msg.get_clock() = server_clock;
+  batch_reply_msg.get_version() = version;
+  batch_reply_msg.get_num_rows() = requests.size();
+
+  // SerializedSize() is an upper bound, so rows are packed with their exact
+  // sizes and avai_size is trimmed afterwards.
+  uint8_t *mem = reinterpret_cast<uint8_t*>(batch_reply_msg.get_data());
+  size_t offset = 0;
+  for (size_t i = 0; i < requests.size(); ++i) {
+    *(reinterpret_cast<int32_t*>(mem + offset)) = requests[i].table_id;
+    offset += sizeof(int32_t);
+    *(reinterpret_cast<int32_t*>(mem + offset)) = requests[i].row_id;
+    offset += sizeof(int32_t);
+    size_t *row_size_ptr = reinterpret_cast<size_t*>(mem + offset);
+    offset += sizeof(size_t);
+    *row_size_ptr = server_rows[i]->Serialize(mem + offset);
+    offset += *row_size_ptr;
+  }
+  batch_reply_msg.get_avai_size() = offset;
+
+  MemTransfer::TransferMem(comm_bus_, bg_id, &batch_reply_msg);
+}
+
+void ServerThreads::ServeRowRequests(
+  const std::vector<ServerRowRequest> &requests) {
+  int32_t server_clock = server_context_->server_obj_.GetMinClock();
+  // Requests from the same bg thread are replied in one message.
+  std::map<int32_t, std::vector<ServerRowRequest> > bg_requests;
+  for (auto request_iter = requests.begin(); request_iter != requests.end();
+       request_iter++) {
+    if (request_iter->clock > server_clock) {
+      server_context_->server_obj_.AddRowRequest(request_iter->bg_id,
+        request_iter->table_id, request_iter->row_id, request_iter->clock);
+      continue;
+    }
+    bg_requests[request_iter->bg_id].push_back(*request_iter);
+  }
+  for (auto bg_iter = bg_requests.begin(); bg_iter != bg_requests.end();
+       bg_iter++) {
+    int32_t bg_id = bg_iter->first;
+    uint32_t version = server_context_->server_obj_.GetBgVersion(bg_id);
+    ReplyBatchRowRequest(bg_id, bg_iter->second, server_clock, version);
+  }
+}
+
 void ServerThreads::HandleOpLogMsg(int32_t sender_id,
   ClientSendOpLogMsg &client_send_oplog_msg) {
   int32_t client_id = client_send_oplog_msg.get_client_id();
@@ -281,30 +411,108 @@ void ServerThreads::HandleOpLogMsg(int32_t sender_id,
   uint32_t version = client_send_oplog_msg.get_version();
   server_context_->server_obj_.ApplyOpLog(client_send_oplog_msg.get_data(),
     sender_id, version);
+  if (GlobalContext::get_row_migration())
+    InstallDeferredMigratedRows();
 
+  bool clock_changed = false;
   if (is_clock) {
-    bool clock_changed
-      = server_context_->server_obj_.Clock(client_id, sender_id);
+    clock_changed = server_context_->server_obj_.Clock(client_id, sender_id);
     if (clock_changed) {
       std::vector<ServerRowRequest> requests;
       server_context_->server_obj_.GetFulfilledRowRequests(&requests);
-      for (auto request_iter = requests.begin();
-	   request_iter != requests.end(); request_iter++) {
-	int32_t table_id = request_iter->table_id;
-	int32_t row_id = request_iter->row_id;
-	int32_t bg_id = request_iter->bg_id;
-	int32_t version = server_context_->server_obj_.GetBgVersion(bg_id);
-	ServerRow *server_row
-	  = server_context_->server_obj_.FindCreateRow(table_id, row_id);
-        RowSubscribe(server_row,
-                     GlobalContext::thread_id_to_client_id(bg_id));
-	int32_t server_clock = server_context_->server_obj_.GetMinClock();
-	ReplyRowRequest(bg_id, server_row, table_id, row_id, server_clock,
-	  version);
-      }
+      ServeRowRequests(requests);
       ServerPushRow();
+      if (GlobalContext::get_row_migration()
+          && server_context_->server_obj_.GetMinClock()
+          % GlobalContext::get_row_migration_interval() == 0)
+        SendLoadReport();
     }
   }
+
+  if (!clock_changed)
+    ServerEarlyPushRow();
+}
+
+void ServerThreads::SendLoadReport() {
+  std::vector<RowLoad> hot_rows;
+  int64_t total_load = server_context_->server_obj_.GetAndResetLoads(
+      kNumHotRowsReported, &hot_rows);
+
+  ServerLoadReportMsg load_report_msg(hot_rows.size());
+  load_report_msg.get_total_load() = total_load;
+  int32_t *data = load_report_msg.get_data();
+  for (size_t i = 0; i < hot_rows.size(); ++i) {
+    data[3*i] = hot_rows[i].table_id;
+    data[3*i + 1] = hot_rows[i].row_id;
+    data[3*i + 2] = hot_rows[i].load;
+  }
+
+  int32_t name_node_id = GlobalContext::get_name_node_id();
+  size_t sent_size = (comm_bus_->*CommBusSendAny)(name_node_id,
+    load_report_msg.get_mem(), load_report_msg.get_size());
+  CHECK_EQ(sent_size, load_report_msg.get_size());
+}
+
+void ServerThreads::HandleRowMigrateAck(RowMigrateMsg &row_migrate_msg) {
+  int32_t my_id = ThreadContext::get_id();
+  int32_t version = row_migrate_msg.get_version();
+  const int32_t *rows = row_migrate_msg.get_data();
+  int32_t num_rows = row_migrate_msg.get_num_rows();
+
+  if (row_migrate_msg.get_dst_server_id() == my_id) {
+    server_context_->server_obj_.AckRowMigrateIn(version, rows, num_rows);
+    return;
+  }
+
+  CHECK_EQ(row_migrate_msg.get_src_server_id(), my_id);
+  bool all_acked = server_context_->server_obj_.AckRowMigrateOut(version,
+    rows, num_rows);
+  if (!all_acked)
+    return;
+
+  // No more updates or requests for the rows will come here; the name node
+  // relays them to the destination.
+  MigratedRowsMsg *migrated_rows_msg
+      = server_context_->server_obj_.CreateMigratedRowsMsg(version,
+          row_migrate_msg.get_dst_server_id());
+  int32_t name_node_id = GlobalContext::get_name_node_id();
+  size_t sent_size = (comm_bus_->*CommBusSendAny)(name_node_id,
+    migrated_rows_msg->get_mem(), migrated_rows_msg->get_size());
+  CHECK_EQ(sent_size, migrated_rows_msg->get_size());
+  delete migrated_rows_msg;
+}
+
+void ServerThreads::HandleMigratedRows(MigratedRowsMsg &migrated_rows_msg) {
+  std::vector<ServerRowRequest> requests;
+  bool installed = server_context_->server_obj_.InstallMigratedRows(
+      migrated_rows_msg, &requests);
+  if (!installed)
+    return;
+  ServeRowRequests(requests);
+  SendRowMigrateDone(migrated_rows_msg.get_version());
+}
+
+void ServerThreads::InstallDeferredMigratedRows() {
+  std::vector<ServerRowRequest> requests;
+  std::vector<int32_t> migration_versions;
+  server_context_->server_obj_.InstallDeferredMigratedRows(&requests,
+    &migration_versions);
+  if (migration_versions.empty())
+    return;
+  ServeRowRequests(requests);
+  for (auto version_iter = migration_versions.begin();
+       version_iter != migration_versions.end(); version_iter++) {
+    SendRowMigrateDone(*version_iter);
+  }
+}
+
+void ServerThreads::SendRowMigrateDone(int32_t version) {
+  RowMigrateDoneMsg row_migrate_done_msg;
+  row_migrate_done_msg.get_version() = version;
+  int32_t name_node_id = GlobalContext::get_name_node_id();
+  size_t sent_size = (comm_bus_->*CommBusSendAny)(name_node_id,
+    row_migrate_done_msg.get_mem(), row_migrate_done_msg.get_size());
+  CHECK_EQ(sent_size, row_migrate_done_msg.get_size());
 }
 
 void ServerThreads::CommBusRecvAnyBusy(int32_t *sender_id,
@@ -323,11 +531,19 @@ void ServerThreads::CommBusRecvAnySleep(int32_t *sender_id,
 void ServerThreads::SSPPushServerPushRow() {
   VLOG(0) << "SSPPushServerPushRow()";
   server_context_->server_obj_.CreateSendServerPushRowMsgs(
-      SendServerPushRowMsg);
+      SendServerPushRowMsg, true);
+}
+
+void ServerThreads::SSPPushValueBoundServerEarlyPushRow() {
+  if (!server_context_->server_obj_.HasRowsOverValueBound())
+    return;
+  VLOG(0) << "SSPPushValueBoundServerEarlyPushRow()";
+  server_context_->server_obj_.CreateSendServerPushRowMsgs(
+      SendServerPushRowMsg, false);
 }
 
 void ServerThreads::SendServerPushRowMsg(int32_t bg_id,
-  ServerPushRowMsg *msg, bool last_msg) {
+  ServerPushRowMsg *msg, bool last_msg, bool clock_changed) {
   //VLOG(0) << "msg = " << msg;
   //VLOG(0) << " msg->get_size() = " << msg->get_size()
   //      << " last_msg = " << last_msg;
@@ -335,7 +551,7 @@ void ServerThreads::SendServerPushRowMsg(int32_t bg_id,
   msg->get_version() = server_context_->server_obj_.GetBgVersion(bg_id);
   //VLOG(0) << "msg->get_version() set";
   if (last_msg) {
-    msg->get_is_clock() = true;
+    msg->get_is_clock() = clock_changed;
     msg->get_clock() = server_context_->server_obj_.GetMinClock();
     MemTransfer::TransferMem(comm_bus_, bg_id, msg);
   } else {
@@ -412,6 +628,12 @@ void *ServerThreads::ServerThreadMain(void *thread_id){
 	HandleRowRequest(sender_id, row_request_msg);
       }
       break;
+    case kBatchRowRequest:
+      {
+	BatchRowRequestMsg batch_row_request_msg(msg_mem);
+	HandleBatchRowRequest(sender_id, batch_row_request_msg);
+      }
+      break;
     case kClientSendOpLog:
       {
 	VLOG(0) << "Received OpLog Msg!";
@@ -421,6 +643,31 @@ void *ServerThreads::ServerThreadMain(void *thread_id){
 	TIMER_END(0, SERVER_HANDLE_OPLOG_MSG);
       }
       break;
+    case kRowMigrate:
+      {
+	RowMigrateMsg row_migrate_msg(msg_mem);
+	HandleRowMigrateAck(row_migrate_msg);
+      }
+      break;
+    case kMigratedRows:
+      {
+	MigratedRowsMsg migrated_rows_msg(msg_mem);
+	HandleMigratedRows(migrated_rows_msg);
+      }
+      break;
+    case kServerShutDownAck:
+      {
+	// From the name node, only if rows may be migrated.
+	server_context_->name_node_shutdown_acked_ = true;
+	bool shutdown = CheckShutDown();
+	if (shutdown) {
+          VLOG(0) << "Server shutdown";
+	  comm_bus_->ThreadDeregister();
+	  FINALIZE_STATS();
+	  return 0;
+	}
+      }
+      break;
     default:
       LOG(FATAL) << "Unrecognized message type " << msg_type;
     }
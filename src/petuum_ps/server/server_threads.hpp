@@ -26,6 +26,9 @@ private:
     std::vector<int32_t> bg_thread_ids_;
     Server server_obj_;
     int32_t num_shutdown_bgs_;
+    // Set when the name node allows shutting down, which is only awaited if
+    // rows may be migrated.
+    bool name_node_shutdown_acked_;
   };
 
   static void *ServerThreadMain(void *server_thread_info);
@@ -37,6 +40,12 @@ private:
   typedef void (*ServerPushRowFunc)();
   static ServerPushRowFunc ServerPushRow;
 
+  // Invoked after an oplog message is applied without advancing the server
+  // clock. Only SSPPushValueBound pushes rows at that point.
+  static void SSPPushValueBoundServerEarlyPushRow();
+  static void SSPServerEarlyPushRow() { }
+  static ServerPushRowFunc ServerEarlyPushRow;
+
   typedef void (*RowSubscribeFunc)(ServerRow *server_row, int32_t client_id);
   static RowSubscribeFunc RowSubscribe;
   static void SSPRowSubscribe(ServerRow *server_row, int32_t client_id) {}
@@ -56,17 +65,40 @@ private:
 
   static void SendToAllBgThreads(void *msg, size_t msg_size);
   static bool HandleShutDownMsg(); // returns true if the server may shut down
+  // Acknowledges shut down to all bg threads once all of them have shut
+  // down and, if rows may be migrated, the name node has acknowledged that
+  // no migration is in progress. Returns true if the server may shut down.
+  static bool CheckShutDown();
   static void HandleCreateTable(int32_t sender_id,
     CreateTableMsg &create_table_msg);
   static void HandleRowRequest(int32_t sender_id,
     RowRequestMsg &row_request_msg);
   static void ReplyRowRequest(int32_t bg_id, ServerRow *server_row,
     int32_t table_id, int32_t row_id, int32_t server_clock, uint32_t version);
+  static void HandleBatchRowRequest(int32_t sender_id,
+    BatchRowRequestMsg &batch_row_request_msg);
+  // Reply all requests (from bg_id) in one message.
+  static void ReplyBatchRowRequest(int32_t bg_id,
+    const std::vector<ServerRowRequest> &requests, int32_t server_clock,
+    uint32_t version);
+  // Reply requests whose clock is reached (requests from the same bg thread
+  // in one message) and queue the others.
+  static void ServeRowRequests(const std::vector<ServerRowRequest> &requests);
   static void HandleOpLogMsg(int32_t sender_id,
     ClientSendOpLogMsg &client_send_oplog_msg);
 
+  /* Row migration */
+  static void SendLoadReport();
+  static void HandleRowMigrateAck(RowMigrateMsg &row_migrate_msg);
+  static void HandleMigratedRows(MigratedRowsMsg &migrated_rows_msg);
+  // Install migrated rows that waited for the oplog just applied.
+  static void InstallDeferredMigratedRows();
+  static void SendRowMigrateDone(int32_t version);
+  // Maximum number of hot rows in a load report.
+  static const int32_t kNumHotRowsReported = 32;
+
   static void SendServerPushRowMsg (int32_t bg_id, ServerPushRowMsg *msg,
-                                    bool last_msg);
+                                    bool last_msg, bool clock_changed);
 
   static pthread_barrier_t init_barrier;
   static std::vector<pthread_t> threads_;
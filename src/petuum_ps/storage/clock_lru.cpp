@@ -8,11 +8,10 @@ const int32_t ClockLRU::MAX_NUM_ROUNDS = 3;
 ClockLRU::ClockLRU(int capacity) :
   capacity_(capacity), evict_hand_(0), insert_hand_(0),
   locks_(GlobalContext::get_lock_pool_size()),
-  stale_(new std::atomic_flag[capacity]),
+  stale_(new std::atomic<bool>[capacity]),
   row_ids_(capacity) {
     for (int i = 0; i < capacity_; ++i) {
-      // Default constructor for atomic_flag initialize to unspecified state.
-      stale_[i].test_and_set();
+      stale_[i].store(true);
       row_ids_[i] = -1;
     }
   }
@@ -24,7 +23,7 @@ int32_t ClockLRU::FindOneToEvict() {
     int32_t slot = evict_hand_++ % capacity_;
 
     // Check recency.
-    if (!stale_[slot].test_and_set()) {
+    if (!stale_[slot].exchange(true)) {
       // slot is recent. Set it to stale and skip it.
       continue;
     }
@@ -66,13 +65,16 @@ void ClockLRU::NoEvict(int32_t slot) {
 int32_t ClockLRU::Insert(int32_t row_id) {
   Unlocker<SpinMutex> unlocker;
   int32_t slot = FindEmptySlot(&unlocker);
-  stale_[slot].clear();
+  stale_[slot].store(false);
   row_ids_[slot] = row_id;
   return slot;
 }
 
 void ClockLRU::Reference(int32_t slot) {
-  stale_[slot].clear();
+  // Only write when the flag changes: hot rows are referenced on every read,
+  // and an unconditional store would keep bouncing the cache line.
+  if (stale_[slot].load(std::memory_order_relaxed))
+    stale_[slot].store(false, std::memory_order_relaxed);
 }
 
 int32_t ClockLRU::FindEmptySlot(
@@ -83,7 +83,7 @@ private:    // private members
 
   // staled_[i] is set to false if the row in slot i is referenced. It's
   // set to true when the evict_hand_ comes around.
-  std::unique_ptr<std::atomic_flag[]> stale_;
+  std::unique_ptr<std::atomic<bool>[]> stale_;
 
   // Store associated row_id needed during eviction. -1 implies empty.
   std::vector<int32_t> row_ids_;
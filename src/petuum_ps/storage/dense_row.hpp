@@ -7,8 +7,10 @@
 #include <string.h>
 #include <assert.h>
 #include <boost/noncopyable.hpp>
+#include <glog/logging.h>
 
 #include "petuum_ps/util/lock.hpp"
+#include "petuum_ps/util/vector_kernels.hpp"
 #include "petuum_ps/include/abstract_row.hpp"
 
 namespace petuum {
@@ -38,18 +40,48 @@ public:
   void ApplyBatchIncUnsafe(const int32_t *column_ids,
     const void* update_batch, int32_t num_updates);
 
+  void ApplyDenseBatchInc(const void* update_batch, int32_t num_updates);
+  void ApplyDenseBatchIncUnsafe(const void* update_batch,
+    int32_t num_updates);
+
+  double GetUpdatesMagnitude(const int32_t *column_ids,
+    const void* update_batch, int32_t num_updates) const {
+    return SumAbsUpdates<V>(update_batch, num_updates);
+  }
+
   void AddUpdates(int32_t column_id, void *update1,
     const void *update2) const;
 
   void SubtractUpdates(int32_t column_id, void *update1,
     const void *update2) const;
 
+  void AddDenseUpdates(void *updates1, const void *updates2,
+    int32_t num_updates) const;
+
   void InitUpdate(int32_t column_id, void *update) const;
 
+  bool HasDenseUpdates() const {
+    return true;
+  }
+
+  // Element and span reads do not take smtx_. A row obtained through a
+  // RowAccessor is never resized or freed while the accessor is alive (a
+  // fresher row replaces it via ClientRow::SwapAndDestroy()), so the
+  // pointer returned by GetData() is valid for get_capacity() elements
+  // during the RowAccessor's lifetime. Concurrent Inc() from other threads
+  // on the same row may or may not be visible.
   V operator [](int32_t column_id) const;
-  int32_t get_capacity();
+  const V *GetData() const;
+  int32_t get_capacity() const;
   void CopyToVector(std::vector<V> *to) const;
 private:
+  // Runs of at least kMinVectorRun consecutive column ids are applied with
+  // AddArray(); shorter runs use the scalar loop.
+  static const int32_t kMinVectorRun = 8;
+
+  void ApplyBatchIncNoLock(const int32_t *column_ids, const V *update_array,
+    int32_t num_updates);
+
   mutable SharedMutex smtx_;
   std::vector<V> data_;
   int32_t capacity_;
@@ -118,10 +150,7 @@ void DenseRow<V>::ApplyBatchInc(const int32_t *column_ids,
   const V *update_array = reinterpret_cast<const V*>(update_batch);
 
   std::unique_lock<SharedMutex> write_lock(smtx_);
-  int i;
-  for(i = 0; i < num_updates; ++i){
-    data_[column_ids[i]] += update_array[i];
-  }
+  ApplyBatchIncNoLock(column_ids, update_array, num_updates);
 }
 
 template<typename V>
@@ -134,13 +163,44 @@ template<typename V>
 void DenseRow<V>::ApplyBatchIncUnsafe(const int32_t *column_ids,
   const void *update_batch, int32_t num_updates){
   const V *update_array = reinterpret_cast<const V*>(update_batch);
-  int i;
-  for(i = 0; i < num_updates; ++i){
-    data_[column_ids[i]] += update_array[i];
-    //VLOG(0) << "Increment " << column_ids[i] << " by " << update_array[i];
-  }
+  ApplyBatchIncNoLock(column_ids, update_array, num_updates);
 }
 
+template<typename V>
+void DenseRow<V>::ApplyDenseBatchInc(const void *update_batch,
+  int32_t num_updates) {
+  assert(num_updates <= (int32_t) data_.size());
+  std::unique_lock<SharedMutex> write_lock(smtx_);
+  AddArray(data_.data(), reinterpret_cast<const V*>(update_batch),
+           num_updates);
+}
+
+template<typename V>
+void DenseRow<V>::ApplyDenseBatchIncUnsafe(const void *update_batch,
+  int32_t num_updates) {
+  assert(num_updates <= (int32_t) data_.size());
+  AddArray(data_.data(), reinterpret_cast<const V*>(update_batch),
+           num_updates);
+}
+
+template<typename V>
+void DenseRow<V>::ApplyBatchIncNoLock(const int32_t *column_ids,
+  const V *update_array, int32_t num_updates) {
+  V *data = data_.data();
+  int32_t i = 0;
+  while (i < num_updates) {
+    int32_t run_length = GetContiguousRunLength(column_ids + i,
+                                                num_updates - i);
+    if (run_length >= kMinVectorRun) {
+      AddArray(data + column_ids[i], update_array + i, run_length);
+    } else {
+      for (int32_t j = i; j < i + run_length; ++j) {
+        data[column_ids[j]] += update_array[j];
+      }
+    }
+    i += run_length;
+  }
+}
 
 template<typename V>
 void DenseRow<V>::AddUpdates(int32_t column_id, void *update1,
@@ -154,6 +214,13 @@ void DenseRow<V>::SubtractUpdates(int32_t column_id, void *update1,
   *(reinterpret_cast<V*>(update1)) -= *(reinterpret_cast<const V*>(update2));
 }
 
+template<typename V>
+void DenseRow<V>::AddDenseUpdates(void *updates1, const void *updates2,
+  int32_t num_updates) const {
+  AddArray(reinterpret_cast<V*>(updates1),
+           reinterpret_cast<const V*>(updates2), num_updates);
+}
+
 template<typename V>
 void DenseRow<V>::InitUpdate(int32_t column_id, void *update) const {
   *(reinterpret_cast<V*>(update)) = V(0);
@@ -161,14 +228,16 @@ void DenseRow<V>::InitUpdate(int32_t column_id, void *update) const {
 
 template<typename V>
 V DenseRow<V>::operator [](int32_t column_id) const {
-  boost::shared_lock<SharedMutex> read_lock(smtx_);
-  VLOG(0) << "my capacity = " << capacity_;
-  V v = data_[column_id];
-  return v;
+  return data_[column_id];
+}
+
+template<typename V>
+const V *DenseRow<V>::GetData() const {
+  return data_.data();
 }
 
 template<typename V>
-int32_t DenseRow<V>::get_capacity(){
+int32_t DenseRow<V>::get_capacity() const {
   return capacity_;
 }
 
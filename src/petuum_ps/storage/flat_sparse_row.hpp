@@ -0,0 +1,426 @@
+#pragma once
+
+#include "petuum_ps/include/abstract_row.hpp"
+#include "petuum_ps/util/lock.hpp"
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <glog/logging.h>
+
+namespace petuum {
+
+// Multi-threaded sparse row with unbounded # of columns, a drop-in
+// alternative to SparseRow. Entries are kept in two flat arrays sorted on
+// column id (column ids and values), so lookups are binary searches,
+// iteration is sequential, and (de)serialization is two memcpy's. Zero
+// entries are never stored: updates that cancel an entry remove it.
+//
+// ApplyBatchInc() merges the update batch into the arrays in one linear pass
+// when the column ids of the batch are sorted; unsorted batches are sorted
+// first.
+template<typename V>
+class FlatSparseRow : public AbstractRow, boost::noncopyable {
+public:
+  FlatSparseRow() { }
+  ~FlatSparseRow() { }
+
+  // Entry-wide read by acquiring read lock. Use the iterator to traverse the
+  // row.
+  V operator[](int32_t col_id) const;
+
+  // Number of (non-zero) entries.
+  int32_t num_entries() const;
+
+public:  // Iterator
+  // const_iterator lets you do this:
+  //
+  //  FlatSparseRow<int> row;
+  //  ... fill in some entries ...
+  //  for (FlatSparseRow<int>::const_iterator it = row.cbegin();
+  //    !it.is_end(); ++it) {
+  //    int key = it->first;
+  //    int val = it->second;
+  //    int same_value = *it;
+  //  }
+  //
+  // Notice the is_end() in for loop. You can't use the == operator.
+  class const_iterator {
+  public:
+    struct EntryRef {
+      int32_t first;
+      V second;
+    };
+
+    // The dereference operator returns the value of the entry under the
+    // iterator. It fails if the iterator is already at the end.
+    V operator*();
+
+    // Returns a pointer to a copy of the (column id, value) pair under the
+    // iterator, valid until the iterator is moved.
+    const EntryRef* operator->();
+
+    const_iterator* operator++();
+
+    const_iterator* operator++(int);
+
+    bool is_end();
+
+  private:
+    // const_iterator holds shared_lock on the associated FlatSparseRow
+    // throughout iterator lifetime.
+    boost::shared_lock<SharedMutex> read_lock_;
+
+    //  Only let FlatSparseRow to construct const_iterator.
+    const_iterator(const FlatSparseRow<V>& row, bool is_end);
+    friend class FlatSparseRow<V>;
+
+    const FlatSparseRow<V>* row_;
+    size_t curr_;
+    EntryRef entry_;
+  };
+
+public:  // iterator functions.
+  const_iterator cbegin() const;
+
+  const_iterator cend() const;
+
+public:  // AbstractRow implementation
+  // capacity is the number of columns, which sparse rows seldom fill. The
+  // arrays grow as entries are inserted.
+  void Init(int32_t capacity) { }
+
+  AbstractRow *Clone() const;
+
+  size_t get_update_size() const {
+    return sizeof(V);
+  }
+
+  size_t SerializedSize() const;
+
+  // Layout: all column ids (int32_t) followed by all values (V).
+  size_t Serialize(void* bytes) const;
+
+  bool Deserialize(const void* data, size_t num_bytes);
+
+  void ApplyInc(int32_t column_id, const void *update);
+
+  void ApplyBatchInc(const int32_t *column_ids,
+    const void *update_batch, int32_t num_updates);
+
+  void ApplyIncUnsafe(int32_t column_id, const void *update);
+
+  void ApplyBatchIncUnsafe(const int32_t *column_ids,
+    const void* update_batch, int32_t num_updates);
+
+  double GetUpdatesMagnitude(const int32_t *column_ids,
+    const void* update_batch, int32_t num_updates) const {
+    return SumAbsUpdates<V>(update_batch, num_updates);
+  }
+
+  void AddUpdates(int32_t column_id, void* update1,
+    const void *update2) const;
+
+  void SubtractUpdates(int32_t column_id, void *update1,
+    const void *update2) const;
+
+  void InitUpdate(int32_t column_id, void* zero) const;
+
+private:
+  friend class const_iterator;
+
+  // Batches no larger than this are applied entry by entry; larger batches
+  // are merged.
+  static const int32_t kMaxPointUpdates = 4;
+
+  // Merge the (col_ids, updates) batch, sorted on strictly increasing column
+  // ids, into col_ids_ and values_.
+  void MergeSortedUpdates(const int32_t *col_ids, const V *updates,
+    int32_t num_updates);
+
+  // Sorted on column id; values_[i] is the value of column col_ids_[i].
+  std::vector<int32_t> col_ids_;
+  std::vector<V> values_;
+
+  // Merge output buffers, swapped with col_ids_ and values_ after each merge
+  // so their memory is reused.
+  std::vector<int32_t> merge_col_ids_;
+  std::vector<V> merge_values_;
+
+  mutable SharedMutex rw_mutex_;
+
+  // zero for type V.
+  static const V zero_;
+};
+
+// ================= Implementation =================
+
+template<typename V>
+const V FlatSparseRow<V>::zero_ = V(0);
+
+template<typename V>
+V FlatSparseRow<V>::operator[](int32_t col_id) const {
+  boost::shared_lock<SharedMutex> read_lock(rw_mutex_);
+  auto it = std::lower_bound(col_ids_.cbegin(), col_ids_.cend(), col_id);
+  if (it == col_ids_.cend() || *it != col_id) {
+    return zero_;
+  }
+  return values_[it - col_ids_.cbegin()];
+}
+
+template<typename V>
+int32_t FlatSparseRow<V>::num_entries() const {
+  boost::shared_lock<SharedMutex> read_lock(rw_mutex_);
+  return col_ids_.size();
+}
+
+// ======== const_iterator Implementation ========
+
+template<typename V>
+FlatSparseRow<V>::const_iterator::const_iterator(const FlatSparseRow<V>& row,
+    bool is_end) : read_lock_(row.rw_mutex_), row_(&row),
+                   curr_(is_end ? row.col_ids_.size() : 0) { }
+
+template<typename V>
+V FlatSparseRow<V>::const_iterator::operator*() {
+  CHECK(!is_end());
+  return row_->values_[curr_];
+}
+
+template<typename V>
+const typename FlatSparseRow<V>::const_iterator::EntryRef*
+FlatSparseRow<V>::const_iterator::operator->() {
+  CHECK(!is_end());
+  entry_.first = row_->col_ids_[curr_];
+  entry_.second = row_->values_[curr_];
+  return &entry_;
+}
+
+template<typename V>
+typename FlatSparseRow<V>::const_iterator*
+FlatSparseRow<V>::const_iterator::operator++() {
+  CHECK(!is_end());
+  ++curr_;
+  return this;
+}
+
+template<typename V>
+typename FlatSparseRow<V>::const_iterator*
+FlatSparseRow<V>::const_iterator::operator++(int unused) {
+  CHECK(!is_end());
+  ++curr_;
+  return this;
+}
+
+template<typename V>
+bool FlatSparseRow<V>::const_iterator::is_end() {
+  return (curr_ == row_->col_ids_.size());
+}
+
+template<typename V>
+typename FlatSparseRow<V>::const_iterator FlatSparseRow<V>::cbegin() const {
+  return const_iterator(*this, false);
+}
+
+template<typename V>
+typename FlatSparseRow<V>::const_iterator FlatSparseRow<V>::cend() const {
+  return const_iterator(*this, true);
+}
+
+// ======== AbstractRow Implementation ========
+
+template<typename V>
+AbstractRow *FlatSparseRow<V>::Clone() const {
+  boost::shared_lock<SharedMutex> read_lock(rw_mutex_);
+  FlatSparseRow<V> *new_row = new FlatSparseRow<V>();
+  new_row->col_ids_ = col_ids_;
+  new_row->values_ = values_;
+  return static_cast<AbstractRow*>(new_row);
+}
+
+template<typename V>
+size_t FlatSparseRow<V>::SerializedSize() const {
+  return col_ids_.size() * (sizeof(int32_t) + sizeof(V));
+}
+
+template<typename V>
+size_t FlatSparseRow<V>::Serialize(void* bytes) const {
+  uint8_t *mem = reinterpret_cast<uint8_t*>(bytes);
+  size_t num_entries = col_ids_.size();
+  // data() of an empty vector may be null.
+  if (num_entries > 0) {
+    memcpy(mem, col_ids_.data(), num_entries * sizeof(int32_t));
+    memcpy(mem + num_entries * sizeof(int32_t), values_.data(),
+           num_entries * sizeof(V));
+  }
+  return SerializedSize();
+}
+
+template<typename V>
+bool FlatSparseRow<V>::Deserialize(const void* data, size_t num_bytes) {
+  size_t num_bytes_per_entry = (sizeof(int32_t) + sizeof(V));
+  CHECK_EQ(0, num_bytes % num_bytes_per_entry) << "num_bytes = " << num_bytes;
+
+  size_t num_entries = num_bytes / num_bytes_per_entry;
+  const uint8_t *mem = reinterpret_cast<const uint8_t*>(data);
+  col_ids_.resize(num_entries);
+  values_.resize(num_entries);
+  if (num_entries > 0) {
+    memcpy(col_ids_.data(), mem, num_entries * sizeof(int32_t));
+    memcpy(values_.data(), mem + num_entries * sizeof(int32_t),
+           num_entries * sizeof(V));
+  }
+  return true;
+}
+
+template<typename V>
+void FlatSparseRow<V>::ApplyInc(int32_t column_id, const void *update) {
+  std::unique_lock<SharedMutex> write_lock(rw_mutex_);
+  ApplyIncUnsafe(column_id, update);
+}
+
+template<typename V>
+void FlatSparseRow<V>::ApplyBatchInc(const int32_t *column_ids,
+  const void *update_batch, int32_t num_updates) {
+  std::unique_lock<SharedMutex> write_lock(rw_mutex_);
+  ApplyBatchIncUnsafe(column_ids, update_batch, num_updates);
+}
+
+template<typename V>
+void FlatSparseRow<V>::ApplyIncUnsafe(int32_t column_id, const void *update) {
+  const V typed_update = *(reinterpret_cast<const V*>(update));
+  auto it = std::lower_bound(col_ids_.begin(), col_ids_.end(), column_id);
+  size_t idx = it - col_ids_.begin();
+  if (it != col_ids_.end() && *it == column_id) {
+    values_[idx] += typed_update;
+    if (values_[idx] == zero_) {
+      // remove 0 entry.
+      col_ids_.erase(it);
+      values_.erase(values_.begin() + idx);
+    }
+    return;
+  }
+  if (typed_update == zero_)
+    return;
+  col_ids_.insert(it, column_id);
+  values_.insert(values_.begin() + idx, typed_update);
+}
+
+template<typename V>
+void FlatSparseRow<V>::ApplyBatchIncUnsafe(const int32_t *column_ids,
+    const void* update_batch, int32_t num_updates) {
+  const V* typed_updates = reinterpret_cast<const V*>(update_batch);
+  if (num_updates <= kMaxPointUpdates) {
+    for (int32_t i = 0; i < num_updates; ++i) {
+      ApplyIncUnsafe(column_ids[i], typed_updates + i);
+    }
+    return;
+  }
+
+  bool sorted = true;
+  for (int32_t i = 1; i < num_updates; ++i) {
+    if (column_ids[i - 1] >= column_ids[i]) {
+      sorted = false;
+      break;
+    }
+  }
+  if (sorted) {
+    MergeSortedUpdates(column_ids, typed_updates, num_updates);
+    return;
+  }
+
+  // Sort the batch and combine updates to the same column.
+  std::vector<std::pair<int32_t, V> > batch(num_updates);
+  for (int32_t i = 0; i < num_updates; ++i) {
+    batch[i] = std::make_pair(column_ids[i], typed_updates[i]);
+  }
+  std::stable_sort(batch.begin(), batch.end(),
+    [](const std::pair<int32_t, V> &a, const std::pair<int32_t, V> &b) {
+      return a.first < b.first; });
+  std::vector<int32_t> sorted_col_ids;
+  std::vector<V> sorted_updates;
+  sorted_col_ids.reserve(num_updates);
+  sorted_updates.reserve(num_updates);
+  for (int32_t i = 0; i < num_updates; ++i) {
+    if (!sorted_col_ids.empty() && sorted_col_ids.back() == batch[i].first) {
+      sorted_updates.back() += batch[i].second;
+    } else {
+      sorted_col_ids.push_back(batch[i].first);
+      sorted_updates.push_back(batch[i].second);
+    }
+  }
+  MergeSortedUpdates(sorted_col_ids.data(), sorted_updates.data(),
+                     sorted_col_ids.size());
+}
+
+template<typename V>
+void FlatSparseRow<V>::MergeSortedUpdates(const int32_t *col_ids,
+  const V *updates, int32_t num_updates) {
+  size_t num_entries = col_ids_.size();
+  merge_col_ids_.resize(num_entries + num_updates);
+  merge_values_.resize(num_entries + num_updates);
+
+  size_t i = 0, j = 0, k = 0;
+  while (i < num_entries && j < (size_t) num_updates) {
+    if (col_ids_[i] < col_ids[j]) {
+      merge_col_ids_[k] = col_ids_[i];
+      merge_values_[k++] = values_[i++];
+    } else if (col_ids[j] < col_ids_[i]) {
+      if (updates[j] != zero_) {
+        merge_col_ids_[k] = col_ids[j];
+        merge_values_[k++] = updates[j];
+      }
+      ++j;
+    } else {
+      V val = values_[i++] + updates[j];
+      if (val != zero_) {
+        merge_col_ids_[k] = col_ids[j];
+        merge_values_[k++] = val;
+      }
+      ++j;
+    }
+  }
+  for (; i < num_entries; ++i, ++k) {
+    merge_col_ids_[k] = col_ids_[i];
+    merge_values_[k] = values_[i];
+  }
+  for (; j < (size_t) num_updates; ++j) {
+    if (updates[j] != zero_) {
+      merge_col_ids_[k] = col_ids[j];
+      merge_values_[k++] = updates[j];
+    }
+  }
+  merge_col_ids_.resize(k);
+  merge_values_.resize(k);
+  col_ids_.swap(merge_col_ids_);
+  values_.swap(merge_values_);
+}
+
+template<typename V>
+void FlatSparseRow<V>::AddUpdates(int32_t column_id, void* update1,
+  const void* update2) const {
+  // Ignore column_id
+  V* typed_update1 = reinterpret_cast<V*>(update1);
+  const V* typed_update2 = reinterpret_cast<const V*>(update2);
+  *typed_update1 += *typed_update2;
+}
+
+template<typename V>
+void FlatSparseRow<V>::SubtractUpdates(int32_t column_id, void* update1,
+  const void* update2) const {
+  // Ignore column_id
+  V* typed_update1 = reinterpret_cast<V*>(update1);
+  const V* typed_update2 = reinterpret_cast<const V*>(update2);
+  *typed_update1 -= *typed_update2;
+}
+
+template<typename V>
+void FlatSparseRow<V>::InitUpdate(int32_t column_id, void* zero) const {
+  V* typed_zero = reinterpret_cast<V*>(zero);
+  *typed_zero = zero_;
+}
+
+}  // namespace petuum
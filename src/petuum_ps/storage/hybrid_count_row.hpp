@@ -0,0 +1,588 @@
+#pragma once
+
+#include "petuum_ps/include/abstract_row.hpp"
+#include "petuum_ps/util/lock.hpp"
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <glog/logging.h>
+
+namespace petuum {
+
+// Count row (e.g. word-topic counts in LDA) over columns [0, capacity) that
+// keeps each row in the cheaper of two forms depending on its occupancy:
+//
+// - sparse: non-zero entries in two arrays sorted on column id (binary
+//   search lookup);
+// - dense: a capacity-long array of counts, indexed by column id.
+//
+// A row becomes dense once more than capacity / kDenseFraction columns are
+// non-zero and goes back to sparse when fewer than capacity /
+// (2 * kDenseFraction) are. Ordering by value is only built when the row is
+// first iterated; from then on each increment moves just the changed entry,
+// which for +/-1 updates is usually a single swap within a run of equal
+// counts.
+//
+// If capacity is 0 (unknown), the row always stays sparse.
+template<typename V>
+class HybridCountRow : public AbstractRow, boost::noncopyable {
+public:
+  HybridCountRow();
+  ~HybridCountRow() { }
+
+  V operator[](int32_t col_id) const;
+
+  // Number of (non-zero) entries.
+  int32_t num_entries() const;
+
+  bool is_dense() const;
+
+public:  // Iterator
+  // Iterates the non-zero entries in descending order of value:
+  //
+  //  for (HybridCountRow<int>::const_iterator it = row.cbegin();
+  //    !it.is_end(); ++it) {
+  //    int key = it->first;
+  //    int val = it->second;
+  //  }
+  //
+  // The sorted order is computed on the first cbegin() and kept up to date
+  // by later increments, except across a switch between the sparse and the
+  // dense form or a batch longer than the row.
+  class const_iterator {
+  public:
+    typedef const std::pair<int32_t, V>* iter_t;
+
+    V operator*();
+
+    iter_t operator->();
+
+    const_iterator* operator++();
+
+    const_iterator* operator++(int);
+
+    bool is_end();
+
+  private:
+    // const_iterator holds shared_lock on the associated HybridCountRow
+    // throughout iterator lifetime.
+    boost::shared_lock<SharedMutex> read_lock_;
+
+    //  Only let HybridCountRow to construct const_iterator.
+    const_iterator(const HybridCountRow<V>& row, bool is_end);
+    friend class HybridCountRow<V>;
+
+    const std::vector<std::pair<int32_t, V> > *sorted_entries_;
+    size_t curr_;
+  };
+
+public:  // iterator functions.
+  const_iterator cbegin() const;
+
+  const_iterator cend() const;
+
+public:  // AbstractRow implementation
+  // capacity is the number of columns (e.g. number of topics).
+  void Init(int32_t capacity);
+
+  AbstractRow *Clone() const;
+
+  size_t get_update_size() const {
+    return sizeof(V);
+  }
+
+  size_t SerializedSize() const;
+
+  // Layout: int32_t capacity, int32_t number of entries, then the column ids
+  // (int32_t) and then the values (V) of the non-zero entries in column
+  // order.
+  size_t Serialize(void* bytes) const;
+
+  bool Deserialize(const void* data, size_t num_bytes);
+
+  void ApplyInc(int32_t column_id, const void *update);
+
+  void ApplyBatchInc(const int32_t *column_ids,
+    const void *update_batch, int32_t num_updates);
+
+  void ApplyIncUnsafe(int32_t column_id, const void *update);
+
+  void ApplyBatchIncUnsafe(const int32_t *column_ids,
+    const void* update_batch, int32_t num_updates);
+
+  double GetUpdatesMagnitude(const int32_t *column_ids,
+    const void* update_batch, int32_t num_updates) const {
+    return SumAbsUpdates<V>(update_batch, num_updates);
+  }
+
+  void AddUpdates(int32_t column_id, void* update1,
+    const void *update2) const;
+
+  void SubtractUpdates(int32_t column_id, void *update1,
+    const void *update2) const;
+
+  void InitUpdate(int32_t column_id, void* zero) const;
+
+private:
+  friend class const_iterator;
+
+  static const int32_t kDenseFraction = 8;
+
+  void IncOne(int32_t column_id, V update);
+
+  // Move column_id, whose count changed from old_count to new_count, to its
+  // place in sorted_entries_ (out of it if new_count is 0). Caller holds
+  // the write lock, sorted_valid_ is true, and in sparse form column_id is
+  // in col_ids_.
+  void UpdateSortedEntry(int32_t column_id, V old_count, V new_count);
+
+  // Move sorted_entries_[from] to position to, shifting the entries in
+  // between.
+  void MoveSortedEntry(int32_t from, int32_t to);
+
+  // Slot in sorted_pos_ of column_id.
+  int32_t &SortedPos(int32_t column_id) const;
+
+  // Convert between the two forms.
+  void ToDense();
+  void ToSparse();
+
+  // Fill sorted_entries_ if it is stale. Caller holds (at least) the shared
+  // lock.
+  void BuildSortedEntries() const;
+
+  int32_t capacity_;
+  int32_t num_entries_;
+  bool dense_;
+
+  // Dense form.
+  std::vector<V> counts_;
+
+  // Sparse form, sorted on column id.
+  std::vector<int32_t> col_ids_;
+  std::vector<V> values_;
+
+  // Non-zero entries sorted by value in descending order, built lazily by
+  // cbegin(). sorted_mtx_ serializes concurrent rebuilds by readers.
+  mutable std::vector<std::pair<int32_t, V> > sorted_entries_;
+  // Index of each entry in sorted_entries_: by column id in dense form,
+  // aligned with col_ids_ in sparse form. Only meaningful while
+  // sorted_valid_.
+  mutable std::vector<int32_t> sorted_pos_;
+  mutable bool sorted_valid_;
+  mutable std::mutex sorted_mtx_;
+
+  mutable SharedMutex rw_mutex_;
+
+  static const V zero_;
+};
+
+// ================= Implementation =================
+
+template<typename V>
+const V HybridCountRow<V>::zero_ = V(0);
+
+template<typename V>
+HybridCountRow<V>::HybridCountRow():
+  capacity_(0),
+  num_entries_(0),
+  dense_(false),
+  sorted_valid_(true) { }
+
+template<typename V>
+V HybridCountRow<V>::operator[](int32_t col_id) const {
+  boost::shared_lock<SharedMutex> read_lock(rw_mutex_);
+  if (dense_)
+    return counts_[col_id];
+  auto it = std::lower_bound(col_ids_.cbegin(), col_ids_.cend(), col_id);
+  if (it == col_ids_.cend() || *it != col_id)
+    return zero_;
+  return values_[it - col_ids_.cbegin()];
+}
+
+template<typename V>
+int32_t HybridCountRow<V>::num_entries() const {
+  boost::shared_lock<SharedMutex> read_lock(rw_mutex_);
+  return num_entries_;
+}
+
+template<typename V>
+bool HybridCountRow<V>::is_dense() const {
+  boost::shared_lock<SharedMutex> read_lock(rw_mutex_);
+  return dense_;
+}
+
+// ======== const_iterator Implementation ========
+
+template<typename V>
+HybridCountRow<V>::const_iterator::const_iterator(
+    const HybridCountRow<V>& row, bool is_end) :
+  read_lock_(row.rw_mutex_),
+  sorted_entries_(&row.sorted_entries_) {
+  row.BuildSortedEntries();
+  curr_ = is_end ? sorted_entries_->size() : 0;
+}
+
+template<typename V>
+V HybridCountRow<V>::const_iterator::operator*() {
+  CHECK(!is_end());
+  return (*sorted_entries_)[curr_].second;
+}
+
+template<typename V>
+typename HybridCountRow<V>::const_iterator::iter_t
+HybridCountRow<V>::const_iterator::operator->() {
+  CHECK(!is_end());
+  return &((*sorted_entries_)[curr_]);
+}
+
+template<typename V>
+typename HybridCountRow<V>::const_iterator*
+HybridCountRow<V>::const_iterator::operator++() {
+  CHECK(!is_end());
+  ++curr_;
+  return this;
+}
+
+template<typename V>
+typename HybridCountRow<V>::const_iterator*
+HybridCountRow<V>::const_iterator::operator++(int unused) {
+  CHECK(!is_end());
+  ++curr_;
+  return this;
+}
+
+template<typename V>
+bool HybridCountRow<V>::const_iterator::is_end() {
+  return (curr_ == sorted_entries_->size());
+}
+
+template<typename V>
+typename HybridCountRow<V>::const_iterator HybridCountRow<V>::cbegin() const {
+  return const_iterator(*this, false);
+}
+
+template<typename V>
+typename HybridCountRow<V>::const_iterator HybridCountRow<V>::cend() const {
+  return const_iterator(*this, true);
+}
+
+// ================ Private Methods =================
+
+template<typename V>
+void HybridCountRow<V>::IncOne(int32_t column_id, V update) {
+  if (dense_) {
+    V &count = counts_[column_id];
+    V old_count = count;
+    bool was_zero = (count == zero_);
+    count += update;
+    if (sorted_valid_ && count != old_count)
+      UpdateSortedEntry(column_id, old_count, count);
+    if (was_zero && count != zero_) {
+      ++num_entries_;
+    } else if (!was_zero && count == zero_) {
+      --num_entries_;
+      if (num_entries_ * 2 * kDenseFraction < capacity_)
+        ToSparse();
+    }
+    return;
+  }
+
+  auto it = std::lower_bound(col_ids_.begin(), col_ids_.end(), column_id);
+  size_t idx = it - col_ids_.begin();
+  if (it != col_ids_.end() && *it == column_id) {
+    V old_count = values_[idx];
+    values_[idx] += update;
+    if (sorted_valid_ && values_[idx] != old_count)
+      UpdateSortedEntry(column_id, old_count, values_[idx]);
+    if (values_[idx] == zero_) {
+      // remove 0 entry.
+      col_ids_.erase(it);
+      values_.erase(values_.begin() + idx);
+      if (sorted_valid_)
+        sorted_pos_.erase(sorted_pos_.begin() + idx);
+      --num_entries_;
+    }
+    return;
+  }
+  if (update == zero_)
+    return;
+  col_ids_.insert(it, column_id);
+  values_.insert(values_.begin() + idx, update);
+  if (sorted_valid_) {
+    sorted_pos_.insert(sorted_pos_.begin() + idx, -1);
+    UpdateSortedEntry(column_id, zero_, update);
+  }
+  ++num_entries_;
+  if (capacity_ > 0 && num_entries_ * kDenseFraction > capacity_)
+    ToDense();
+}
+
+template<typename V>
+void HybridCountRow<V>::UpdateSortedEntry(int32_t column_id, V old_count,
+    V new_count) {
+  typedef std::pair<int32_t, V> entry_t;
+  int32_t from;
+  if (old_count == zero_) {
+    from = sorted_entries_.size();
+    sorted_entries_.push_back(std::make_pair(column_id, new_count));
+  } else {
+    from = SortedPos(column_id);
+    sorted_entries_[from].second = new_count;
+  }
+
+  auto begin = sorted_entries_.begin();
+  int32_t to;
+  if (new_count == zero_) {
+    to = sorted_entries_.size() - 1;
+  } else if (old_count == zero_ || new_count > old_count) {
+    // Before the first entry with a smaller count.
+    to = std::partition_point(begin, begin + from,
+      [new_count](const entry_t &e) { return e.second >= new_count; })
+      - begin;
+  } else {
+    // After the last entry with a larger count.
+    to = std::partition_point(begin + from + 1, sorted_entries_.end(),
+      [new_count](const entry_t &e) { return e.second > new_count; })
+      - begin - 1;
+  }
+  MoveSortedEntry(from, to);
+  if (new_count == zero_)
+    sorted_entries_.pop_back();
+}
+
+template<typename V>
+void HybridCountRow<V>::MoveSortedEntry(int32_t from, int32_t to) {
+  if (from == to) {
+    SortedPos(sorted_entries_[to].first) = to;
+    return;
+  }
+  // If the entries passed over all have the same count, swapping with the
+  // farthest one keeps the order without shifting the rest.
+  bool same_counts = (from < to) ?
+    sorted_entries_[from + 1].second == sorted_entries_[to].second :
+    sorted_entries_[to].second == sorted_entries_[from - 1].second;
+  if (same_counts) {
+    std::swap(sorted_entries_[from], sorted_entries_[to]);
+    SortedPos(sorted_entries_[from].first) = from;
+    SortedPos(sorted_entries_[to].first) = to;
+    return;
+  }
+  auto begin = sorted_entries_.begin();
+  if (from < to) {
+    std::rotate(begin + from, begin + from + 1, begin + to + 1);
+  } else {
+    std::rotate(begin + to, begin + from, begin + from + 1);
+  }
+  for (int32_t i = std::min(from, to); i <= std::max(from, to); ++i) {
+    SortedPos(sorted_entries_[i].first) = i;
+  }
+}
+
+template<typename V>
+int32_t &HybridCountRow<V>::SortedPos(int32_t column_id) const {
+  if (dense_)
+    return sorted_pos_[column_id];
+  return sorted_pos_[std::lower_bound(col_ids_.cbegin(), col_ids_.cend(),
+    column_id) - col_ids_.cbegin()];
+}
+
+template<typename V>
+void HybridCountRow<V>::ToDense() {
+  counts_.assign(capacity_, zero_);
+  for (size_t i = 0; i < col_ids_.size(); ++i) {
+    counts_[col_ids_[i]] = values_[i];
+  }
+  std::vector<int32_t>().swap(col_ids_);
+  std::vector<V>().swap(values_);
+  dense_ = true;
+  sorted_valid_ = false;
+}
+
+template<typename V>
+void HybridCountRow<V>::ToSparse() {
+  col_ids_.clear();
+  values_.clear();
+  col_ids_.reserve(num_entries_);
+  values_.reserve(num_entries_);
+  for (int32_t i = 0; i < capacity_; ++i) {
+    if (counts_[i] != zero_) {
+      col_ids_.push_back(i);
+      values_.push_back(counts_[i]);
+    }
+  }
+  std::vector<V>().swap(counts_);
+  dense_ = false;
+  sorted_valid_ = false;
+}
+
+template<typename V>
+void HybridCountRow<V>::BuildSortedEntries() const {
+  std::lock_guard<std::mutex> lock(sorted_mtx_);
+  if (sorted_valid_)
+    return;
+  sorted_entries_.clear();
+  sorted_entries_.reserve(num_entries_);
+  if (dense_) {
+    for (int32_t i = 0; i < capacity_; ++i) {
+      if (counts_[i] != zero_)
+        sorted_entries_.push_back(std::make_pair(i, counts_[i]));
+    }
+  } else {
+    for (size_t i = 0; i < col_ids_.size(); ++i) {
+      sorted_entries_.push_back(std::make_pair(col_ids_[i], values_[i]));
+    }
+  }
+  std::sort(sorted_entries_.begin(), sorted_entries_.end(),
+    [](const std::pair<int32_t, V> &a, const std::pair<int32_t, V> &b) {
+      return a.second > b.second; });
+  sorted_pos_.assign(dense_ ? capacity_ : col_ids_.size(), -1);
+  for (size_t i = 0; i < sorted_entries_.size(); ++i) {
+    SortedPos(sorted_entries_[i].first) = i;
+  }
+  sorted_valid_ = true;
+}
+
+// ======== AbstractRow Implementation ========
+
+template<typename V>
+void HybridCountRow<V>::Init(int32_t capacity) {
+  capacity_ = capacity;
+}
+
+template<typename V>
+AbstractRow *HybridCountRow<V>::Clone() const {
+  boost::shared_lock<SharedMutex> read_lock(rw_mutex_);
+  HybridCountRow<V> *new_row = new HybridCountRow<V>();
+  new_row->capacity_ = capacity_;
+  new_row->num_entries_ = num_entries_;
+  new_row->dense_ = dense_;
+  new_row->counts_ = counts_;
+  new_row->col_ids_ = col_ids_;
+  new_row->values_ = values_;
+  new_row->sorted_valid_ = false;
+  return static_cast<AbstractRow*>(new_row);
+}
+
+template<typename V>
+size_t HybridCountRow<V>::SerializedSize() const {
+  return 2 * sizeof(int32_t) + num_entries_ * (sizeof(int32_t) + sizeof(V));
+}
+
+template<typename V>
+size_t HybridCountRow<V>::Serialize(void* bytes) const {
+  uint8_t *mem = reinterpret_cast<uint8_t*>(bytes);
+  *(reinterpret_cast<int32_t*>(mem)) = capacity_;
+  mem += sizeof(int32_t);
+  *(reinterpret_cast<int32_t*>(mem)) = num_entries_;
+  mem += sizeof(int32_t);
+
+  if (!dense_) {
+    if (num_entries_ > 0) {
+      memcpy(mem, col_ids_.data(), num_entries_ * sizeof(int32_t));
+      memcpy(mem + num_entries_ * sizeof(int32_t), values_.data(),
+             num_entries_ * sizeof(V));
+    }
+    return SerializedSize();
+  }
+
+  int32_t *mem_col_ids = reinterpret_cast<int32_t*>(mem);
+  uint8_t *mem_values = mem + num_entries_ * sizeof(int32_t);
+  int32_t j = 0;
+  for (int32_t i = 0; i < capacity_; ++i) {
+    if (counts_[i] != zero_) {
+      mem_col_ids[j] = i;
+      memcpy(mem_values + j * sizeof(V), &counts_[i], sizeof(V));
+      ++j;
+    }
+  }
+  CHECK_EQ(j, num_entries_);
+  return SerializedSize();
+}
+
+template<typename V>
+bool HybridCountRow<V>::Deserialize(const void* data, size_t num_bytes) {
+  CHECK_GE(num_bytes, 2 * sizeof(int32_t));
+  const uint8_t *mem = reinterpret_cast<const uint8_t*>(data);
+  capacity_ = *(reinterpret_cast<const int32_t*>(mem));
+  mem += sizeof(int32_t);
+  num_entries_ = *(reinterpret_cast<const int32_t*>(mem));
+  mem += sizeof(int32_t);
+  CHECK_EQ(num_bytes, 2 * sizeof(int32_t)
+           + num_entries_ * (sizeof(int32_t) + sizeof(V)));
+
+  col_ids_.resize(num_entries_);
+  values_.resize(num_entries_);
+  if (num_entries_ > 0) {
+    memcpy(col_ids_.data(), mem, num_entries_ * sizeof(int32_t));
+    memcpy(values_.data(), mem + num_entries_ * sizeof(int32_t),
+           num_entries_ * sizeof(V));
+  }
+  counts_.clear();
+  dense_ = false;
+  if (capacity_ > 0 && num_entries_ * kDenseFraction > capacity_)
+    ToDense();
+  sorted_valid_ = false;
+  return true;
+}
+
+template<typename V>
+void HybridCountRow<V>::ApplyInc(int32_t column_id, const void *update) {
+  std::unique_lock<SharedMutex> write_lock(rw_mutex_);
+  ApplyIncUnsafe(column_id, update);
+}
+
+template<typename V>
+void HybridCountRow<V>::ApplyBatchInc(const int32_t *column_ids,
+  const void *update_batch, int32_t num_updates) {
+  std::unique_lock<SharedMutex> write_lock(rw_mutex_);
+  ApplyBatchIncUnsafe(column_ids, update_batch, num_updates);
+}
+
+template<typename V>
+void HybridCountRow<V>::ApplyIncUnsafe(int32_t column_id,
+  const void *update) {
+  IncOne(column_id, *(reinterpret_cast<const V*>(update)));
+}
+
+template<typename V>
+void HybridCountRow<V>::ApplyBatchIncUnsafe(const int32_t *column_ids,
+    const void* update_batch, int32_t num_updates) {
+  const V* typed_updates = reinterpret_cast<const V*>(update_batch);
+  // Re-sorting once is cheaper than moving entries one at a time.
+  if (num_updates > num_entries_)
+    sorted_valid_ = false;
+  for (int32_t i = 0; i < num_updates; ++i) {
+    IncOne(column_ids[i], typed_updates[i]);
+  }
+}
+
+template<typename V>
+void HybridCountRow<V>::AddUpdates(int32_t column_id, void* update1,
+  const void* update2) const {
+  // Ignore column_id
+  V* typed_update1 = reinterpret_cast<V*>(update1);
+  const V* typed_update2 = reinterpret_cast<const V*>(update2);
+  *typed_update1 += *typed_update2;
+}
+
+template<typename V>
+void HybridCountRow<V>::SubtractUpdates(int32_t column_id, void* update1,
+  const void* update2) const {
+  // Ignore column_id
+  V* typed_update1 = reinterpret_cast<V*>(update1);
+  const V* typed_update2 = reinterpret_cast<const V*>(update2);
+  *typed_update1 -= *typed_update2;
+}
+
+template<typename V>
+void HybridCountRow<V>::InitUpdate(int32_t column_id, void* zero) const {
+  V* typed_zero = reinterpret_cast<V*>(zero);
+  *typed_zero = zero_;
+}
+
+}  // namespace petuum
@@ -19,24 +19,27 @@ ProcessStorage::~ProcessStorage() {
       reinterpret_cast<ClientRow*>((it->second).first);
     delete client_row_ptr;
   }
+  // Free the rows replaced or evicted during the lifetime of this storage.
+  EpochManager::Reclaim();
 }
 
 bool ProcessStorage::Find(int32_t row_id, RowAccessor* row_accessor) {
   CHECK_NOTNULL(row_accessor);
   std::pair<void*, int32_t> row_info;
-  // Lock to avoid eviction before incrementing ref count of client_row_ptr.
-  Unlocker<> unlocker;
-  locks_.Lock(row_id, &unlocker);
+  // No lock on row_id: a row that is evicted or replaced concurrently stays
+  // alive until we leave the epoch.
+  row_accessor->Clear();
+  EpochManager::Enter();
   bool found = storage_map_.find(row_id, row_info);
   if (found) {
     CHECK_NOTNULL(row_info.first);
     ClientRow* client_row_ptr = reinterpret_cast<ClientRow*>(row_info.first);
-    // SetClientRow() increments the ref count and needs to be protected by
-    // lock.
+    // row_accessor takes over the epoch.
     row_accessor->SetClientRow(client_row_ptr);
     clock_lru_.Reference(row_info.second);
     return true;
   }
+  EpochManager::Exit();
   return false;
 }
 
@@ -62,27 +65,7 @@ bool ProcessStorage::Insert(int32_t row_id, ClientRow* client_row) {
   // row_id does not exist in storage. Check space and evict if necessary.
   if (capacity_ - (++num_rows_) < 0) {
     --num_rows_;  // We are evicting one row now.
-    while (true) {
-      int32_t evict_candidate = clock_lru_.FindOneToEvict();
-      // Lock to prevent concurrent insert on evict_candidate.
-      Unlocker<> unlocker;
-      locks_.Lock(evict_candidate, &unlocker);
-      std::pair<void*, int32_t> row_info;
-      CHECK(storage_map_.find(evict_candidate, row_info));
-
-      ClientRow* candidate_client_row_ptr =
-        reinterpret_cast<ClientRow*>(row_info.first);
-      if (candidate_client_row_ptr->HasZeroRef()) {
-        // erase() and Evict() can be called in either order.
-        delete candidate_client_row_ptr;
-        storage_map_.erase(evict_candidate);
-        clock_lru_.Evict(row_info.second);
-        break;
-      } else {
-        // Can't evict with non-zero ref count.
-        clock_lru_.NoEvict(row_info.second);
-      }
-    }
+    EvictOneInactiveRow();
   }
   { // Lock again. This time we can insert for sure.
     Unlocker<> unlocker;
@@ -121,30 +104,9 @@ bool ProcessStorage::Insert(int32_t row_id, ClientRow* client_row,
   // row_id does not exist in storage. Check space and evict if necessary.
   if (capacity_ - (++num_rows_) < 0) {
     --num_rows_;  // We are evicting one row now.
-    while (true) {
-      int32_t evict_candidate = clock_lru_.FindOneToEvict();
-      // Lock to prevent concurrent insert on evict_candidate.
-      Unlocker<> unlocker;
-      locks_.Lock(evict_candidate, &unlocker);
-      std::pair<void*, int32_t> row_info;
-      CHECK(storage_map_.find(evict_candidate, row_info))
-        << "row " << evict_candidate << "cannot possibly be evicted while "
-        << "the lock on the slot for evict_candidate is held. Report bug.";
-      ClientRow* candidate_client_row_ptr =
-        reinterpret_cast<ClientRow*>(row_info.first);
-      if (candidate_client_row_ptr->HasZeroRef()) {
-        // erase() and Evict() can be called in either order.
-        delete candidate_client_row_ptr;
-        storage_map_.erase(evict_candidate);
-        clock_lru_.Evict(row_info.second);
-        if (evicted_row_id != 0) {
-          *evicted_row_id = evict_candidate;
-        }
-        break;
-      } else {
-        // Can't evict with non-zero ref count.
-        clock_lru_.NoEvict(row_info.second);
-      }
+    int32_t evict_candidate = EvictOneInactiveRow();
+    if (evicted_row_id != 0) {
+      *evicted_row_id = evict_candidate;
     }
   }
 
@@ -163,6 +125,8 @@ bool ProcessStorage::Insert(int32_t row_id, ClientRow* client_row,
     row_info.first = reinterpret_cast<void*>(client_row);
     row_info.second = clock_lru_.Insert(row_id);
     CHECK(storage_map_.insert(row_id, row_info));
+    row_accessor->Clear();
+    EpochManager::Enter();
     row_accessor->SetClientRow(client_row);
   }
   return true;
@@ -170,6 +134,23 @@ bool ProcessStorage::Insert(int32_t row_id, ClientRow* client_row,
 
 // ==================== Private Methods ======================
 
+int32_t ProcessStorage::EvictOneInactiveRow() {
+  int32_t evict_candidate = clock_lru_.FindOneToEvict();
+  // Lock to prevent concurrent insert on evict_candidate.
+  Unlocker<> unlocker;
+  locks_.Lock(evict_candidate, &unlocker);
+  std::pair<void*, int32_t> row_info;
+  CHECK(storage_map_.find(evict_candidate, row_info))
+    << "row " << evict_candidate << "cannot possibly be evicted while "
+    << "the lock on the slot for evict_candidate is held. Report bug.";
+  // erase() and Evict() can be called in either order. Readers may still be
+  // using the row, so it is retired rather than deleted.
+  storage_map_.erase(evict_candidate);
+  clock_lru_.Evict(row_info.second);
+  EpochManager::Retire(reinterpret_cast<ClientRow*>(row_info.first));
+  return evict_candidate;
+}
+
 bool ProcessStorage::FindAndUpdate(int32_t row_id, ClientRow* client_row) {
   std::pair<void*, int32_t> row_info;
   bool found = storage_map_.find(row_id, row_info);
@@ -195,6 +176,8 @@ bool ProcessStorage::FindAndUpdate(int32_t row_id, ClientRow* client_row,
     ClientRow* client_row_ptr =
       reinterpret_cast<ClientRow*>(row_info.first);
     client_row_ptr->SwapAndDestroy(client_row);
+    row_accessor->Clear();
+    EpochManager::Enter();
     row_accessor->SetClientRow(client_row_ptr);
     clock_lru_.Reference(row_info.second);
     return true;
@@ -6,6 +6,7 @@
 #include "petuum_ps/include/row_access.hpp"
 #include "petuum_ps/client/client_row.hpp"
 #include "petuum_ps/util/striped_lock.hpp"
+#include "petuum_ps/util/epoch_manager.hpp"
 #include "petuum_ps/storage/clock_lru.hpp"
 #include <libcuckoo/cuckoohash_map.hh>
 #include <atomic>
@@ -26,10 +27,10 @@ public:
   ~ProcessStorage();
 
   // Find row row_id; row_accessor is a read-only smart pointer. Return true
-  // if found, false otherwise. Note that the # of active row_accessor
-  // cannot be close to capacity, or Insert() will have undefined behavior
-  // as we may not be able to evict any row that's not being referenced by
-  // row_accessor.
+  // if found, false otherwise. Find takes no lock and writes no shared
+  // state other than the CLOCK recency bit (only when it changes); the row
+  // is kept alive by the calling thread's epoch (see EpochManager), so rows
+  // held by row_accessor can still be evicted or replaced.
   bool Find(int32_t row_id, RowAccessor* row_accessor);
 
   // Check if a row exists, does not count as one access
@@ -41,8 +42,7 @@ public:
   // row using ClockLRU.  Return read reference and evicted row id if
   // row_accessor and evicted_row_id are respectively not 0. We assume
   // row_id is always non-negative, and use *evicted_row_id = -1 if no row
-  // is evicted. The evicted row is guaranteed to have 0 reference count
-  // (i.e., no application is using).
+  // is evicted. The evicted row is reclaimed once no RowAccessor uses it.
   //
   // Note: To stay below the capacity, we first check num_rows_. If
   // num_rows_ >= capacity_, we subtract (num_rows_ - capacity_) from
@@ -56,8 +56,9 @@ public:
       RowAccessor* row_accessor, int32_t* evicted_row_id = 0);
 
 private:    // private functions
-  // Evict one inactive row using CLOCK replacement algorithm.
-  void EvictOneInactiveRow();
+  // Evict one inactive row using CLOCK replacement algorithm. Return the
+  // evicted row id.
+  int32_t EvictOneInactiveRow();
 
   // Find row_id in storage_map_, assuming there is lock on row_id. If
   // found, update it with client_row, reference LRU, and set row_accessor
@@ -82,7 +83,7 @@ private:    // private members
   // Depends on storage_map_, thus need to be initialized after it.
   ClockLRU clock_lru_;
 
-  // Lock pool.
+  // Lock pool serializing writers (Insert and eviction) on the same row.
   StripedLock<int32_t> locks_;
 };
 
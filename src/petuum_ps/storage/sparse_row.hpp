@@ -130,6 +130,11 @@ public:  // AbstractRow implementation
   void ApplyBatchIncUnsafe(const int32_t *column_ids,
     const void* update_batch, int32_t num_updates);
 
+  double GetUpdatesMagnitude(const int32_t *column_ids,
+    const void* update_batch, int32_t num_updates) const {
+    return SumAbsUpdates<V>(update_batch, num_updates);
+  }
+
   void AddUpdates(int32_t column_id, void* update1,
     const void *update2) const;
 
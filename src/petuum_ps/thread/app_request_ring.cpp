@@ -0,0 +1,59 @@
+#include "petuum_ps/thread/app_request_ring.hpp"
+#include <glog/logging.h>
+#include <thread>
+
+namespace petuum {
+
+// Each cell's sequence is its position when it is free to push to and its
+// position + 1 when it holds a request to pop.
+AppRequestRing::AppRequestRing(size_t capacity):
+    cells_(capacity),
+    mask_(capacity - 1),
+    push_pos_(0),
+    pop_pos_(0),
+    num_announced_(0) {
+  CHECK(capacity > 0 && (capacity & mask_) == 0)
+      << "capacity = " << capacity;
+  for (size_t i = 0; i < capacity; ++i) {
+    cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+bool AppRequestRing::Push(const AppRequest &request) {
+  size_t pos = push_pos_.load(std::memory_order_relaxed);
+  Cell *cell;
+  while (true) {
+    cell = &cells_[pos & mask_];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    intptr_t diff = static_cast<intptr_t>(sequence)
+        - static_cast<intptr_t>(pos);
+    if (diff == 0) {
+      if (push_pos_.compare_exchange_weak(pos, pos + 1,
+                                          std::memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      // Full, wait for the bg thread to pop.
+      std::this_thread::yield();
+      pos = push_pos_.load(std::memory_order_relaxed);
+    } else {
+      pos = push_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  cell->request = request;
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  return num_announced_.fetch_add(1, std::memory_order_acq_rel) == 0;
+}
+
+void AppRequestRing::Pop(AppRequest *request) {
+  Cell &cell = cells_[pop_pos_ & mask_];
+  // An announced request may sit behind one that another app thread is
+  // still writing.
+  while (cell.sequence.load(std::memory_order_acquire) != pop_pos_ + 1) {
+    std::this_thread::yield();
+  }
+  *request = cell.request;
+  cell.sequence.store(pop_pos_ + mask_ + 1, std::memory_order_release);
+  ++pop_pos_;
+}
+
+}  // namespace petuum
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+#include "petuum_ps/thread/ps_msgs.hpp"
+
+namespace petuum {
+
+// A request from an app thread to a bg thread of the same process.
+struct AppRequest {
+  // kRowRequest, kBatchRowRequest, kBgClock, kBgSendOpLog or
+  // kAppThreadDereg.
+  MsgType type;
+  int32_t app_thread_id;
+  int32_t table_id;
+  int32_t row_id;
+  int32_t clock;
+  // Rows of a kBatchRowRequest. They are owned by the app thread, which
+  // waits for the reply before releasing them.
+  const int32_t *row_ids;
+  int32_t num_rows;
+
+  AppRequest():
+      type(kRowRequest),
+      app_thread_id(0),
+      table_id(0),
+      row_id(0),
+      clock(0),
+      row_ids(0),
+      num_rows(0) { }
+};
+
+// Bounded lock-free queue of AppRequests from many app threads to one bg
+// thread. Requests of an app thread are popped in the order it pushed them.
+//
+// A request is announced once it has been pushed. Push() returns true when
+// it announced the only request the bg thread has not yet been told about,
+// in which case the app thread wakes the bg thread up with a
+// BgAppRequestMsg. The bg thread then pops get_num_announced() requests and
+// calls Consumed() until no more are announced, so one message covers all
+// requests pushed meanwhile.
+class AppRequestRing : boost::noncopyable {
+public:
+  // capacity must be a power of 2.
+  explicit AppRequestRing(size_t capacity);
+
+  // Blocks while the ring is full.
+  bool Push(const AppRequest &request);
+
+  // Only called by the bg thread, for announced requests.
+  void Pop(AppRequest *request);
+
+  int64_t get_num_announced() const {
+    return num_announced_.load(std::memory_order_acquire);
+  }
+
+  // The bg thread has popped num_popped announced requests; returns the
+  // number of requests announced since.
+  int64_t Consumed(int64_t num_popped) {
+    return num_announced_.fetch_sub(num_popped, std::memory_order_acq_rel)
+        - num_popped;
+  }
+
+private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    AppRequest request;
+  };
+
+  std::vector<Cell> cells_;
+  size_t mask_;
+  std::atomic<size_t> push_pos_;
+  size_t pop_pos_;
+  std::atomic<int64_t> num_announced_;
+};
+
+}  // namespace petuum
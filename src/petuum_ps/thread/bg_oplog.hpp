@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <vector>
 #include <boost/noncopyable.hpp>
 #include <glog/logging.h>
 
@@ -27,9 +28,72 @@ public:
   BgOpLogPartition* Get(int32_t table_id) const {
     return table_oplog_map_.at(table_id);
   }
+
+  // Returns 0 if there is no partition of table_id.
+  BgOpLogPartition* Find(int32_t table_id) const {
+    auto iter = table_oplog_map_.find(table_id);
+    if (iter == table_oplog_map_.end())
+      return 0;
+    return iter->second;
+  }
+
+  std::map<int32_t, BgOpLogPartition*>::const_iterator cbegin() const {
+    return table_oplog_map_.cbegin();
+  }
+
+  std::map<int32_t, BgOpLogPartition*>::const_iterator cend() const {
+    return table_oplog_map_.cend();
+  }
+
+  // Delete the row oplogs and keep the partitions.
+  void Clear() {
+    for (auto iter = table_oplog_map_.begin(); iter != table_oplog_map_.end();
+      iter++) {
+      iter->second->Clear();
+    }
+  }
 private:
   std::map<int32_t, BgOpLogPartition*> table_oplog_map_;
 
 };
 
+// BgOpLogs of a bg thread that are no longer needed, kept to be reused by
+// later clocks along with their partitions' allocated buckets.
+class BgOpLogPool : boost::noncopyable {
+public:
+  BgOpLogPool() { }
+
+  ~BgOpLogPool() {
+    for (auto iter = free_oplogs_.begin(); iter != free_oplogs_.end();
+      iter++) {
+      delete *iter;
+    }
+  }
+
+  // The returned BgOpLog may have partitions of tables, without row oplogs.
+  BgOpLog *Get() {
+    if (free_oplogs_.empty())
+      return new BgOpLog;
+    BgOpLog *bg_oplog = free_oplogs_.back();
+    free_oplogs_.pop_back();
+    return bg_oplog;
+  }
+
+  // Takes ownership of bg_oplog.
+  void Put(BgOpLog *bg_oplog) {
+    if (free_oplogs_.size() >= kMaxNumFreeOpLogs) {
+      delete bg_oplog;
+      return;
+    }
+    bg_oplog->Clear();
+    free_oplogs_.push_back(bg_oplog);
+  }
+
+private:
+  // Oplogs are mostly released one or a few at a time.
+  static const size_t kMaxNumFreeOpLogs = 4;
+
+  std::vector<BgOpLog*> free_oplogs_;
+};
+
 }
@@ -1,6 +1,10 @@
 
 #include "petuum_ps/thread/bg_oplog_partition.hpp"
 #include "petuum_ps/thread/context.hpp"
+#include "petuum_ps/thread/msg_codec.hpp"
+#include "petuum_ps/thread/update_quantizer.hpp"
+#include "petuum_ps/oplog/oplog.hpp"
+#include <vector>
 
 namespace petuum {
 
@@ -17,6 +21,21 @@ BgOpLogPartition::~BgOpLogPartition() {
   }
 }
 
+void BgOpLogPartition::Clear() {
+  for(auto iter = oplog_map_.begin(); iter != oplog_map_.end(); iter++){
+    delete iter->second;
+  }
+  oplog_map_.clear();
+}
+
+void BgOpLogPartition::ReleaseOpLogs(
+    std::vector<std::pair<int32_t, RowOpLog*> > *row_oplogs) {
+  for(auto iter = oplog_map_.begin(); iter != oplog_map_.end(); iter++){
+    row_oplogs->push_back(*iter);
+  }
+  oplog_map_.clear();
+}
+
 RowOpLog *BgOpLogPartition::FindOpLog(int row_id) {
   boost::unordered_map<int32_t, RowOpLog*>::iterator oplog_iter
       = oplog_map_.find(row_id);
@@ -30,8 +49,33 @@ void BgOpLogPartition::InsertOpLog(int row_id, RowOpLog *row_oplog) {
   VLOG(0) << "Inserted row " << row_id << " to oplog partition";
 }
 
+size_t BgOpLogPartition::GetMaxSerializedRowOpLogSize(
+  int32_t num_updates) const {
+  UpdatePrecision precision = GlobalContext::GetTableUpdatePrecision(
+      table_id_);
+  size_t updates_size = (precision == FullPrecision) ?
+      update_size_*num_updates
+      : UpdateQuantizer::GetQuantizedSize(precision, num_updates);
+  if (GlobalContext::GetTableMsgCodec(table_id_) == CompactCodec)
+    return MsgCompressor::GetMaxEncodedRowOpLogSize(num_updates,
+                                                    updates_size);
+  return sizeof(int32_t) + sizeof(int32_t) + sizeof(int32_t)*num_updates
+    + updates_size;
+}
+
 void BgOpLogPartition::SerializeByServer(
-  std::map<int32_t, void* > *bytes_by_server){
+  std::map<int32_t, void* > *bytes_by_server,
+  const RowRoutingTable &routing_table,
+  std::map<int32_t, size_t> *size_by_server, TableOpLog *table_oplog,
+  std::vector<int32_t> *residual_row_ids) {
+
+  residual_row_ids->clear();
+  if (GlobalContext::GetTableMsgCodec(table_id_) == CompactCodec
+      || GlobalContext::GetTableUpdatePrecision(table_id_) != FullPrecision) {
+    SerializeByServerEncoded(bytes_by_server, routing_table, size_by_server,
+                             table_oplog, residual_row_ids);
+    return;
+  }
 
   std::vector<int32_t> &server_ids = GlobalContext::get_server_ids();
   std::map<int32_t, int32_t> offset_by_server;
@@ -47,8 +91,7 @@ void BgOpLogPartition::SerializeByServer(
   for(auto iter = oplog_map_.cbegin(); iter != oplog_map_.cend(); iter++){
     int32_t row_id = iter->first;
     VLOG(0) << "Serializing row " << row_id;
-    int32_t server_id = GlobalContext::GetRowPartitionServerID(table_id_,
-      row_id);
+    int32_t server_id = routing_table.GetServerID(table_id_, row_id);
     RowOpLog *row_oplog_ptr = iter->second;
 
     uint8_t *mem = ((uint8_t *) (*bytes_by_server)[server_id])
@@ -83,6 +126,162 @@ void BgOpLogPartition::SerializeByServer(
 
     *((int32_t *) (*bytes_by_server)[server_id]) += 1;
   }
+
+  for (auto offset_iter = offset_by_server.cbegin();
+       offset_iter != offset_by_server.cend(); offset_iter++) {
+    (*size_by_server)[offset_iter->first] = offset_iter->second;
+  }
+}
+
+void BgOpLogPartition::SerializeByServerEncoded(
+  std::map<int32_t, void* > *bytes_by_server,
+  const RowRoutingTable &routing_table,
+  std::map<int32_t, size_t> *size_by_server, TableOpLog *table_oplog,
+  std::vector<int32_t> *residual_row_ids) {
+
+  bool compact_codec = (GlobalContext::GetTableMsgCodec(table_id_)
+                        == CompactCodec);
+  UpdatePrecision precision = GlobalContext::GetTableUpdatePrecision(
+      table_id_);
+  bool quantized = (precision != FullPrecision);
+  if (quantized)
+    CHECK_EQ(update_size_, sizeof(float))
+      << "Update precision of table " << table_id_
+      << " requires float updates";
+
+  std::vector<int32_t> &server_ids = GlobalContext::get_server_ids();
+  // Row id of the last row serialized for each server, rows are delta
+  // encoded.
+  std::map<int32_t, int32_t> prev_row_id_by_server;
+  for(int i = 0; i < GlobalContext::get_num_servers(); ++i){
+    int32_t server_id = server_ids[i];
+    (*size_by_server)[server_id] = sizeof(int32_t);
+    prev_row_id_by_server[server_id] = 0;
+    *((int32_t *) (*bytes_by_server)[server_id]) = 0;
+  }
+
+  std::vector<int32_t> column_ids;
+  std::vector<void*> row_updates;
+  std::vector<float> values;
+  std::vector<float> residuals;
+  std::vector<int32_t> residual_column_ids;
+  std::vector<float> residual_values;
+  std::vector<uint8_t> quantized_updates;
+  std::vector<uint8_t> updates;
+  size_t raw_size = 0;
+  size_t encoded_size = 0;
+  for(auto iter = oplog_map_.cbegin(); iter != oplog_map_.cend(); iter++){
+    int32_t row_id = iter->first;
+    int32_t server_id = routing_table.GetServerID(table_id_, row_id);
+    RowOpLog *row_oplog_ptr = iter->second;
+
+    column_ids.clear();
+    row_updates.clear();
+    int32_t column_id;
+    void *update = row_oplog_ptr->BeginIterate(&column_id);
+    while(update != 0){
+      column_ids.push_back(column_id);
+      row_updates.push_back(update);
+      update = row_oplog_ptr->Next(&column_id);
+    }
+    int32_t num_updates = column_ids.size();
+
+    size_t update_size = update_size_;
+    const uint8_t *row_update_bytes = 0;
+    if (quantized) {
+      values.resize(num_updates);
+      residuals.resize(num_updates);
+      for (int32_t i = 0; i < num_updates; ++i) {
+        values[i] = *(reinterpret_cast<float*>(row_updates[i]));
+      }
+      quantized_updates.resize(UpdateQuantizer::GetQuantizedSize(precision,
+                                                                 num_updates));
+      UpdateQuantizer::Quantize(precision, values.data(), num_updates,
+                                residuals.data(), quantized_updates.data());
+
+      // The retained oplog must match what the server applies.
+      residual_column_ids.clear();
+      residual_values.clear();
+      for (int32_t i = 0; i < num_updates; ++i) {
+        *(reinterpret_cast<float*>(row_updates[i])) = values[i];
+        if (residuals[i] != 0) {
+          residual_column_ids.push_back(column_ids[i]);
+          residual_values.push_back(residuals[i]);
+        }
+      }
+      if (!residual_column_ids.empty() && table_oplog != 0) {
+        table_oplog->BatchInc(row_id, residual_column_ids.data(),
+                              residual_values.data(),
+                              residual_column_ids.size());
+        residual_row_ids->push_back(row_id);
+      }
+      update_size = UpdateQuantizer::GetQuantizedUpdateSize(precision);
+      row_update_bytes = quantized_updates.data() + sizeof(float);
+    }
+
+    // Drop zero updates from encoded rows; a quantized update that is zero
+    // leaves its value in the residual.
+    if (compact_codec) {
+      int32_t num_nonzero = 0;
+      for (int32_t i = 0; i < num_updates; ++i) {
+        const void *update_i = quantized ?
+            static_cast<const void*>(row_update_bytes + i*update_size)
+            : row_updates[i];
+        if (MsgCompressor::IsZeroUpdate(update_i, update_size))
+          continue;
+        column_ids[num_nonzero] = column_ids[i];
+        if (quantized)
+          memmove(quantized_updates.data() + sizeof(float)
+                  + num_nonzero*update_size, update_i, update_size);
+        else
+          row_updates[num_nonzero] = row_updates[i];
+        ++num_nonzero;
+      }
+      num_updates = num_nonzero;
+    }
+
+    size_t updates_size;
+    const uint8_t *updates_ptr;
+    if (quantized) {
+      updates_size = UpdateQuantizer::GetQuantizedSize(precision,
+                                                       num_updates);
+      updates_ptr = quantized_updates.data();
+    } else {
+      updates.resize(num_updates*update_size_);
+      for (int32_t i = 0; i < num_updates; ++i) {
+        memcpy(updates.data() + i*update_size_, row_updates[i],
+               update_size_);
+      }
+      updates_size = updates.size();
+      updates_ptr = updates.data();
+    }
+
+    size_t &offset = (*size_by_server)[server_id];
+    uint8_t *mem = ((uint8_t *) (*bytes_by_server)[server_id]) + offset;
+    size_t row_size;
+    if (compact_codec) {
+      row_size = MsgCompressor::EncodeRowOpLog(
+          prev_row_id_by_server[server_id], row_id, column_ids.data(),
+          num_updates, updates_ptr, updates_size, mem);
+      prev_row_id_by_server[server_id] = row_id;
+    } else {
+      *((int32_t *) mem) = row_id;
+      *((int32_t *) (mem + sizeof(int32_t))) = num_updates;
+      memcpy(mem + 2*sizeof(int32_t), column_ids.data(),
+             sizeof(int32_t)*num_updates);
+      memcpy(mem + 2*sizeof(int32_t) + sizeof(int32_t)*num_updates,
+             updates_ptr, updates_size);
+      row_size = 2*sizeof(int32_t) + sizeof(int32_t)*num_updates
+        + updates_size;
+    }
+    offset += row_size;
+    *((int32_t *) (*bytes_by_server)[server_id]) += 1;
+
+    raw_size += sizeof(int32_t) + sizeof(int32_t)
+      + (sizeof(int32_t) + update_size_)*row_oplog_ptr->GetSize();
+    encoded_size += row_size;
+  }
+  MsgCompressor::AddOpLogBytes(raw_size, encoded_size);
 }
 
 }
@@ -5,12 +5,17 @@
 #include <stdint.h>
 #include <boost/unordered_map.hpp>
 #include <map>
+#include <vector>
+#include <utility>
 
 #include "petuum_ps/thread/context.hpp"
 #include "petuum_ps/oplog/row_oplog.hpp"
+#include "petuum_ps/thread/row_routing_table.hpp"
 
 namespace petuum {
 
+class TableOpLog;
+
 class BgOpLogPartition : boost::noncopyable {
 public:
   BgOpLogPartition();
@@ -19,9 +24,33 @@ public:
 
   RowOpLog *FindOpLog(int32_t row_id);
   void InsertOpLog(int32_t row_id, RowOpLog *row_oplog);
-  void SerializeByServer(std::map<int32_t, void* > *bytes_by_server);
+  // Delete all row oplogs.
+  void Clear();
+  // Append the row oplogs to row_oplogs, which then owns them, and leave the
+  // partition empty.
+  void ReleaseOpLogs(std::vector<std::pair<int32_t, RowOpLog*> > *row_oplogs);
+  // Upper bound of the number of bytes SerializeByServer() writes for a row
+  // oplog of num_updates updates.
+  size_t GetMaxSerializedRowOpLogSize(int32_t num_updates) const;
+  // Serialize the row oplogs of each server to (*bytes_by_server)[server_id]
+  // and set (*size_by_server)[server_id] to the number of bytes written.
+  // For tables with a quantized UpdatePrecision, the row oplogs are replaced
+  // by the updates the server receives and the quantization residuals are
+  // added to table_oplog, to be sent at a later clock. residual_row_ids is
+  // set to the rows that got a residual, which the caller has to index.
+  void SerializeByServer(std::map<int32_t, void* > *bytes_by_server,
+    const RowRoutingTable &routing_table,
+    std::map<int32_t, size_t> *size_by_server, TableOpLog *table_oplog,
+    std::vector<int32_t> *residual_row_ids);
 
 private:
+  // SerializeByServer() for tables with CompactCodec or a quantized
+  // UpdatePrecision.
+  void SerializeByServerEncoded(std::map<int32_t, void* > *bytes_by_server,
+    const RowRoutingTable &routing_table,
+    std::map<int32_t, size_t> *size_by_server, TableOpLog *table_oplog,
+    std::vector<int32_t> *residual_row_ids);
+
   boost::unordered_map<int32_t,  RowOpLog*> oplog_map_;
   int32_t table_id_;
   size_t update_size_;
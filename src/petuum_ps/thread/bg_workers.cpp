@@ -14,10 +14,20 @@
 
 namespace petuum {
 
+namespace {
+
+// Number of requests an AppRequestRing holds before app threads wait for
+// the bg thread.
+const size_t kAppRequestRingCapacity = 4096;
+
+}  // anonymous namespace
+
 std::vector<pthread_t> BgWorkers::threads_;
 std::vector<int32_t> BgWorkers::thread_ids_;
 std::map<int32_t, ClientTable* > * BgWorkers::tables_;
 int32_t BgWorkers::id_st_;
+std::vector<AppRequestRing*> BgWorkers::request_rings_;
+CompletionSlot *BgWorkers::app_thread_slots_;
 pthread_barrier_t BgWorkers::init_barrier_;
 pthread_barrier_t BgWorkers::create_table_barrier_;
 boost::thread_specific_ptr<BgWorkers::BgContext> BgWorkers::bg_context_;
@@ -86,6 +96,7 @@ void BgWorkers::Init(std::map<int32_t, ClientTable* > *tables) {
       }
       break;
     case SSPPush:
+    case SSPPushValueBound:
       {
         BgThreadMain = SSPBgThreadMain;
         MyCreateClientRow = CreateClientRow;
@@ -103,6 +114,13 @@ void BgWorkers::Init(std::map<int32_t, ClientTable* > *tables) {
     CommBusRecvAnyWrapper = CommBusRecvAnySleep;
   }
 
+  request_rings_.resize(GlobalContext::get_num_bg_threads());
+  for (int32_t i = 0; i < GlobalContext::get_num_bg_threads(); ++i) {
+    request_rings_[i] = new AppRequestRing(kAppRequestRingCapacity);
+  }
+  app_thread_slots_
+      = new CompletionSlot[GlobalContext::kMaxNumThreadsPerClient];
+
   int i;
   for(i = 0; i < GlobalContext::get_num_bg_threads(); ++i){
     thread_ids_[i] = id_st_ + i;
@@ -119,7 +137,9 @@ void BgWorkers::ShutDown(){
   for(int i = 0; i < GlobalContext::get_num_bg_threads(); ++i){
     int ret = pthread_join(threads_[i], NULL);
     CHECK_EQ(ret, 0);
+    delete request_rings_[i];
   }
+  delete[] app_thread_slots_;
 }
 
 void BgWorkers::ThreadRegister(){
@@ -131,8 +151,9 @@ void BgWorkers::ThreadRegister(){
 }
 
 void BgWorkers::ThreadDeregister(){
-  AppThreadDeregMsg msg;
-  SendToAllLocalBgThreads(msg.get_mem(), msg.get_size());
+  AppRequest request;
+  request.type = kAppThreadDereg;
+  PushToAllLocalBgThreads(&request);
 }
 
 bool BgWorkers::CreateTable(int32_t table_id,
@@ -150,6 +171,9 @@ bool BgWorkers::CreateTable(int32_t table_id,
     bg_create_table_msg.get_thread_cache_capacity()
       = table_config.thread_cache_capacity;
     bg_create_table_msg.get_oplog_capacity() = table_config.oplog_capacity;
+    bg_create_table_msg.get_value_bound() = table_info.value_bound;
+    bg_create_table_msg.get_oplog_dense_index_rows()
+      = table_config.oplog_dense_index_rows;
     void *msg = bg_create_table_msg.get_mem();
     int32_t msg_size = bg_create_table_msg.get_size();
 
@@ -172,68 +196,75 @@ void BgWorkers::WaitCreateTable(){
 }
 
 bool BgWorkers::RequestRow(int32_t table_id, int32_t row_id, int32_t clock){
-  {
-    RowRequestMsg request_row_msg;
-    request_row_msg.get_table_id() = table_id;
-    request_row_msg.get_row_id() = row_id;
-    request_row_msg.get_clock() = clock;
-
-    //VLOG(0) << "BgWorkers request row clock = " << clock
-    //	    << " table_id = " << table_id
-    //	    << " row_id = " << row_id
-    //	    << " thread id = " << ThreadContext::get_id();
-    int32_t bg_id = GlobalContext::GetBgPartitionNum(row_id) + id_st_;
-    size_t sent_size = comm_bus_->SendInProc(bg_id, request_row_msg.get_mem(),
-				      request_row_msg.get_size());
-    CHECK_EQ(sent_size, request_row_msg.get_size());
-  }
-
-  {
-    zmq::message_t zmq_msg;
-    int32_t sender_id;
-    comm_bus_->RecvInProc(&sender_id, &zmq_msg);
-    /*
-    bool received = comm_bus_->RecvInProcAsync(&sender_id, &zmq_msg);
-    while (!received) {
-      found = comm_bus_->RecvInProcAsync(&sender_id, &zmq_msg);
-      } */
-    MsgType msg_type = MsgBase::get_msg_type(zmq_msg.data());
-    CHECK_EQ(msg_type, kRowRequestReply);
-  }
+  RequestRowAsync(table_id, row_id, clock);
+  GetAsyncRowRequestReply();
   return true;
 }
 
 void BgWorkers::RequestRowAsync(int32_t table_id, int32_t row_id,
                                 int32_t clock){
-  RowRequestMsg request_row_msg;
-  request_row_msg.get_table_id() = table_id;
-  request_row_msg.get_row_id() = row_id;
-  request_row_msg.get_clock() = clock;
-
-  int32_t bg_id = GlobalContext::GetBgPartitionNum(row_id) + id_st_;
-  size_t sent_size = comm_bus_->SendInProc(bg_id, request_row_msg.get_mem(),
-                                           request_row_msg.get_size());
-  CHECK_EQ(sent_size, request_row_msg.get_size());
+  AppRequest request;
+  request.type = kRowRequest;
+  request.app_thread_id = ThreadContext::get_id();
+  request.table_id = table_id;
+  request.row_id = row_id;
+  request.clock = clock;
+  PushAppRequest(GlobalContext::GetBgPartitionNum(table_id, row_id),
+                 request);
 }
 
 void BgWorkers::GetAsyncRowRequestReply() {
-  zmq::message_t zmq_msg;
-  int32_t sender_id;
-  comm_bus_->RecvInProc(&sender_id, &zmq_msg);
-  MsgType msg_type = MsgBase::get_msg_type(zmq_msg.data());
-  CHECK_EQ(msg_type, kRowRequestReply);
+  GetAppThreadSlot(ThreadContext::get_id()).Wait();
+}
+
+void BgWorkers::RequestRowBatch(int32_t table_id,
+  const std::vector<int32_t> &row_ids, int32_t clock) {
+  // rows are partitioned among bg threads
+  std::map<int32_t, std::vector<int32_t> > bg_row_ids;
+  for (auto row_iter = row_ids.cbegin(); row_iter != row_ids.cend();
+       row_iter++) {
+    int32_t partition_num = GlobalContext::GetBgPartitionNum(table_id,
+                                                             *row_iter);
+    bg_row_ids[partition_num].push_back(*row_iter);
+  }
+
+  // bg_row_ids is read by the bg threads until they reply.
+  for (auto bg_iter = bg_row_ids.begin(); bg_iter != bg_row_ids.end();
+       bg_iter++) {
+    AppRequest request;
+    request.type = kBatchRowRequest;
+    request.app_thread_id = ThreadContext::get_id();
+    request.table_id = table_id;
+    request.clock = clock;
+    request.row_ids = bg_iter->second.data();
+    request.num_rows = bg_iter->second.size();
+    PushAppRequest(bg_iter->first, request);
+  }
+
+  // one reply from each bg thread
+  for (size_t i = 0; i < bg_row_ids.size(); ++i) {
+    GetAsyncRowRequestReply();
+  }
 }
 
 
 void BgWorkers::ClockAllTables() {
-  BgClockMsg bg_clock_msg;
-  SendToAllLocalBgThreads(bg_clock_msg.get_mem(), bg_clock_msg.get_size());
+  AppRequest request;
+  request.type = kBgClock;
+  PushToAllLocalBgThreads(&request);
 }
 
 void BgWorkers::SendOpLogsAllTables() {
-  BgSendOpLogMsg bg_send_oplog_msg;
-  SendToAllLocalBgThreads(bg_send_oplog_msg.get_mem(),
-    bg_send_oplog_msg.get_size());
+  AppRequest request;
+  request.type = kBgSendOpLog;
+  PushToAllLocalBgThreads(&request);
+}
+
+void BgWorkers::SendOpLogsBgThread(int32_t partition_num) {
+  AppRequest request;
+  request.type = kBgSendOpLog;
+  request.app_thread_id = ThreadContext::get_id();
+  PushAppRequest(partition_num, request);
 }
 
 int32_t BgWorkers::GetSystemClock() {
@@ -277,11 +308,80 @@ void BgWorkers::ConnectToBg(int32_t bg_id){
   comm_bus_->ConnectTo(bg_id, msg, msg_size);
 }
 
-void BgWorkers::SendToAllLocalBgThreads(void *msg, int32_t size){
-  int i;
-  for(i = 0; i < GlobalContext::get_num_bg_threads(); ++i){
-    int32_t sent_size = comm_bus_->SendInProc(thread_ids_[i], msg, size);
-    CHECK_EQ(sent_size, size);
+void BgWorkers::PushAppRequest(int32_t partition_num,
+  const AppRequest &request) {
+  if (request_rings_[partition_num]->Push(request)) {
+    BgAppRequestMsg bg_app_request_msg;
+    size_t sent_size = comm_bus_->SendInProc(thread_ids_[partition_num],
+      bg_app_request_msg.get_mem(), bg_app_request_msg.get_size());
+    CHECK_EQ(sent_size, bg_app_request_msg.get_size());
+  }
+}
+
+void BgWorkers::PushToAllLocalBgThreads(AppRequest *request) {
+  request->app_thread_id = ThreadContext::get_id();
+  for (int32_t i = 0; i < GlobalContext::get_num_bg_threads(); ++i) {
+    PushAppRequest(i, *request);
+  }
+}
+
+CompletionSlot &BgWorkers::GetAppThreadSlot(int32_t app_thread_id) {
+  return app_thread_slots_[app_thread_id - GlobalContext::get_local_id_min()];
+}
+
+void BgWorkers::HandleAppRequests() {
+  AppRequestRing *ring = request_rings_[ThreadContext::get_id() - id_st_];
+  int64_t num_announced = ring->get_num_announced();
+  while (num_announced > 0) {
+    for (int64_t i = 0; i < num_announced; ++i) {
+      AppRequest request;
+      ring->Pop(&request);
+      HandleAppRequest(request);
+    }
+    num_announced = ring->Consumed(num_announced);
+  }
+  SendServerRowRequests();
+}
+
+void BgWorkers::HandleAppRequest(const AppRequest &request) {
+  switch (request.type) {
+    case kRowRequest:
+      CheckForwardRowRequestToServer(request.app_thread_id, request.table_id,
+                                     request.row_id, request.clock);
+      break;
+    case kBatchRowRequest:
+      CheckForwardBatchRowRequestToServer(request.app_thread_id,
+        request.table_id, request.row_ids, request.num_rows, request.clock);
+      break;
+    case kBgClock:
+      HandleClockMsg(true);
+      break;
+    case kBgSendOpLog:
+      HandleClockMsg(false);
+      break;
+    case kAppThreadDereg:
+      HandleAppThreadDereg();
+      break;
+    default:
+      LOG(FATAL) << "Unrecognized app request type " << request.type;
+  }
+}
+
+void BgWorkers::HandleAppThreadDereg() {
+  ++(bg_context_->num_deregistered_app_threads);
+  if (bg_context_->num_deregistered_app_threads
+      == GlobalContext::get_num_app_threads()) {
+    ClientShutDownMsg msg;
+    int32_t name_node_id = GlobalContext::get_name_node_id();
+    (comm_bus_->*CommBusSendAny)(name_node_id, msg.get_mem(),
+      msg.get_size());
+    int32_t num_servers = GlobalContext::get_num_servers();
+    std::vector<int32_t> &server_ids = GlobalContext::get_server_ids();
+    for (int i = 0; i < num_servers; ++i) {
+      int32_t server_id = server_ids[i];
+      (comm_bus_->*CommBusSendAny)(server_id, msg.get_mem(),
+        msg.get_size());
+    }
   }
 }
 
@@ -372,6 +472,10 @@ void BgWorkers::HandleCreateTables(){
 	= bg_create_table_msg.get_thread_cache_capacity();
       client_table_config.oplog_capacity
 	= bg_create_table_msg.get_oplog_capacity();
+      client_table_config.table_info.value_bound
+        = bg_create_table_msg.get_value_bound();
+      client_table_config.oplog_dense_index_rows
+        = bg_create_table_msg.get_oplog_dense_index_rows();
 
       CreateTableMsg create_table_msg;
       create_table_msg.get_table_id() = bg_create_table_msg.get_table_id();
@@ -379,6 +483,7 @@ void BgWorkers::HandleCreateTables(){
       create_table_msg.get_row_type() = bg_create_table_msg.get_row_type();
       create_table_msg.get_row_capacity()
 	= bg_create_table_msg.get_row_capacity();
+      create_table_msg.get_value_bound() = bg_create_table_msg.get_value_bound();
       table_id = create_table_msg.get_table_id();
 
       // send msg to name node
@@ -419,11 +524,7 @@ void BgWorkers::HandleCreateTables(){
 }
 
 void BgWorkers::CheckForwardRowRequestToServer(int32_t app_thread_id,
-  RowRequestMsg &row_request_msg){
-
-  int32_t table_id = row_request_msg.get_table_id();
-  int32_t row_id = row_request_msg.get_row_id();
-  int32_t clock = row_request_msg.get_clock();
+  int32_t table_id, int32_t row_id, int32_t clock){
 
   // Check if the row exists in process cache
   auto table_iter = tables_->find(table_id);
@@ -437,10 +538,7 @@ void BgWorkers::CheckForwardRowRequestToServer(int32_t app_thread_id,
     if (found) {
       // TODO: do not send if it's PUSH mode
       if (row_accessor.GetClientRow()->GetClock() >= clock) {
-	RowRequestReplyMsg row_request_reply_msg;
-	size_t sent_size = comm_bus_->SendInProc(app_thread_id,
-          row_request_reply_msg.get_mem(), row_request_reply_msg.get_size());
-	CHECK_EQ(sent_size, row_request_reply_msg.get_size());
+	GetAppThreadSlot(app_thread_id).Post();
 	return;
       }
     }
@@ -449,7 +547,7 @@ void BgWorkers::CheckForwardRowRequestToServer(int32_t app_thread_id,
   std::pair<int32_t, int32_t> request_key(table_id, row_id);
   RowRequestInfo row_request;
   row_request.app_thread_id = app_thread_id;
-  row_request.clock = row_request_msg.get_clock();
+  row_request.clock = clock;
 
   // Version in request denotes the update version that the row on server can
   // see. Which should be 1 less than the current version number.
@@ -464,42 +562,18 @@ void BgWorkers::CheckForwardRowRequestToServer(int32_t app_thread_id,
 
   //VLOG(0) << "should_be_sent = " << should_be_sent;
 
-  if (should_be_sent) {
-    int32_t server_id = GlobalContext::GetRowPartitionServerID(table_id,
-      row_id);
-    size_t sent_size = (comm_bus_->*CommBusSendAny)(server_id,
-      row_request_msg.get_mem(), row_request_msg.get_size());
-    CHECK_EQ(sent_size, row_request_msg.get_size());
-  }
+  if (should_be_sent)
+    AddServerRowRequest(table_id, row_id, clock);
 }
 
 void BgWorkers::ApplyOpLogsToRowData(int32_t table_id,
                                      ClientTable *client_table, int32_t row_id,
                                      uint32_t version, AbstractRow *row_data) {
 
+  // OpLogs that are after (exclusively) version should be applied
   if (version + 1 < bg_context_->version) {
-    BgOpLog *bg_oplog
-        = bg_context_->row_request_oplog_mgr->OpLogIterInit(version + 1,
-          bg_context_->version - 1);
-    uint32_t oplog_version;
-
-    while (bg_oplog != NULL) {
-      BgOpLogPartition *bg_oplog_partition = bg_oplog->Get(table_id);
-      // OpLogs that are after (exclusively) version should be applied
-      RowOpLog *row_oplog = bg_oplog_partition->FindOpLog(row_id);
-      if (row_oplog != 0) {
-        int32_t column_id;
-        void *update;
-        update = row_oplog->BeginIterate(&column_id);
-        while (update != 0) {
-          VLOG(0) << "ApplyOpLogs update = " << update;
-          row_data->ApplyIncUnsafe(column_id, update);
-          update = row_oplog->Next(&column_id);
-        }
-      }
-      bg_oplog
-          = bg_context_->row_request_oplog_mgr->OpLogIterNext(&oplog_version);
-    }
+    bg_context_->row_request_oplog_mgr->ApplyOpLogs(table_id, row_id,
+      version + 1, bg_context_->version - 1, row_data);
   }
 
   TableOpLog &table_oplog = client_table->get_oplog();
@@ -527,6 +601,122 @@ void BgWorkers::HandleServerRowRequestReply(
   //VLOG(0) << "Server reply clock = " << clock;
   uint32_t version = server_row_request_reply_msg.get_version();
 
+  bg_context_->row_request_oplog_mgr->ServerAcknowledgeVersion(server_id,
+                                                               version);
+
+  InsertServerRow(table_id, row_id, clock, version,
+    server_row_request_reply_msg.get_row_data(),
+    server_row_request_reply_msg.get_row_size());
+}
+
+void BgWorkers::CheckForwardBatchRowRequestToServer(int32_t app_thread_id,
+  int32_t table_id, const int32_t *row_ids, int32_t num_rows,
+  int32_t clock) {
+
+  auto table_iter = tables_->find(table_id);
+  CHECK(table_iter != tables_->end());
+  ProcessStorage &table_storage = table_iter->second->get_process_storage();
+
+  int32_t num_pending_rows = 0;
+  for (int32_t i = 0; i < num_rows; ++i) {
+    int32_t row_id = row_ids[i];
+    {
+      RowAccessor row_accessor;
+      bool found = table_storage.Find(row_id, &row_accessor);
+      if (found && (row_accessor.GetClientRow()->GetClock() >= clock))
+        continue;
+    }
+
+    RowRequestInfo row_request;
+    row_request.app_thread_id = app_thread_id;
+    row_request.clock = clock;
+    row_request.version = bg_context_->version - 1;
+    ++num_pending_rows;
+
+    bool should_be_sent
+        = bg_context_->row_request_oplog_mgr->AddRowRequest(row_request,
+                                                            table_id, row_id);
+    if (should_be_sent)
+      AddServerRowRequest(table_id, row_id, clock);
+  }
+
+  if (num_pending_rows == 0) {
+    GetAppThreadSlot(app_thread_id).Post();
+    return;
+  }
+  bg_context_->batch_num_pending_rows[app_thread_id] = num_pending_rows;
+}
+
+void BgWorkers::AddServerRowRequest(int32_t table_id, int32_t row_id,
+  int32_t clock) {
+  int32_t server_id = bg_context_->routing_table.GetServerID(table_id,
+    row_id);
+  bg_context_->server_row_requests[server_id][
+      std::make_pair(table_id, clock)].push_back(row_id);
+}
+
+void BgWorkers::SendServerRowRequests() {
+  auto &server_row_requests = bg_context_->server_row_requests;
+  for (auto server_iter = server_row_requests.begin();
+       server_iter != server_row_requests.end(); server_iter++) {
+    int32_t server_id = server_iter->first;
+    for (auto request_iter = server_iter->second.begin();
+         request_iter != server_iter->second.end(); request_iter++) {
+      int32_t table_id = request_iter->first.first;
+      int32_t clock = request_iter->first.second;
+      std::vector<int32_t> &row_ids = request_iter->second;
+      if (row_ids.size() == 1) {
+        RowRequestMsg row_request_msg;
+        row_request_msg.get_table_id() = table_id;
+        row_request_msg.get_row_id() = row_ids[0];
+        row_request_msg.get_clock() = clock;
+        size_t sent_size = (comm_bus_->*CommBusSendAny)(server_id,
+          row_request_msg.get_mem(), row_request_msg.get_size());
+        CHECK_EQ(sent_size, row_request_msg.get_size());
+        continue;
+      }
+      BatchRowRequestMsg server_request_msg(row_ids.size());
+      server_request_msg.get_table_id() = table_id;
+      server_request_msg.get_clock() = clock;
+      memcpy(server_request_msg.get_row_ids(), row_ids.data(),
+             row_ids.size()*sizeof(int32_t));
+      size_t sent_size = (comm_bus_->*CommBusSendAny)(server_id,
+        server_request_msg.get_mem(), server_request_msg.get_size());
+      CHECK_EQ(sent_size, server_request_msg.get_size());
+    }
+  }
+  server_row_requests.clear();
+}
+
+void BgWorkers::HandleServerBatchRowRequestReply(
+    int32_t server_id,
+    ServerBatchRowRequestReplyMsg &server_batch_row_request_reply_msg) {
+
+  int32_t clock = server_batch_row_request_reply_msg.get_clock();
+  uint32_t version = server_batch_row_request_reply_msg.get_version();
+  int32_t num_rows = server_batch_row_request_reply_msg.get_num_rows();
+
+  bg_context_->row_request_oplog_mgr->ServerAcknowledgeVersion(server_id,
+                                                               version);
+
+  const uint8_t *mem = reinterpret_cast<const uint8_t*>(
+      server_batch_row_request_reply_msg.get_data());
+  size_t offset = 0;
+  for (int32_t i = 0; i < num_rows; ++i) {
+    int32_t table_id = *(reinterpret_cast<const int32_t*>(mem + offset));
+    offset += sizeof(int32_t);
+    int32_t row_id = *(reinterpret_cast<const int32_t*>(mem + offset));
+    offset += sizeof(int32_t);
+    size_t row_size = *(reinterpret_cast<const size_t*>(mem + offset));
+    offset += sizeof(size_t);
+    InsertServerRow(table_id, row_id, clock, version, mem + offset, row_size);
+    offset += row_size;
+  }
+}
+
+void BgWorkers::InsertServerRow(int32_t table_id, int32_t row_id,
+  int32_t clock, uint32_t version, const void *data, size_t row_size) {
+
   auto table_iter = tables_->find(table_id);
   CHECK(table_iter != tables_->end()) << "Cannot find table " << table_id;
   ClientTable *client_table = table_iter->second;
@@ -535,11 +725,7 @@ void BgWorkers::HandleServerRowRequestReply(
   AbstractRow *row_data
     = ClassRegistry<AbstractRow>::GetRegistry().CreateObject(row_type);
 
-  row_data->Deserialize(server_row_request_reply_msg.get_row_data(),
-    server_row_request_reply_msg.get_row_size());
-
-  bg_context_->row_request_oplog_mgr->ServerAcknowledgeVersion(server_id,
-                                                               version);
+  row_data->Deserialize(data, row_size);
 
   ApplyOpLogsToRowData(table_id, client_table, row_id, version, row_data);
 
@@ -551,27 +737,46 @@ void BgWorkers::HandleServerRowRequestReply(
     = bg_context_->row_request_oplog_mgr->InformReply(table_id, row_id, clock,
     bg_context_->version, &app_thread_ids);
 
-  if (clock_to_request >= 0) {
-    RowRequestMsg row_request_msg;
-    row_request_msg.get_table_id() = table_id;
-    row_request_msg.get_row_id() = row_id;
-    row_request_msg.get_clock() = clock_to_request;
-    int32_t server_id = GlobalContext::GetRowPartitionServerID(table_id,
-      row_id);
-    VLOG(0) << "send to server " << server_id;
-    size_t sent_size = (comm_bus_->*CommBusSendAny)(server_id,
-      row_request_msg.get_mem(), row_request_msg.get_size());
-    CHECK_EQ(sent_size, row_request_msg.get_size());
-  }
+  if (clock_to_request >= 0)
+    AddServerRowRequest(table_id, row_id, clock_to_request);
 
-  std::pair<int32_t, int32_t> request_key(table_id, row_id);
-  RowRequestReplyMsg row_request_reply_msg;
+  ReplyAppThreads(app_thread_ids);
+}
+
+void BgWorkers::ReplyAppThreads(const std::vector<int32_t> &app_thread_ids) {
+  std::map<int32_t, int32_t> &batch_num_pending_rows
+      = bg_context_->batch_num_pending_rows;
 
   for (int i = 0; i < (int) app_thread_ids.size(); ++i) {
+    // An app thread waiting on a batch request is replied once, after all
+    // rows in its batch are available.
+    auto batch_iter = batch_num_pending_rows.find(app_thread_ids[i]);
+    if (batch_iter != batch_num_pending_rows.end()) {
+      --(batch_iter->second);
+      if (batch_iter->second > 0)
+        continue;
+      batch_num_pending_rows.erase(batch_iter);
+    }
     //LOG(0) << "Reply to app thread " << app_thread_ids[i];
-    size_t sent_size = comm_bus_->SendInProc(app_thread_ids[i],
-      row_request_reply_msg.get_mem(), row_request_reply_msg.get_size());
-    CHECK_EQ(sent_size, row_request_reply_msg.get_size());
+    GetAppThreadSlot(app_thread_ids[i]).Post();
+  }
+}
+
+void BgWorkers::HandleRowMigrateMsg(RowMigrateMsg &row_migrate_msg) {
+  // Queued requests are routed by the current routing table.
+  SendServerRowRequests();
+  bg_context_->routing_table.MigrateRows(row_migrate_msg.get_version(),
+    row_migrate_msg.get_data(), row_migrate_msg.get_num_rows(),
+    row_migrate_msg.get_dst_server_id());
+
+  // Everything sent to the source before this message reaches it first and
+  // everything sent to the destination afterwards comes after this message.
+  int32_t server_ids[] = {row_migrate_msg.get_src_server_id(),
+                          row_migrate_msg.get_dst_server_id()};
+  for (int i = 0; i < 2; ++i) {
+    size_t sent_size = (comm_bus_->*CommBusSendAny)(server_ids[i],
+      row_migrate_msg.get_mem(), row_migrate_msg.get_size());
+    CHECK_EQ(sent_size, row_migrate_msg.get_size());
   }
 }
 
@@ -637,7 +842,25 @@ bool BgWorkers::SSPGetRowOpLog(TableOpLog &table_oplog, int32_t row_id,
   return table_oplog.GetEraseOpLog(row_id, row_oplog_ptr);
 }
 
-BgOpLog *BgWorkers::GetOpLogAndIndex() {
+void BgWorkers::DeferRowOpLog(TableOpLog &table_oplog, int32_t row_id,
+                              RowOpLog *row_oplog, size_t update_size) {
+  std::vector<int32_t> column_ids;
+  std::vector<uint8_t> updates(row_oplog->GetSize()*update_size);
+  int32_t column_id;
+  void *update = row_oplog->BeginIterate(&column_id);
+  while (update != 0) {
+    memcpy(updates.data() + column_ids.size()*update_size, update,
+           update_size);
+    column_ids.push_back(column_id);
+    update = row_oplog->Next(&column_id);
+  }
+  // Merges with updates made since the row oplog was taken out.
+  table_oplog.BatchInc(row_id, column_ids.data(), updates.data(),
+                       column_ids.size());
+  delete row_oplog;
+}
+
+BgOpLog *BgWorkers::GetOpLogAndIndex(bool clock_advanced) {
   std::vector<int32_t> server_ids = GlobalContext::get_server_ids();
   int32_t local_bg_index = ThreadContext::get_id() - id_st_;
   // get thread-specific data structure to assist oplog message creation
@@ -646,22 +869,122 @@ BgOpLog *BgWorkers::GetOpLogAndIndex() {
     = bg_context_->server_table_oplog_size_map;
   std::map<int32_t, size_t> &table_num_bytes_by_server
       = bg_context_->table_server_oplog_size_map;
+  OpLogSendBudget &oplog_send_budget = bg_context_->oplog_send_budget;
 
-  BgOpLog *bg_oplog = new BgOpLog;
+  BgOpLog *bg_oplog = bg_context_->oplog_pool.Get();
 
+  // table id -> (row id, row oplog) taken out of the table's oplog
+  std::map<int32_t, std::vector<std::pair<int32_t, RowOpLog*> > >
+      table_row_oplogs;
+  std::vector<int32_t> deferred_row_ids;
+  std::vector<int32_t> indexed_row_ids;
   for (auto table_iter = tables_->cbegin(); table_iter != tables_->cend();
        table_iter++) {
     int32_t table_id = table_iter->first;
     TableOpLog &table_oplog = table_iter->second->get_oplog();
+    std::vector<std::pair<int32_t, RowOpLog*> > &row_oplogs
+        = table_row_oplogs[table_id];
+
+    // Rows deferred at the last clock are pending without being indexed.
+    oplog_send_budget.GetDeferredRows(table_id, &deferred_row_ids);
+    for (auto row_iter = deferred_row_ids.cbegin();
+         row_iter != deferred_row_ids.cend(); row_iter++) {
+      RowOpLog *row_oplog = 0;
+      if (GetRowOpLog(table_oplog, *row_iter, &row_oplog) && row_oplog != 0)
+        row_oplogs.push_back(std::make_pair(*row_iter, row_oplog));
+    }
 
     // Get OpLog index
-    cuckoohash_map<int32_t, bool> *new_table_oplog_index_ptr
-        = table_iter->second->GetAndResetOpLogIndex(local_bg_index);
+    table_iter->second->GetAndResetOpLogIndex(local_bg_index,
+                                              &indexed_row_ids);
+
+    for (auto row_iter = indexed_row_ids.cbegin();
+         row_iter != indexed_row_ids.cend(); row_iter++) {
+      int32_t row_id = *row_iter;
+      RowOpLog *row_oplog = 0;
+      bool found = GetRowOpLog(table_oplog, row_id, &row_oplog);
+      if (!found)
+        continue;
+
+      if (found && (row_oplog == 0)) {
+        table_oplog_index_[table_id][row_id] = true;
+        VLOG(0) << "found && row_oplog == 0";
+        continue;
+      }
+      row_oplogs.push_back(std::make_pair(row_id, row_oplog));
+    }
 
-    size_t table_update_size
-        = table_iter->second->get_sample_row()->get_update_size();
-    BgOpLogPartition *bg_table_oplog = new BgOpLogPartition(table_id,
-                                                            table_update_size);
+    if (bg_oplog->Find(table_id) == 0) {
+      size_t table_update_size
+          = table_iter->second->get_sample_row()->get_update_size();
+      bg_oplog->Add(table_id, new BgOpLogPartition(table_id,
+                                                   table_update_size));
+    }
+  }
+
+  // Put the row oplogs that do not fit in this clock's budget back.
+  if (clock_advanced && oplog_send_budget.is_limited()) {
+    std::vector<OpLogSendBudget::RowOpLogInfo> row_oplog_infos;
+    std::vector<int32_t> column_ids;
+    std::vector<uint8_t> updates;
+    for (auto table_iter = table_row_oplogs.cbegin();
+         table_iter != table_row_oplogs.cend(); table_iter++) {
+      int32_t table_id = table_iter->first;
+      ClientTable *client_table = (*tables_)[table_id];
+      const AbstractRow *sample_row = client_table->get_sample_row();
+      size_t update_size = sample_row->get_update_size();
+      BgOpLogPartition *bg_table_oplog = bg_oplog->Get(table_id);
+      for (auto row_iter = table_iter->second.cbegin();
+           row_iter != table_iter->second.cend(); row_iter++) {
+        RowOpLog *row_oplog = row_iter->second;
+        column_ids.clear();
+        updates.resize(row_oplog->GetSize()*update_size);
+        int32_t column_id;
+        void *update = row_oplog->BeginIterate(&column_id);
+        while (update != 0) {
+          memcpy(updates.data() + column_ids.size()*update_size, update,
+                 update_size);
+          column_ids.push_back(column_id);
+          update = row_oplog->Next(&column_id);
+        }
+
+        OpLogSendBudget::RowOpLogInfo row_oplog_info;
+        row_oplog_info.table_id = table_id;
+        row_oplog_info.row_id = row_iter->first;
+        row_oplog_info.size = bg_table_oplog->GetMaxSerializedRowOpLogSize(
+            column_ids.size());
+        row_oplog_info.magnitude = sample_row->GetUpdatesMagnitude(
+            column_ids.data(), updates.data(), column_ids.size());
+        row_oplog_info.max_deferred_clocks
+            = OpLogSendBudget::GetMaxDeferredClocks(
+                client_table->get_staleness());
+        row_oplog_infos.push_back(row_oplog_info);
+      }
+    }
+
+    std::vector<bool> send;
+    oplog_send_budget.Select(row_oplog_infos, &send);
+    size_t row_index = 0;
+    for (auto table_iter = table_row_oplogs.begin();
+         table_iter != table_row_oplogs.end(); table_iter++) {
+      ClientTable *client_table = (*tables_)[table_iter->first];
+      TableOpLog &table_oplog = client_table->get_oplog();
+      size_t update_size = client_table->get_sample_row()->get_update_size();
+      for (auto row_iter = table_iter->second.begin();
+           row_iter != table_iter->second.end(); row_iter++, row_index++) {
+        if (send[row_index])
+          continue;
+        DeferRowOpLog(table_oplog, row_iter->first, row_iter->second,
+                      update_size);
+        row_iter->second = 0;
+      }
+    }
+  }
+
+  for (auto table_iter = table_row_oplogs.cbegin();
+       table_iter != table_row_oplogs.cend(); table_iter++) {
+    int32_t table_id = table_iter->first;
+    BgOpLogPartition *bg_table_oplog = bg_oplog->Get(table_id);
 
     // Memory layout of serialized OpLogs for one row:
     // 1. int32_t : num of rows
@@ -676,35 +999,28 @@ BgOpLog *BgWorkers::GetOpLogAndIndex() {
       table_num_bytes_by_server[server_id] = sizeof(int32_t);
     }
 
-    for (auto oplog_index_iter = new_table_oplog_index_ptr->cbegin();
-         !oplog_index_iter.is_end(); oplog_index_iter++) {
-      int32_t row_id = oplog_index_iter->first;
-      RowOpLog *row_oplog = 0;
-      bool found = GetRowOpLog(table_oplog, row_id, &row_oplog);
-      if (!found)
-        continue;
-
-      if (found && (row_oplog == 0)) {
-        table_oplog_index_[table_id][row_id] = true;
-        VLOG(0) << "found && row_oplog == 0";
+    for (auto row_iter = table_iter->second.cbegin();
+         row_iter != table_iter->second.cend(); row_iter++) {
+      int32_t row_id = row_iter->first;
+      RowOpLog *row_oplog = row_iter->second;
+      if (row_oplog == 0)
         continue;
-      }
 
       // update oplog message size
-      int32_t server_id = GlobalContext::GetRowPartitionServerID(table_id,
-                                                                 row_id);
+      int32_t server_id = bg_context_->routing_table.GetServerID(table_id,
+      row_id);
       int32_t num_updates = row_oplog->GetSize();
       // 1) row id
       // 2) number of updates in that row
       // 3) total size for column ids
       // 4) total size for update array
-      table_num_bytes_by_server[server_id] += sizeof(int32_t) + sizeof(int32_t)
-        + sizeof(int32_t)*num_updates + table_update_size*num_updates;
+      // Encoded or quantized rows are bounded instead, CreateOpLogMsgs()
+      // trims the message to the bytes actually written.
+      table_num_bytes_by_server[server_id]
+        += bg_table_oplog->GetMaxSerializedRowOpLogSize(num_updates);
       VLOG(0) << "Calling InsertOpLog";
       bg_table_oplog->InsertOpLog(row_id, row_oplog);
     }
-    bg_oplog->Add(table_id, bg_table_oplog);
-    delete new_table_oplog_index_ptr;
 
     for (auto server_iter = table_num_bytes_by_server.begin();
       server_iter != table_num_bytes_by_server.end(); server_iter++) {
@@ -724,11 +1040,12 @@ void BgWorkers::CreateOpLogMsgs(const BgOpLog *bg_oplog) {
     = bg_context_->server_oplog_msg_size_map;
 
   std::map<int32_t, std::map<int32_t, void*> > table_server_mem_map;
+  std::map<int32_t, OpLogSerializer> oplog_serializers;
 
   for (auto server_iter = server_table_oplog_size_map.begin();
     server_iter != server_table_oplog_size_map.end(); server_iter++) {
-    OpLogSerializer oplog_serializer;
     int32_t server_id = server_iter->first;
+    OpLogSerializer &oplog_serializer = oplog_serializers[server_id];
     server_oplog_msg_size_map[server_id]
         = oplog_serializer.Init(server_iter->second);
 
@@ -752,16 +1069,44 @@ void BgWorkers::CreateOpLogMsgs(const BgOpLog *bg_oplog) {
     }
   }
   VLOG(0) << "Here";
+  int32_t local_bg_index = ThreadContext::get_id() - id_st_;
+  std::vector<int32_t> residual_row_ids;
   for (auto table_iter = tables_->cbegin(); table_iter != tables_->cend();
     table_iter++) {
     int32_t table_id = table_iter->first;
     BgOpLogPartition *oplog_partition = bg_oplog->Get(table_id);
-    oplog_partition->SerializeByServer(&(table_server_mem_map[table_id]));
+    std::map<int32_t, size_t> size_by_server;
+    oplog_partition->SerializeByServer(&(table_server_mem_map[table_id]),
+                                       bg_context_->routing_table,
+                                       &size_by_server,
+                                       &(table_iter->second->get_oplog()),
+                                       &residual_row_ids);
+    // The residuals are sent at the next clock even if the rows get no
+    // other update.
+    if (!residual_row_ids.empty())
+      table_iter->second->AddOpLogIndex(local_bg_index, residual_row_ids);
+    for (auto size_iter = size_by_server.cbegin();
+         size_iter != size_by_server.cend(); size_iter++) {
+      server_table_oplog_size_map[size_iter->first][table_id]
+          = size_iter->second;
+    }
+  }
+
+  // Encoded tables may take less than the space reserved for them.
+  for (auto server_iter = server_table_oplog_size_map.begin();
+    server_iter != server_table_oplog_size_map.end(); server_iter++) {
+    int32_t server_id = server_iter->first;
+    size_t msg_size
+        = oplog_serializers[server_id].Compact(server_iter->second);
+    if (msg_size != server_oplog_msg_size_map[server_id]) {
+      server_oplog_msg_size_map[server_id] = msg_size;
+      server_oplog_msg_map[server_id]->get_avai_size() = msg_size;
+    }
   }
 }
 
 void BgWorkers::HandleClockMsg(bool clock_advanced) {
-  BgOpLog *bg_oplog = GetOpLogAndIndex();
+  BgOpLog *bg_oplog = GetOpLogAndIndex(clock_advanced);
   VLOG(0) << "Got OpLog and index";
 
   CreateOpLogMsgs(bg_oplog);
@@ -787,7 +1132,7 @@ void BgWorkers::HandleClockMsg(bool clock_advanced) {
   ++bg_context_->version;
   bg_context_->row_request_oplog_mgr->InformVersionInc();
   if (!tracked) {
-    delete bg_oplog;
+    bg_context_->oplog_pool.Put(bg_oplog);
   }
 }
 
@@ -808,17 +1153,29 @@ void *BgWorkers::SSPBgThreadMain(void *thread_id) {
   REGISTER_THREAD_FOR_STATS(false);
 
   int32_t num_connected_app_threads = 0;
-  int32_t num_deregistered_app_threads = 0;
   int32_t num_shutdown_acked_servers = 0;
 
   bg_context_.reset(new BgContext);
   bg_context_->version = 0;
+  bg_context_->num_deregistered_app_threads = 0;
+  {
+    size_t oplog_bytes_per_clock = GlobalContext::get_oplog_bytes_per_clock();
+    if (oplog_bytes_per_clock > 0) {
+      size_t thread_bytes_per_clock = oplog_bytes_per_clock
+          / GlobalContext::get_num_bg_threads();
+      bg_context_->oplog_send_budget.Init(thread_bytes_per_clock > 0 ?
+                                          thread_bytes_per_clock : 1);
+    }
+  }
   switch (GlobalContext::get_consistency_model()) {
     case SSP:
-      bg_context_->row_request_oplog_mgr = new SSPRowRequestOpLogMgr;
+      bg_context_->row_request_oplog_mgr
+          = new SSPRowRequestOpLogMgr(&bg_context_->oplog_pool);
       break;
     case SSPPush:
-      bg_context_->row_request_oplog_mgr = new SSPPushRowRequestOpLogMgr;
+    case SSPPushValueBound:
+      bg_context_->row_request_oplog_mgr
+          = new SSPPushRowRequestOpLogMgr(&bg_context_->oplog_pool);
       break;
     default:
       LOG(FATAL) << "Unrecognized consistency model: "
@@ -883,8 +1240,18 @@ void *BgWorkers::SSPBgThreadMain(void *thread_id) {
   MsgType msg_type;
   void *msg_mem;
   bool destroy_mem = false;
+  // Messages received while row requests are queued.
+  int32_t num_delaying_msgs = 0;
   while (1) {
-    CommBusRecvAnyWrapper(&sender_id, &zmq_msg);
+    if (bg_context_->server_row_requests.empty()) {
+      num_delaying_msgs = 0;
+      CommBusRecvAnyWrapper(&sender_id, &zmq_msg);
+    } else if (++num_delaying_msgs > kMaxRowRequestFlushDelay
+               || !(comm_bus_->*CommBusRecvAsyncAny)(&sender_id, &zmq_msg)) {
+      SendServerRowRequests();
+      num_delaying_msgs = 0;
+      CommBusRecvAnyWrapper(&sender_id, &zmq_msg);
+    }
 
     msg_type = MsgBase::get_msg_type(zmq_msg.data());
     destroy_mem = false;
@@ -911,23 +1278,9 @@ void *BgWorkers::SSPBgThreadMain(void *thread_id) {
               << GlobalContext::get_num_app_threads();
         }
         break;
-      case kAppThreadDereg:
+      case kBgAppRequest:
         {
-          ++num_deregistered_app_threads;
-          if (num_deregistered_app_threads
-              == GlobalContext::get_num_app_threads()) {
-            ClientShutDownMsg msg;
-            int32_t name_node_id = GlobalContext::get_name_node_id();
-            (comm_bus_->*CommBusSendAny)(name_node_id, msg.get_mem(),
-              msg.get_size());
-            int32_t num_servers = GlobalContext::get_num_servers();
-            std::vector<int32_t> &server_ids = GlobalContext::get_server_ids();
-            for (int i = 0; i < num_servers; ++i) {
-              int32_t server_id = server_ids[i];
-              (comm_bus_->*CommBusSendAny)(server_id, msg.get_mem(),
-	        msg.get_size());
-            }
-          }
+          HandleAppRequests();
         }
         break;
       case kServerShutDownAck:
@@ -943,27 +1296,24 @@ void *BgWorkers::SSPBgThreadMain(void *thread_id) {
 	}
       }
       break;
-    case kRowRequest:
-      {
-	//VLOG(0) << "Get RowRequest";
-	RowRequestMsg row_request_msg(msg_mem);
-	CheckForwardRowRequestToServer(sender_id, row_request_msg);
-      }
-      break;
     case kServerRowRequestReply:
       {
 	ServerRowRequestReplyMsg server_row_request_reply_msg(msg_mem);
 	HandleServerRowRequestReply(sender_id, server_row_request_reply_msg);
       }
       break;
-    case kBgClock:
+    case kServerBatchRowRequestReply:
       {
-        HandleClockMsg(true);
+	ServerBatchRowRequestReplyMsg server_batch_row_request_reply_msg(
+            msg_mem);
+	HandleServerBatchRowRequestReply(sender_id,
+                                         server_batch_row_request_reply_msg);
       }
       break;
-      case kBgSendOpLog:
+    case kRowMigrate:
       {
-        HandleClockMsg(false);
+	RowMigrateMsg row_migrate_msg(msg_mem);
+	HandleRowMigrateMsg(row_migrate_msg);
       }
       break;
       case kServerPushRow:
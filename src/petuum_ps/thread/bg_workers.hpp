@@ -14,6 +14,10 @@
 #include "petuum_ps/thread/bg_oplog.hpp"
 #include "petuum_ps/comm_bus/comm_bus.hpp"
 #include "petuum_ps/thread/row_request_oplog_mgr.hpp"
+#include "petuum_ps/thread/row_routing_table.hpp"
+#include "petuum_ps/thread/oplog_send_budget.hpp"
+#include "petuum_ps/thread/app_request_ring.hpp"
+#include "petuum_ps/thread/completion_slot.hpp"
 #include "petuum_ps/util/vector_clock.hpp"
 
 namespace petuum {
@@ -36,8 +40,16 @@ public:
   static bool RequestRow(int32_t table_id, int32_t row_id, int32_t clock);
   static void RequestRowAsync(int32_t table_id, int32_t row_id, int32_t clock);
   static void GetAsyncRowRequestReply();
+  // Request a set of rows of a table in one round trip per bg thread. Blocks
+  // until all rows have been inserted into process storage. The calling
+  // thread must not have pending async requests.
+  static void RequestRowBatch(int32_t table_id,
+    const std::vector<int32_t> &row_ids, int32_t clock);
   static void ClockAllTables();
   static void SendOpLogsAllTables();
+  // Ask the bg thread of oplog partition partition_num to send its pending
+  // oplogs of all tables without advancing the clock.
+  static void SendOpLogsBgThread(int32_t partition_num);
 
   static int32_t GetSystemClock();
   static void WaitSystemClock(int32_t my_clock);
@@ -64,6 +76,28 @@ private:
 
     /* Data members needed for server push */
     VectorClock server_vector_clock;
+
+    // app thread id -> number of rows that are yet to be replied for that
+    // thread's batch row request
+    std::map<int32_t, int32_t> batch_num_pending_rows;
+
+    // Server of each row, updated when rows are migrated between servers.
+    RowRoutingTable routing_table;
+
+    // Limits the oplog bytes sent per clock, see
+    // TableGroupConfig::oplog_bytes_per_clock.
+    OpLogSendBudget oplog_send_budget;
+
+    // BgOpLogs released by row_request_oplog_mgr, reused by
+    // GetOpLogAndIndex().
+    BgOpLogPool oplog_pool;
+
+    // server id -> (table id, clock) -> rows to request, queued by
+    // AddServerRowRequest() until SendServerRowRequests().
+    std::map<int32_t, std::map<std::pair<int32_t, int32_t>,
+                               std::vector<int32_t> > > server_row_requests;
+
+    int32_t num_deregistered_app_threads;
   };
 
   /* Functions that differentiate SSP, SSPPush and SSPPushValue */
@@ -77,7 +111,17 @@ private:
   /* Communication functions */
   static void ConnectToNameNodeOrServer(int32_t server_id);
   static void ConnectToBg(int32_t bg_id);
-  static void SendToAllLocalBgThreads(void *msg, int32_t size);
+  // App threads talk to the bg threads of their process through the bg
+  // threads' AppRequestRings and their own CompletionSlots rather than
+  // CommBus, which only carries a BgAppRequestMsg to wake up a bg thread
+  // whose ring was empty.
+  static void PushAppRequest(int32_t partition_num, const AppRequest &request);
+  static void PushToAllLocalBgThreads(AppRequest *request);
+  static CompletionSlot &GetAppThreadSlot(int32_t app_thread_id);
+  // Pop the requests announced in the bg thread's AppRequestRing.
+  static void HandleAppRequests();
+  static void HandleAppRequest(const AppRequest &request);
+  static void HandleAppThreadDereg();
 
   /* Functions for creating ClientRow */
   static ClientRow *CreateSSPClientRow(int32_t clock, AbstractRow *row_data);
@@ -88,13 +132,37 @@ private:
 
   /* Operate on thread specific BgContext*/
   static void CheckForwardRowRequestToServer(int32_t app_thread_id,
-    RowRequestMsg &row_request_msg);
+    int32_t table_id, int32_t row_id, int32_t clock);
   static void ApplyOpLogsToRowData(int32_t table_id, ClientTable *client_table,
                                    int32_t row_id, uint32_t row_version,
                                    AbstractRow *row_data);
   static void HandleServerRowRequestReply(
       int32_t server_id,
       ServerRowRequestReplyMsg &server_row_request_reply_msg);
+  static void CheckForwardBatchRowRequestToServer(int32_t app_thread_id,
+    int32_t table_id, const int32_t *row_ids, int32_t num_rows,
+    int32_t clock);
+  static void HandleServerBatchRowRequestReply(
+      int32_t server_id,
+      ServerBatchRowRequestReplyMsg &server_batch_row_request_reply_msg);
+  // Insert a row replied by server into process storage and reply the app
+  // threads whose requests are satisfied by it.
+  static void InsertServerRow(int32_t table_id, int32_t row_id, int32_t clock,
+    uint32_t version, const void *row_data, size_t row_size);
+  static void ReplyAppThreads(const std::vector<int32_t> &app_thread_ids);
+  // Row requests to servers are queued and sent one message per server,
+  // table and clock, so that a burst of requests from app threads costs a
+  // few messages. The queue is sent after each batch of app requests, when
+  // the bg thread runs out of messages, and at the latest after
+  // kMaxRowRequestFlushDelay messages.
+  static void AddServerRowRequest(int32_t table_id, int32_t row_id,
+    int32_t clock);
+  static void SendServerRowRequests();
+  static const int32_t kMaxRowRequestFlushDelay = 16;
+
+  // Route the rows to the destination server and acknowledge to both
+  // servers.
+  static void HandleRowMigrateMsg(RowMigrateMsg &row_migrate_msg);
 
   //static void CreateSendOpLogs(BgOpLog *bg_oplog, bool is_clock);
   static void ShutDownClean();
@@ -113,13 +181,22 @@ private:
   static bool SSPValueGetRowOpLog(TableOpLog &table_oplog,
                                   int32_t row_id, RowOpLog **row_oplog_ptr);
 
-  static BgOpLog *GetOpLogAndIndex();
+  // Take the pending row oplogs out of the tables' oplogs. At a clock, rows
+  // over the thread's oplog_send_budget are put back for a later clock.
+  static BgOpLog *GetOpLogAndIndex(bool clock_advanced);
+  // Put row_oplog back into table_oplog and delete it.
+  static void DeferRowOpLog(TableOpLog &table_oplog, int32_t row_id,
+    RowOpLog *row_oplog, size_t update_size);
   static void CreateOpLogMsgs(const BgOpLog *bg_oplog);
 
   static std::vector<pthread_t> threads_;
   static std::vector<int32_t> thread_ids_;
   static std::map<int32_t, ClientTable* > *tables_;
   static int32_t id_st_;
+  // One per bg thread.
+  static std::vector<AppRequestRing*> request_rings_;
+  // Indexed by app thread id - GlobalContext::get_local_id_min().
+  static CompletionSlot *app_thread_slots_;
 
   static pthread_barrier_t init_barrier_;
   static pthread_barrier_t create_table_barrier_;
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include <mutex>
+#include <condition_variable>
+#include <boost/noncopyable.hpp>
+
+namespace petuum {
+
+// Where a bg thread replies to the requests of one app thread. Counts the
+// replies not yet waited for, so an app thread may wait for the replies of
+// several requests in turn.
+class CompletionSlot : boost::noncopyable {
+public:
+  CompletionSlot():
+      num_replies_(0) { }
+
+  void Post() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    ++num_replies_;
+    cv_.notify_one();
+  }
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (num_replies_ == 0) {
+      cv_.wait(lock);
+    }
+    --num_replies_;
+  }
+
+private:
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  int32_t num_replies_;
+};
+
+}  // namespace petuum
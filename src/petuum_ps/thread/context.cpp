@@ -34,6 +34,10 @@ int32_t GlobalContext::client_id_ = 0;
 
 std::vector<int32_t> GlobalContext::server_ids_;
 
+std::vector<GlobalContext::RowPartition> GlobalContext::row_partitions_;
+
+std::vector<GlobalContext::TableMsgFormat> GlobalContext::table_msg_formats_;
+
 int32_t GlobalContext::server_ring_size_;
 
 ConsistencyModel GlobalContext::consistency_model_;
@@ -41,4 +45,16 @@ ConsistencyModel GlobalContext::consistency_model_;
 int32_t GlobalContext::local_id_min_;
 
 bool GlobalContext::aggressive_cpu_;
+
+bool GlobalContext::row_migration_ = false;
+
+int32_t GlobalContext::row_migration_interval_;
+
+double GlobalContext::row_migration_imbalance_;
+
+int32_t GlobalContext::num_server_apply_threads_ = 1;
+
+size_t GlobalContext::oplog_bytes_per_clock_ = 0;
+
+size_t GlobalContext::oplog_flush_bytes_ = 0;
 }   // namespace petuum
@@ -205,13 +205,55 @@ public:
     return server_ids_;
   }
 
-  static int32_t GetBgPartitionNum(int32_t row_id) {
-    return row_id % num_bg_threads_;
+  // Set the row partitioning of table_id from table_info. Must be called
+  // before table_id is accessed, and before any thread accesses tables
+  // concurrently (it is called from TableGroup::CreateTable()). Tables that
+  // are not set use ModuloPartition.
+  static void SetRowPartition(int32_t table_id, const TableInfo &table_info) {
+    CHECK_GE(table_id, 0);
+    if (table_id >= static_cast<int32_t>(row_partitions_.size()))
+      row_partitions_.resize(table_id + 1);
+    RowPartition &partition = row_partitions_[table_id];
+    partition.type = table_info.row_partition_type;
+    partition.range = table_info.row_partition_range;
+    partition.func = table_info.row_partition_func;
+    if (partition.type == RangePartition)
+      CHECK_GT(partition.range, 0) << "table " << table_id;
+    if (partition.type == CustomPartition)
+      CHECK(partition.func != 0) << "table " << table_id;
+  }
+
+  // Set the message codec and update precision of table_id from table_info,
+  // see SetRowPartition(). Tables that are not set use RawCodec and
+  // FullPrecision.
+  static void SetTableMsgFormat(int32_t table_id,
+    const TableInfo &table_info) {
+    CHECK_GE(table_id, 0);
+    if (table_id >= static_cast<int32_t>(table_msg_formats_.size()))
+      table_msg_formats_.resize(table_id + 1);
+    table_msg_formats_[table_id].codec = table_info.msg_codec;
+    table_msg_formats_[table_id].precision = table_info.update_precision;
+  }
+
+  static MsgCodec GetTableMsgCodec(int32_t table_id) {
+    if (table_id >= static_cast<int32_t>(table_msg_formats_.size()))
+      return RawCodec;
+    return table_msg_formats_[table_id].codec;
+  }
+
+  static UpdatePrecision GetTableUpdatePrecision(int32_t table_id) {
+    if (table_id >= static_cast<int32_t>(table_msg_formats_.size()))
+      return FullPrecision;
+    return table_msg_formats_[table_id].precision;
+  }
+
+  static int32_t GetBgPartitionNum(int32_t table_id, int32_t row_id) {
+    return GetRowPartition(table_id, row_id, num_bg_threads_);
   }
 
   // get the id of the server who is responsible for holding that row
   static int32_t GetRowPartitionServerID(int32_t table_id, int32_t row_id){
-    int32_t server_id_idx = row_id % num_servers_;
+    int32_t server_id_idx = GetRowPartition(table_id, row_id, num_servers_);
     //VLOG(0) << "server_idx_ = " << server_id_idx;
     return server_ids_[server_id_idx];
   }
@@ -232,6 +274,50 @@ public:
     return aggressive_cpu_;
   }
 
+  static void SetRowMigration(bool row_migration, int32_t interval,
+    double imbalance) {
+    row_migration_ = row_migration;
+    row_migration_interval_ = interval;
+    row_migration_imbalance_ = imbalance;
+  }
+
+  static bool get_row_migration() {
+    return row_migration_;
+  }
+
+  static int32_t get_row_migration_interval() {
+    return row_migration_interval_;
+  }
+
+  static double get_row_migration_imbalance() {
+    return row_migration_imbalance_;
+  }
+
+  static void SetNumServerApplyThreads(int32_t num_server_apply_threads) {
+    CHECK_GE(num_server_apply_threads, 1);
+    num_server_apply_threads_ = num_server_apply_threads;
+  }
+
+  static int32_t get_num_server_apply_threads() {
+    return num_server_apply_threads_;
+  }
+
+  static void SetOpLogBytesPerClock(size_t oplog_bytes_per_clock) {
+    oplog_bytes_per_clock_ = oplog_bytes_per_clock;
+  }
+
+  static size_t get_oplog_bytes_per_clock() {
+    return oplog_bytes_per_clock_;
+  }
+
+  static void SetOpLogFlushBytes(size_t oplog_flush_bytes) {
+    oplog_flush_bytes_ = oplog_flush_bytes;
+  }
+
+  static size_t get_oplog_flush_bytes() {
+    return oplog_flush_bytes_;
+  }
+
   static CommBus* comm_bus;
 
   static const int32_t kMaxNumThreadsPerClient = 1000;
@@ -240,6 +326,64 @@ public:
   static const int32_t kInitThreadIDOffset = 200;
   static const int32_t kStripedLockExpansionFactor = 20;
 private:
+  struct RowPartition {
+    RowPartition():
+        type(ModuloPartition),
+        range(0),
+        func(0) { }
+
+    RowPartitionType type;
+    int32_t range;
+    RowPartitionFunc func;
+  };
+
+  struct TableMsgFormat {
+    TableMsgFormat():
+        codec(RawCodec),
+        precision(FullPrecision) { }
+
+    MsgCodec codec;
+    UpdatePrecision precision;
+  };
+
+  static int32_t GetRowPartition(int32_t table_id, int32_t row_id,
+    int32_t num_partitions) {
+    if (table_id >= static_cast<int32_t>(row_partitions_.size()))
+      return row_id % num_partitions;
+    const RowPartition &partition = row_partitions_[table_id];
+    switch (partition.type) {
+      case ModuloPartition:
+        return row_id % num_partitions;
+      case HashPartition:
+        {
+          // MurmurHash3 finalizer.
+          uint32_t h = static_cast<uint32_t>(row_id)
+            ^ (static_cast<uint32_t>(table_id) * 0x9E3779B1u);
+          h ^= h >> 16;
+          h *= 0x85EBCA6Bu;
+          h ^= h >> 13;
+          h *= 0xC2B2AE35u;
+          h ^= h >> 16;
+          return h % num_partitions;
+        }
+      case RangePartition:
+        if (row_id >= partition.range)
+          return num_partitions - 1;
+        return static_cast<int64_t>(row_id) * num_partitions
+          / partition.range;
+      case CustomPartition:
+        {
+          int32_t partition_num = partition.func(table_id, row_id,
+            num_partitions);
+          DCHECK(partition_num >= 0 && partition_num < num_partitions);
+          return partition_num;
+        }
+      default:
+        LOG(FATAL) << "Unknown row partition type " << partition.type;
+    }
+    return 0;
+  }
+
   static int32_t num_servers_;
   static int32_t num_local_server_threads_;
   static int32_t num_app_threads_;
@@ -258,6 +402,19 @@ private:
   static ConsistencyModel consistency_model_;
   static int32_t local_id_min_;
   static bool aggressive_cpu_;
+
+  static bool row_migration_;
+  static int32_t row_migration_interval_;
+  static double row_migration_imbalance_;
+  static int32_t num_server_apply_threads_;
+  static size_t oplog_bytes_per_clock_;
+  static size_t oplog_flush_bytes_;
+
+  // Indexed by table id.
+  static std::vector<RowPartition> row_partitions_;
+
+  // Indexed by table id.
+  static std::vector<TableMsgFormat> table_msg_formats_;
 };
 
 }   // namespace petuum
@@ -6,6 +6,9 @@
 namespace petuum {
 class MemTransfer {
 public:
+  // Messages to remote receivers of at least kMinZeroCopySize bytes are
+  // handed to ZMQ without copying and freed by it once sent, so msg gives up
+  // its memory as it does for local receivers.
   static bool TransferMem(CommBus *comm_bus, int32_t recv_id, MsgBase *msg) {
     if (comm_bus->IsLocalEntity(recv_id)) {
       MemTransferMsg mem_transfer_msg;
@@ -14,6 +17,14 @@ public:
         mem_transfer_msg.get_mem(), mem_transfer_msg.get_size());
       CHECK_EQ(sent_size, mem_transfer_msg.get_size());
       return true;
+    } else if (msg->get_size() >= kMinZeroCopySize
+               && !msg->get_use_stack_buff()) {
+      size_t msg_size = msg->get_size();
+      zmq::message_t zmq_msg(msg->ReleaseMem(), msg_size,
+                             &FreeTransferredMem, NULL);
+      size_t sent_size = comm_bus->SendInterProc(recv_id, zmq_msg);
+      CHECK_EQ(sent_size, msg_size);
+      return false;
     } else {
       size_t sent_size = comm_bus->SendInterProc(recv_id, msg->get_mem(),
         msg->get_size());
@@ -27,6 +38,13 @@ public:
   }
 
 private:
+  // Below it, allocating ZMQ's reference count costs more than the copy.
+  static const size_t kMinZeroCopySize = 4096;
+
+  static void FreeTransferredMem(void *mem, void *hint) {
+    DestroyTransferredMem(mem);
+  }
+
   // Use msg's content to construct a MemTransferMsg to transfer memory
   // ownership between threads. That means if msg's mem should not be destroyed
   // by the sender. Therefore, InitMemTransferMsg lets msgg release its control
@@ -0,0 +1,144 @@
+#include "petuum_ps/thread/msg_codec.hpp"
+#include <string.h>
+
+namespace petuum {
+
+std::atomic<int64_t> MsgCompressor::oplog_bytes_saved_(0);
+std::atomic<int64_t> MsgCompressor::push_row_bytes_saved_(0);
+
+size_t MsgCompressor::GetMaxEncodedRowOpLogSize(int32_t num_updates,
+  size_t updates_size) {
+  return kMaxVarintSize*(2 + num_updates) + GetMaxZeroRunSize(updates_size);
+}
+
+size_t MsgCompressor::EncodeRowOpLog(int32_t prev_row_id, int32_t row_id,
+  const int32_t *column_ids, int32_t num_updates, const void *updates,
+  size_t updates_size, void *mem) {
+  uint8_t *mem_begin = reinterpret_cast<uint8_t*>(mem);
+  uint8_t *ptr = EncodeVarint(ZigZagDelta(prev_row_id, row_id), mem_begin);
+  ptr = EncodeVarint(num_updates, ptr);
+  int32_t prev_column_id = 0;
+  for (int32_t i = 0; i < num_updates; ++i) {
+    ptr = EncodeVarint(ZigZagDelta(prev_column_id, column_ids[i]), ptr);
+    prev_column_id = column_ids[i];
+  }
+  ptr = EncodeZeroRuns(reinterpret_cast<const uint8_t*>(updates),
+    updates_size, ptr);
+  return ptr - mem_begin;
+}
+
+const void *MsgCompressor::DecodeRowOpLogHeader(const void *mem,
+  int32_t prev_row_id, int32_t *row_id, int32_t *num_updates) {
+  const uint8_t *ptr = reinterpret_cast<const uint8_t*>(mem);
+  uint32_t value;
+  ptr = DecodeVarint(ptr, &value);
+  *row_id = UnZigZagDelta(prev_row_id, value);
+  ptr = DecodeVarint(ptr, &value);
+  *num_updates = value;
+  return ptr;
+}
+
+const void *MsgCompressor::DecodeRowOpLogUpdates(const void *mem,
+  int32_t num_updates, size_t updates_size, int32_t *column_ids,
+  void *updates) {
+  const uint8_t *ptr = reinterpret_cast<const uint8_t*>(mem);
+  int32_t prev_column_id = 0;
+  for (int32_t i = 0; i < num_updates; ++i) {
+    uint32_t value;
+    ptr = DecodeVarint(ptr, &value);
+    column_ids[i] = UnZigZagDelta(prev_column_id, value);
+    prev_column_id = column_ids[i];
+  }
+  return DecodeZeroRuns(ptr, updates_size,
+    reinterpret_cast<uint8_t*>(updates));
+}
+
+bool MsgCompressor::IsZeroUpdate(const void *update, size_t update_size) {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t*>(update);
+  for (size_t i = 0; i < update_size; ++i) {
+    if (bytes[i] != 0)
+      return false;
+  }
+  return true;
+}
+
+size_t MsgCompressor::GetMaxEncodedRowSize(size_t row_size) {
+  return kMaxVarintSize + GetMaxZeroRunSize(row_size);
+}
+
+size_t MsgCompressor::EncodeRow(const void *row_data, size_t row_size,
+  void *mem) {
+  uint8_t *mem_begin = reinterpret_cast<uint8_t*>(mem);
+  uint8_t *ptr = EncodeVarint(row_size, mem_begin);
+  ptr = EncodeZeroRuns(reinterpret_cast<const uint8_t*>(row_data), row_size,
+    ptr);
+  return ptr - mem_begin;
+}
+
+size_t MsgCompressor::GetDecodedRowSize(const void *mem) {
+  uint32_t row_size;
+  DecodeVarint(reinterpret_cast<const uint8_t*>(mem), &row_size);
+  return row_size;
+}
+
+void MsgCompressor::DecodeRow(const void *mem, void *row_data) {
+  uint32_t row_size;
+  const uint8_t *ptr = DecodeVarint(reinterpret_cast<const uint8_t*>(mem),
+    &row_size);
+  DecodeZeroRuns(ptr, row_size, reinterpret_cast<uint8_t*>(row_data));
+}
+
+// Every run but the first and the last has at least kMinZeroRun zero bytes
+// and one literal byte, and a varint takes one byte plus at most one byte
+// per 128 of the value it holds.
+size_t MsgCompressor::GetMaxZeroRunSize(size_t num_bytes) {
+  return num_bytes + 2*(num_bytes/(kMinZeroRun + 1) + 2) + num_bytes/128;
+}
+
+uint8_t *MsgCompressor::EncodeZeroRuns(const uint8_t *data,
+  size_t num_bytes, uint8_t *mem) {
+  size_t pos = 0;
+  while (pos < num_bytes) {
+    size_t zero_begin = pos;
+    while (pos < num_bytes && data[pos] == 0)
+      ++pos;
+    size_t literal_begin = pos;
+    // Extend the literals until a long enough zero run or a zero run that
+    // ends the data.
+    while (pos < num_bytes) {
+      if (data[pos] != 0) {
+        ++pos;
+        continue;
+      }
+      size_t zero_end = pos;
+      while (zero_end < num_bytes && data[zero_end] == 0)
+        ++zero_end;
+      if (zero_end - pos >= kMinZeroRun || zero_end == num_bytes)
+        break;
+      pos = zero_end;
+    }
+    mem = EncodeVarint(literal_begin - zero_begin, mem);
+    mem = EncodeVarint(pos - literal_begin, mem);
+    memcpy(mem, data + literal_begin, pos - literal_begin);
+    mem += pos - literal_begin;
+  }
+  return mem;
+}
+
+const uint8_t *MsgCompressor::DecodeZeroRuns(const uint8_t *mem,
+  size_t num_bytes, uint8_t *data) {
+  size_t pos = 0;
+  while (pos < num_bytes) {
+    uint32_t num_zeros, num_literals;
+    mem = DecodeVarint(mem, &num_zeros);
+    mem = DecodeVarint(mem, &num_literals);
+    memset(data + pos, 0, num_zeros);
+    pos += num_zeros;
+    memcpy(data + pos, mem, num_literals);
+    pos += num_literals;
+    mem += num_literals;
+  }
+  return mem;
+}
+
+}  // namespace petuum
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+namespace petuum {
+
+// Encoding of the oplogs and pushed rows of tables with CompactCodec.
+//
+// A row oplog (in place of the raw layout of
+// BgOpLogPartition::SerializeByServer()) is:
+// 1. varint : zigzag(row id - row id of the previous row of the table in the
+//    same message), the first relative to 0
+// 2. varint : number of updates, not counting updates of all zero bytes,
+//    which are dropped
+// 3. varints : zigzag(column id - previous column id), the first relative
+//    to 0
+// 4. the update array, zero-run encoded; the array holds the updates (or,
+//    for quantized tables, the quantized updates, see UpdateQuantizer)
+//
+// A pushed row is a varint holding the size of the serialized row followed
+// by the zero-run encoded serialized row.
+//
+// Zero-run encoding is a sequence of runs, each being a varint number of
+// zero bytes, a varint number of literal bytes and the literal bytes. Runs
+// of fewer than kMinZeroRun zero bytes are kept in the literals. The decoded
+// size is not part of it.
+class MsgCompressor {
+public:
+  // updates_size is the number of bytes of the update array.
+  static size_t GetMaxEncodedRowOpLogSize(int32_t num_updates,
+    size_t updates_size);
+
+  // Returns the number of bytes written to mem. The caller drops zero
+  // updates (see IsZeroUpdate()).
+  static size_t EncodeRowOpLog(int32_t prev_row_id, int32_t row_id,
+    const int32_t *column_ids, int32_t num_updates, const void *updates,
+    size_t updates_size, void *mem);
+
+  // Reads the row id and the number of updates of the row oplog at mem and
+  // returns a pointer to the rest of it, to be read by
+  // DecodeRowOpLogUpdates().
+  static const void *DecodeRowOpLogHeader(const void *mem,
+    int32_t prev_row_id, int32_t *row_id, int32_t *num_updates);
+
+  // Returns a pointer to the byte following the row oplog.
+  static const void *DecodeRowOpLogUpdates(const void *mem,
+    int32_t num_updates, size_t updates_size, int32_t *column_ids,
+    void *updates);
+
+  static bool IsZeroUpdate(const void *update, size_t update_size);
+
+  static size_t GetMaxEncodedRowSize(size_t row_size);
+
+  // Returns the number of bytes written to mem.
+  static size_t EncodeRow(const void *row_data, size_t row_size, void *mem);
+
+  static size_t GetDecodedRowSize(const void *mem);
+
+  // row_data must hold GetDecodedRowSize(mem) bytes.
+  static void DecodeRow(const void *mem, void *row_data);
+
+  // Bytes saved by encoding, summed over all threads of the process.
+  static void AddOpLogBytes(size_t raw_size, size_t encoded_size) {
+    oplog_bytes_saved_.fetch_add(static_cast<int64_t>(raw_size)
+      - static_cast<int64_t>(encoded_size), std::memory_order_relaxed);
+  }
+
+  static void AddPushRowBytes(size_t raw_size, size_t encoded_size) {
+    push_row_bytes_saved_.fetch_add(static_cast<int64_t>(raw_size)
+      - static_cast<int64_t>(encoded_size), std::memory_order_relaxed);
+  }
+
+  static int64_t get_oplog_bytes_saved() {
+    return oplog_bytes_saved_.load(std::memory_order_relaxed);
+  }
+
+  static int64_t get_push_row_bytes_saved() {
+    return push_row_bytes_saved_.load(std::memory_order_relaxed);
+  }
+
+private:
+  static const size_t kMinZeroRun = 4;
+  // Upper bound of the number of bytes of a varint encoded uint32_t.
+  static const size_t kMaxVarintSize = 5;
+
+  static size_t GetMaxZeroRunSize(size_t num_bytes);
+  static uint8_t *EncodeZeroRuns(const uint8_t *data, size_t num_bytes,
+    uint8_t *mem);
+  static const uint8_t *DecodeZeroRuns(const uint8_t *mem, size_t num_bytes,
+    uint8_t *data);
+
+  static uint8_t *EncodeVarint(uint32_t value, uint8_t *mem) {
+    while (value >= 0x80) {
+      *mem++ = static_cast<uint8_t>(value) | 0x80;
+      value >>= 7;
+    }
+    *mem++ = static_cast<uint8_t>(value);
+    return mem;
+  }
+
+  static const uint8_t *DecodeVarint(const uint8_t *mem, uint32_t *value) {
+    uint32_t result = 0;
+    int shift = 0;
+    while (*mem & 0x80) {
+      result |= static_cast<uint32_t>(*mem++ & 0x7f) << shift;
+      shift += 7;
+    }
+    result |= static_cast<uint32_t>(*mem++) << shift;
+    *value = result;
+    return mem;
+  }
+
+  // Deltas are taken modulo 2^32 so they never overflow.
+  static uint32_t ZigZagDelta(int32_t prev, int32_t curr) {
+    int32_t delta = static_cast<int32_t>(static_cast<uint32_t>(curr)
+      - static_cast<uint32_t>(prev));
+    return (static_cast<uint32_t>(delta) << 1)
+      ^ static_cast<uint32_t>(delta >> 31);
+  }
+
+  static int32_t UnZigZagDelta(int32_t prev, uint32_t zigzag) {
+    uint32_t delta = (zigzag >> 1) ^ (0u - (zigzag & 1));
+    return static_cast<int32_t>(static_cast<uint32_t>(prev) + delta);
+  }
+
+  static std::atomic<int64_t> oplog_bytes_saved_;
+  static std::atomic<int64_t> push_row_bytes_saved_;
+};
+
+}  // namespace petuum
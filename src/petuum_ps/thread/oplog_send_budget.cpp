@@ -0,0 +1,72 @@
+#include "petuum_ps/thread/oplog_send_budget.hpp"
+#include <algorithm>
+
+namespace petuum {
+
+std::atomic<int64_t> OpLogSendBudget::bytes_deferred_(0);
+std::atomic<int64_t> OpLogSendBudget::rows_deferred_(0);
+std::atomic<int64_t> OpLogSendBudget::rows_overdue_(0);
+
+void OpLogSendBudget::GetDeferredRows(int32_t table_id,
+  std::vector<int32_t> *row_ids) const {
+  row_ids->clear();
+  auto table_iter = deferred_since_.find(table_id);
+  if (table_iter == deferred_since_.end())
+    return;
+  for (auto row_iter = table_iter->second.cbegin();
+       row_iter != table_iter->second.cend(); ++row_iter) {
+    row_ids->push_back(row_iter->first);
+  }
+}
+
+void OpLogSendBudget::Select(const std::vector<RowOpLogInfo> &row_oplogs,
+  std::vector<bool> *send) {
+  send->assign(row_oplogs.size(), false);
+
+  // Overdue rows go first, then rows by decreasing magnitude.
+  std::vector<int32_t> deferred_since(row_oplogs.size());
+  std::vector<bool> overdue(row_oplogs.size());
+  std::vector<size_t> order(row_oplogs.size());
+  for (size_t i = 0; i < row_oplogs.size(); ++i) {
+    const RowOpLogInfo &info = row_oplogs[i];
+    deferred_since[i] = clock_;
+    auto table_iter = deferred_since_.find(info.table_id);
+    if (table_iter != deferred_since_.end()) {
+      auto row_iter = table_iter->second.find(info.row_id);
+      if (row_iter != table_iter->second.end())
+        deferred_since[i] = row_iter->second;
+    }
+    overdue[i] = (clock_ - deferred_since[i] >= info.max_deferred_clocks);
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(),
+    [&row_oplogs, &overdue](size_t a, size_t b) {
+      if (overdue[a] != overdue[b])
+        return static_cast<bool>(overdue[a]);
+      return row_oplogs[a].magnitude > row_oplogs[b].magnitude;
+    });
+
+  // Rows deferred at an earlier clock but not passed in are forgotten.
+  boost::unordered_map<int32_t, boost::unordered_map<int32_t, int32_t> >
+  next_deferred_since;
+  size_t bytes_sent = 0;
+  for (auto order_iter = order.cbegin(); order_iter != order.cend();
+       ++order_iter) {
+    size_t i = *order_iter;
+    const RowOpLogInfo &info = row_oplogs[i];
+    if (overdue[i] || bytes_sent + info.size <= bytes_per_clock_) {
+      (*send)[i] = true;
+      bytes_sent += info.size;
+      if (bytes_sent > bytes_per_clock_)
+        rows_overdue_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      next_deferred_since[info.table_id][info.row_id] = deferred_since[i];
+      bytes_deferred_.fetch_add(info.size, std::memory_order_relaxed);
+      rows_deferred_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  deferred_since_.swap(next_deferred_since);
+  ++clock_;
+}
+
+}  // namespace petuum
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+#include <boost/unordered_map.hpp>
+
+namespace petuum {
+
+// Chooses which pending row oplogs a bg thread sends at a clock so that it
+// sends at most bytes_per_clock bytes. Rows are sent in decreasing order of
+// update magnitude; the others are deferred to later clocks, until they
+// have been deferred for their max_deferred_clocks, after which they are
+// sent regardless of the budget. Deferred rows miss the clocks sent
+// meanwhile, so tables whose rows may be deferred are read with a staleness
+// reduced by the same number of clocks, see GetReadStaleness().
+class OpLogSendBudget {
+public:
+  struct RowOpLogInfo {
+    int32_t table_id;
+    int32_t row_id;
+    // Upper bound of the serialized size.
+    size_t size;
+    // AbstractRow::GetUpdatesMagnitude() of the row oplog.
+    double magnitude;
+    int32_t max_deferred_clocks;
+  };
+
+  OpLogSendBudget():
+      bytes_per_clock_(0),
+      clock_(0) { }
+
+  // 0 sends every row oplog at every clock.
+  void Init(size_t bytes_per_clock) {
+    bytes_per_clock_ = bytes_per_clock;
+  }
+
+  bool is_limited() const {
+    return bytes_per_clock_ > 0;
+  }
+
+  // Clocks a row of a table with the given staleness may be deferred for.
+  static int32_t GetMaxDeferredClocks(int32_t staleness) {
+    return staleness / 2;
+  }
+
+  // Staleness a table is read with when its rows may be deferred. A read at
+  // clock c waits for clock c - GetReadStaleness(staleness), which is only
+  // sent after every row oplog of clocks up to c - staleness - 1, so the
+  // table's staleness bound still holds.
+  static int32_t GetReadStaleness(int32_t staleness) {
+    return staleness - GetMaxDeferredClocks(staleness);
+  }
+
+  // Rows of table_id deferred by the last Select(), to be considered again
+  // at the next one even if they have no new updates.
+  void GetDeferredRows(int32_t table_id, std::vector<int32_t> *row_ids) const;
+
+  // Called once per clock with every pending row oplog. (*send)[i] is set to
+  // whether row_oplogs[i] is sent at this clock.
+  void Select(const std::vector<RowOpLogInfo> &row_oplogs,
+    std::vector<bool> *send);
+
+  // Summed over all bg threads of the process.
+  static int64_t get_bytes_deferred() {
+    return bytes_deferred_.load(std::memory_order_relaxed);
+  }
+
+  static int64_t get_rows_deferred() {
+    return rows_deferred_.load(std::memory_order_relaxed);
+  }
+
+  // Number of rows sent past the budget because they were overdue.
+  static int64_t get_rows_overdue() {
+    return rows_overdue_.load(std::memory_order_relaxed);
+  }
+
+private:
+  size_t bytes_per_clock_;
+  // Number of Select() calls so far.
+  int32_t clock_;
+  // table id -> row id -> clock the row was first deferred at
+  boost::unordered_map<int32_t, boost::unordered_map<int32_t, int32_t> >
+  deferred_since_;
+
+  static std::atomic<int64_t> bytes_deferred_;
+  static std::atomic<int64_t> rows_deferred_;
+  static std::atomic<int64_t> rows_overdue_;
+};
+
+}  // namespace petuum
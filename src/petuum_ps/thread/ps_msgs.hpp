@@ -32,6 +32,13 @@ enum MsgType {
   kClientShutDown = 16,
   kServerShutDownAck = 17,
   kServerPushRow = 18,
+  kBatchRowRequest = 19,
+  kServerBatchRowRequestReply = 20,
+  kServerLoadReport = 21,
+  kRowMigrate = 22,
+  kMigratedRows = 23,
+  kRowMigrateDone = 24,
+  kBgAppRequest = 25,
   kMemTransfer = 50
 };
 
@@ -250,7 +257,7 @@ public:
   size_t get_size() {
     return NumberedMsg::get_size() + sizeof(int32_t) + sizeof(int32_t)
       + sizeof(int32_t) + sizeof(int32_t) + sizeof(size_t) + sizeof(int32_t)
-      + sizeof(int32_t) + sizeof(int32_t);
+      + sizeof(int32_t) + sizeof(int32_t) + sizeof(double) + sizeof(int32_t);
   }
 
   int32_t &get_table_id() {
@@ -293,6 +300,20 @@ public:
       + sizeof(int32_t)));
   }
 
+  double &get_value_bound() {
+    return *(reinterpret_cast<double*>(mem_.get_mem()
+      + NumberedMsg::get_size() + sizeof(int32_t) + sizeof(int32_t)
+      + sizeof(int32_t) + sizeof(int32_t) + sizeof(int32_t)
+      + sizeof(int32_t) + sizeof(int32_t)));
+  }
+
+  int32_t &get_oplog_dense_index_rows() {
+    return *(reinterpret_cast<int32_t*>(mem_.get_mem()
+      + NumberedMsg::get_size() + sizeof(int32_t) + sizeof(int32_t)
+      + sizeof(int32_t) + sizeof(int32_t) + sizeof(int32_t)
+      + sizeof(int32_t) + sizeof(int32_t) + sizeof(double)));
+  }
+
 protected:
   void InitMsg() {
     NumberedMsg::InitMsg();
@@ -320,7 +341,8 @@ public:
 
   size_t get_size() {
     return NumberedMsg::get_size() + sizeof(int32_t) + sizeof(int32_t)
-      + sizeof(int32_t) + sizeof(int32_t) + sizeof(int32_t) + sizeof(int32_t);
+      + sizeof(int32_t) + sizeof(int32_t) + sizeof(int32_t) + sizeof(int32_t)
+      + sizeof(double);
   }
 
   int32_t &get_table_id() {
@@ -343,6 +365,11 @@ public:
       + sizeof(int32_t) + sizeof(int32_t) + sizeof(int32_t)));
   }
 
+  double &get_value_bound() {
+    return *(reinterpret_cast<double*>(mem_.get_mem() + NumberedMsg::get_size()
+      + sizeof(int32_t) + sizeof(int32_t) + sizeof(int32_t) + sizeof(int32_t)));
+  }
+
 protected:
   void InitMsg() {
     NumberedMsg::InitMsg();
@@ -658,6 +685,32 @@ protected:
   }
 };
 
+// Wakes a bg thread up to pop the requests in its AppRequestRing.
+struct BgAppRequestMsg : public NumberedMsg {
+public:
+  BgAppRequestMsg() {
+    if (get_size() > PETUUM_MSG_STACK_BUFF_SIZE) {
+       own_mem_ = true;
+       use_stack_buff_ = false;
+       mem_.Alloc(get_size());
+    } else {
+      own_mem_ = false;
+      use_stack_buff_ = true;
+      mem_.Reset(stack_buff_);
+    }
+    InitMsg();
+  }
+
+  explicit BgAppRequestMsg(void *msg):
+    NumberedMsg(msg) {}
+
+protected:
+  void InitMsg() {
+    NumberedMsg::InitMsg();
+    get_msg_type() = kBgAppRequest;
+  }
+};
+
 // This is a special type of message which transfers the ownership of a
 // piece of memory from sender to receiver. That means the receiver knows
 // how to interpret the memory and more importantly, knows how and will
@@ -789,6 +842,110 @@ protected:
   }
 };
 
+// Requests a set of rows of the same table at the same clock. Sent from app
+// thread to bg thread (rows partitioned to that bg thread) and from bg thread
+// to server (rows hosted on that server).
+struct BatchRowRequestMsg : public ArbitrarySizedMsg {
+public:
+  explicit BatchRowRequestMsg(int32_t num_rows) {
+    own_mem_ = true;
+    mem_.Alloc(get_header_size() + num_rows*sizeof(int32_t));
+    InitMsg(num_rows*sizeof(int32_t));
+    get_num_rows() = num_rows;
+  }
+
+  explicit BatchRowRequestMsg(void *msg):
+    ArbitrarySizedMsg(msg) {}
+
+  size_t get_header_size() {
+    return ArbitrarySizedMsg::get_header_size() + sizeof(int32_t)
+      + sizeof(int32_t) + sizeof(int32_t);
+  }
+
+  int32_t &get_table_id() {
+    return *(reinterpret_cast<int32_t*>(mem_.get_mem()
+      + ArbitrarySizedMsg::get_header_size()));
+  }
+
+  int32_t &get_clock() {
+    return *(reinterpret_cast<int32_t*>(mem_.get_mem()
+      + ArbitrarySizedMsg::get_header_size() + sizeof(int32_t)));
+  }
+
+  int32_t &get_num_rows() {
+    return *(reinterpret_cast<int32_t*>(mem_.get_mem()
+      + ArbitrarySizedMsg::get_header_size() + sizeof(int32_t)
+      + sizeof(int32_t)));
+  }
+
+  int32_t *get_row_ids() {
+    return reinterpret_cast<int32_t*>(mem_.get_mem() + get_header_size());
+  }
+
+  size_t get_size() {
+    return get_header_size() + get_avai_size();
+  }
+
+protected:
+  virtual void InitMsg(int32_t avai_size) {
+    ArbitrarySizedMsg::InitMsg(avai_size);
+    get_msg_type() = kBatchRowRequest;
+  }
+};
+
+// Replies a set of rows to one bg thread. Memory layout of the data:
+// for each row
+// 1. int32_t : table id
+// 2. int32_t : row id
+// 3. size_t : serialized row size
+// 4. serialized row
+struct ServerBatchRowRequestReplyMsg : public ArbitrarySizedMsg {
+public:
+  explicit ServerBatchRowRequestReplyMsg(int32_t avai_size) {
+    own_mem_ = true;
+    mem_.Alloc(get_header_size() + avai_size);
+    InitMsg(avai_size);
+  }
+
+  explicit ServerBatchRowRequestReplyMsg(void *msg):
+    ArbitrarySizedMsg(msg) {}
+
+  size_t get_header_size() {
+    return ArbitrarySizedMsg::get_header_size() + sizeof(int32_t)
+      + sizeof(uint32_t) + sizeof(int32_t);
+  }
+
+  int32_t &get_clock() {
+    return *(reinterpret_cast<int32_t*>(mem_.get_mem()
+      + ArbitrarySizedMsg::get_header_size()));
+  }
+
+  uint32_t &get_version() {
+    return *(reinterpret_cast<uint32_t*>(mem_.get_mem()
+      + ArbitrarySizedMsg::get_header_size() + sizeof(int32_t)));
+  }
+
+  int32_t &get_num_rows() {
+    return *(reinterpret_cast<int32_t*>(mem_.get_mem()
+      + ArbitrarySizedMsg::get_header_size() + sizeof(int32_t)
+      + sizeof(uint32_t)));
+  }
+
+  void *get_data() {
+    return mem_.get_mem() + get_header_size();
+  }
+
+  size_t get_size() {
+    return get_header_size() + get_avai_size();
+  }
+
+protected:
+  virtual void InitMsg(int32_t avai_size) {
+    ArbitrarySizedMsg::InitMsg(avai_size);
+    get_msg_type() = kServerBatchRowRequestReply;
+  }
+};
+
 struct ClientSendOpLogMsg : public ArbitrarySizedMsg {
 public:
   explicit ClientSendOpLogMsg(int32_t avai_size) {
@@ -885,4 +1042,226 @@ protected:
   }
 };
 
+// Sent from server to name node every few server clocks when row migration
+// is enabled. Reports the load (number of oplog applications and row
+// requests) of the server since the last report and its hottest rows.
+// Memory layout of the data, for each row:
+// 1. int32_t : table id
+// 2. int32_t : row id
+// 3. int32_t : load
+struct ServerLoadReportMsg : public ArbitrarySizedMsg {
+public:
+  explicit ServerLoadReportMsg(int32_t num_rows) {
+    own_mem_ = true;
+    mem_.Alloc(get_header_size() + num_rows*3*sizeof(int32_t));
+    InitMsg(num_rows*3*sizeof(int32_t));
+    get_num_rows() = num_rows;
+  }
+
+  explicit ServerLoadReportMsg(void *msg):
+    ArbitrarySizedMsg(msg) {}
+
+  size_t get_header_size() {
+    return ArbitrarySizedMsg::get_header_size() + sizeof(int64_t)
+      + sizeof(int32_t);
+  }
+
+  int64_t &get_total_load() {
+    return *(reinterpret_cast<int64_t*>(mem_.get_mem()
+      + ArbitrarySizedMsg::get_header_size()));
+  }
+
+  int32_t &get_num_rows() {
+    return *(reinterpret_cast<int32_t*>(mem_.get_mem()
+      + ArbitrarySizedMsg::get_header_size() + sizeof(int64_t)));
+  }
+
+  int32_t *get_data() {
+    return reinterpret_cast<int32_t*>(mem_.get_mem() + get_header_size());
+  }
+
+  size_t get_size() {
+    return get_header_size() + get_avai_size();
+  }
+
+protected:
+  virtual void InitMsg(int32_t avai_size) {
+    ArbitrarySizedMsg::InitMsg(avai_size);
+    get_msg_type() = kServerLoadReport;
+  }
+};
+
+// Moves a set of rows from server src_server_id to dst_server_id. Sent from
+// name node to all bg threads; each bg thread echoes the message to both
+// servers as acknowledgement once it routes the rows to dst_server_id.
+// Memory layout of the data, for each row:
+// 1. int32_t : table id
+// 2. int32_t : row id
+struct RowMigrateMsg : public ArbitrarySizedMsg {
+public:
+  explicit RowMigrateMsg(int32_t num_rows) {
+    own_mem_ = true;
+    mem_.Alloc(get_header_size() + num_rows*2*sizeof(int32_t));
+    InitMsg(num_rows*2*sizeof(int32_t));
+    get_num_rows() = num_rows;
+  }
+
+  explicit RowMigrateMsg(void *msg):
+    ArbitrarySizedMsg(msg) {}
+
+  size_t get_header_size() {
+    return ArbitrarySizedMsg::get_header_size() + sizeof(int32_t)
+      + sizeof(int32_t) + sizeof(int32_t) + sizeof(int32_t);
+  }
+
+  // Version of the routing after this migration.
+  int32_t &get_version() {
+    return *(reinterpret_cast<int32_t*>(mem_.get_mem()
+      + ArbitrarySizedMsg::get_header_size()));
+  }
+
+  int32_t &get_src_server_id() {
+    return *(reinterpret_cast<int32_t*>(mem_.get_mem()
+      + ArbitrarySizedMsg::get_header_size() + sizeof(int32_t)));
+  }
+
+  int32_t &get_dst_server_id() {
+    return *(reinterpret_cast<int32_t*>(mem_.get_mem()
+      + ArbitrarySizedMsg::get_header_size() + sizeof(int32_t)
+      + sizeof(int32_t)));
+  }
+
+  int32_t &get_num_rows() {
+    return *(reinterpret_cast<int32_t*>(mem_.get_mem()
+      + ArbitrarySizedMsg::get_header_size() + sizeof(int32_t)
+      + sizeof(int32_t) + sizeof(int32_t)));
+  }
+
+  int32_t *get_data() {
+    return reinterpret_cast<int32_t*>(mem_.get_mem() + get_header_size());
+  }
+
+  size_t get_size() {
+    return get_header_size() + get_avai_size();
+  }
+
+protected:
+  virtual void InitMsg(int32_t avai_size) {
+    ArbitrarySizedMsg::InitMsg(avai_size);
+    get_msg_type() = kRowMigrate;
+  }
+};
+
+// Carries migrated rows from the source server to the destination server,
+// relayed by the name node. Memory layout of the data:
+// for each bg thread
+// 1. int32_t : bg id
+// 2. int32_t : latest oplog version the source server received from it
+// followed by, for each row
+// 1. int32_t : table id
+// 2. int32_t : row id
+// 3. int32_t : number of subscribed clients
+// 4. an array of int32_t: subscribed client ids
+// 5. size_t : serialized row size
+// 6. serialized row
+// followed by, for each row request held by the source server
+// 1. int32_t : bg id
+// 2. int32_t : table id
+// 3. int32_t : row id
+// 4. int32_t : clock
+struct MigratedRowsMsg : public ArbitrarySizedMsg {
+public:
+  explicit MigratedRowsMsg(int32_t avai_size) {
+    own_mem_ = true;
+    mem_.Alloc(get_header_size() + avai_size);
+    InitMsg(avai_size);
+  }
+
+  explicit MigratedRowsMsg(void *msg):
+    ArbitrarySizedMsg(msg) {}
+
+  size_t get_header_size() {
+    return ArbitrarySizedMsg::get_header_size() + sizeof(int32_t)
+      + sizeof(int32_t) + sizeof(int32_t) + sizeof(int32_t) + sizeof(int32_t);
+  }
+
+  int32_t &get_version() {
+    return *(reinterpret_cast<int32_t*>(mem_.get_mem()
+      + ArbitrarySizedMsg::get_header_size()));
+  }
+
+  int32_t &get_dst_server_id() {
+    return *(reinterpret_cast<int32_t*>(mem_.get_mem()
+      + ArbitrarySizedMsg::get_header_size() + sizeof(int32_t)));
+  }
+
+  int32_t &get_num_rows() {
+    return *(reinterpret_cast<int32_t*>(mem_.get_mem()
+      + ArbitrarySizedMsg::get_header_size() + sizeof(int32_t)
+      + sizeof(int32_t)));
+  }
+
+  int32_t &get_num_requests() {
+    return *(reinterpret_cast<int32_t*>(mem_.get_mem()
+      + ArbitrarySizedMsg::get_header_size() + sizeof(int32_t)
+      + sizeof(int32_t) + sizeof(int32_t)));
+  }
+
+  int32_t &get_num_bg_versions() {
+    return *(reinterpret_cast<int32_t*>(mem_.get_mem()
+      + ArbitrarySizedMsg::get_header_size() + sizeof(int32_t)
+      + sizeof(int32_t) + sizeof(int32_t) + sizeof(int32_t)));
+  }
+
+  void *get_data() {
+    return mem_.get_mem() + get_header_size();
+  }
+
+  size_t get_size() {
+    return get_header_size() + get_avai_size();
+  }
+
+protected:
+  virtual void InitMsg(int32_t avai_size) {
+    ArbitrarySizedMsg::InitMsg(avai_size);
+    get_msg_type() = kMigratedRows;
+  }
+};
+
+// Sent from the destination server to name node once it installed the rows
+// of a migration.
+struct RowMigrateDoneMsg : public NumberedMsg {
+public:
+  RowMigrateDoneMsg() {
+    if (get_size() > PETUUM_MSG_STACK_BUFF_SIZE) {
+      own_mem_ = true;
+      use_stack_buff_ = false;
+      mem_.Alloc(get_size());
+    } else {
+      own_mem_ = false;
+      use_stack_buff_ = true;
+      mem_.Reset(stack_buff_);
+    }
+    InitMsg();
+  }
+
+  explicit RowMigrateDoneMsg(void *msg):
+    NumberedMsg(msg) {}
+
+  size_t get_size() {
+    return NumberedMsg::get_size() + sizeof(int32_t);
+  }
+
+  int32_t &get_version() {
+    return *(reinterpret_cast<int32_t*>(mem_.get_mem()
+      + NumberedMsg::get_size()));
+  }
+
+protected:
+  void InitMsg() {
+    NumberedMsg::InitMsg();
+    get_msg_type() = kRowMigrateDone;
+  }
+};
+
 }  // namespace petuum
@@ -6,6 +6,17 @@
 
 namespace petuum {
 
+void RowRequestOpLogMgr::ApplyRowOpLog(RowOpLog *row_oplog,
+                                       AbstractRow *row_data) {
+  int32_t column_id;
+  void *update = row_oplog->BeginIterate(&column_id);
+  while (update != 0) {
+    VLOG(0) << "ApplyOpLogs update = " << update;
+    row_data->ApplyIncUnsafe(column_id, update);
+    update = row_oplog->Next(&column_id);
+  }
+}
+
 bool SSPRowRequestOpLogMgr::AddRowRequest(RowRequestInfo &request,
   int32_t table_id, int32_t row_id) {
   uint32_t version = request.version;
@@ -65,8 +76,8 @@ int32_t SSPRowRequestOpLogMgr::InformReply(int32_t table_id, int32_t row_id,
     if (request.clock <= clock) {
       // remove the request
       app_thread_ids->push_back(request.app_thread_id);
-      request_list.pop_front();
       uint32_t req_version = request.version;
+      request_list.pop_front();
       // decrement the version count
       --version_request_cnt_map_[req_version];
       CHECK_GE(version_request_cnt_map_[req_version], 0);
@@ -103,23 +114,71 @@ int32_t SSPRowRequestOpLogMgr::InformReply(int32_t table_id, int32_t row_id,
 }
 
 bool SSPRowRequestOpLogMgr::AddOpLog(uint32_t version, BgOpLog *oplog) {
-  CHECK_EQ(version_oplog_map_.count(version), (size_t) 0)
+  CHECK_EQ(version_rows_.count(version), (size_t) 0)
      << "version number has wrapped"
      << " around, the system does not how to deal with it. "
      << "Maybe use a larger version number?";
   // There are pending requests, they are from some older version or the current
   // version, so I need to save the oplog for them.
-  if (version_request_cnt_map_.size() > 0) {
-    version_oplog_map_[version] = oplog;
-    return true;
+  if (version_request_cnt_map_.size() == 0)
+    return false;
+
+  std::vector<std::pair<int32_t, int32_t> > &rows = version_rows_[version];
+  for (auto table_iter = oplog->cbegin(); table_iter != oplog->cend();
+       table_iter++) {
+    int32_t table_id = table_iter->first;
+    released_row_oplogs_.clear();
+    table_iter->second->ReleaseOpLogs(&released_row_oplogs_);
+    for (auto oplog_iter = released_row_oplogs_.begin();
+         oplog_iter != released_row_oplogs_.end(); oplog_iter++) {
+      std::pair<int32_t, int32_t> row_key(table_id, oplog_iter->first);
+      row_oplogs_[row_key].push_back(
+          std::make_pair(version, oplog_iter->second));
+      rows.push_back(row_key);
+    }
   }
   return false;
 }
 
-BgOpLog *SSPRowRequestOpLogMgr::GetOpLog(uint32_t version) {
-  auto iter = version_oplog_map_.find(version);
-  CHECK(iter != version_oplog_map_.end());
-  return iter->second;
+void SSPRowRequestOpLogMgr::ApplyOpLogs(int32_t table_id, int32_t row_id,
+  uint32_t start_version, uint32_t end_version, AbstractRow *row_data) {
+  auto row_iter = row_oplogs_.find(std::make_pair(table_id, row_id));
+  if (row_iter == row_oplogs_.end())
+    return;
+
+  for (auto oplog_iter = row_iter->second.cbegin();
+       oplog_iter != row_iter->second.cend(); oplog_iter++) {
+    if (oplog_iter->first < start_version)
+      continue;
+    if (oplog_iter->first > end_version)
+      break;
+    ApplyRowOpLog(oplog_iter->second, row_data);
+  }
+}
+
+void SSPRowRequestOpLogMgr::RemoveVersionOpLogs(uint32_t version) {
+  auto version_iter = version_rows_.find(version);
+  if (version_iter == version_rows_.end())
+    return;
+
+  for (auto key_iter = version_iter->second.cbegin();
+       key_iter != version_iter->second.cend(); key_iter++) {
+    auto row_iter = row_oplogs_.find(*key_iter);
+    CHECK(row_iter != row_oplogs_.end());
+    std::list<std::pair<uint32_t, RowOpLog*> > &oplogs = row_iter->second;
+    // Versions are mostly removed oldest first.
+    for (auto oplog_iter = oplogs.begin(); oplog_iter != oplogs.end();
+         oplog_iter++) {
+      if (oplog_iter->first == version) {
+        delete oplog_iter->second;
+        oplogs.erase(oplog_iter);
+        break;
+      }
+    }
+    if (oplogs.empty())
+      row_oplogs_.erase(row_iter);
+  }
+  version_rows_.erase(version_iter);
 }
 
 void SSPRowRequestOpLogMgr::CleanVersionOpLogs(uint32_t req_version,
@@ -136,36 +195,17 @@ void SSPRowRequestOpLogMgr::CleanVersionOpLogs(uint32_t req_version,
   // First, make sure there's no request from a previous version.
   // We do that by checking if there's an OpLog of this version,
   // if there is one, it must be save for some older requests.
-  if (version_oplog_map_.count(req_version) > 0)
+  if (version_rows_.count(req_version) > 0)
     return;
 
   uint32_t version_to_remove = req_version;
   do {
     // No previous OpLog, can remove a later version of oplog.
-    delete version_oplog_map_[version_to_remove + 1];
-    version_oplog_map_.erase(version_to_remove + 1);
+    RemoveVersionOpLogs(version_to_remove + 1);
     ++version_to_remove;
     // Figure out how many later versions of oplogs can be removed.
   } while((version_request_cnt_map_.count(version_to_remove) == 0)
     && (version_to_remove != curr_version));
 }
 
-BgOpLog *SSPRowRequestOpLogMgr::OpLogIterInit(uint32_t start_version,
-  uint32_t end_version) {
-  oplog_iter_version_st_ = start_version;
-  oplog_iter_version_end_ = end_version;
-  oplog_iter_version_next_ = oplog_iter_version_st_ + 1;
-  return GetOpLog(start_version);
-}
-
-
-BgOpLog *SSPRowRequestOpLogMgr::OpLogIterNext(uint32_t *version) {
-  if (oplog_iter_version_next_ > oplog_iter_version_end_)
-    return NULL;
-  *version = oplog_iter_version_next_;
-  ++oplog_iter_version_next_;
-  return GetOpLog(*version);
-}
-
-
 }  // namespace petuum
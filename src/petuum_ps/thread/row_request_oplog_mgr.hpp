@@ -10,6 +10,8 @@
 #include <glog/logging.h>
 
 #include "petuum_ps/thread/bg_oplog.hpp"
+#include "petuum_ps/include/abstract_row.hpp"
+#include "petuum_ps/oplog/row_oplog.hpp"
 
 namespace petuum {
 
@@ -40,7 +42,9 @@ public:
 
 class RowRequestOpLogMgr : boost::noncopyable {
 public:
-  RowRequestOpLogMgr() { }
+  // OpLogs that are no longer needed are put into oplog_pool.
+  explicit RowRequestOpLogMgr(BgOpLogPool *oplog_pool):
+      oplog_pool_(oplog_pool) { }
 
   virtual ~RowRequestOpLogMgr() { }
 
@@ -56,17 +60,23 @@ public:
   virtual int32_t InformReply(int32_t table_id, int32_t row_id, int32_t clock,
     uint32_t curr_version, std::vector<int32_t> *app_thread_ids) = 0;
 
-  // Get OpLog of a particular version.
-  virtual BgOpLog *GetOpLog(uint32_t version) = 0;
-
   virtual void InformVersionInc() = 0;
   virtual void ServerAcknowledgeVersion(int32_t server_id,
                                         uint32_t version) = 0;
+  // Returns true if it takes ownership of oplog. Otherwise it may have taken
+  // the row oplogs out of oplog.
   virtual bool AddOpLog(uint32_t version, BgOpLog *oplog) = 0;
 
-  virtual BgOpLog *OpLogIterInit(uint32_t start_version,
-                                 uint32_t end_version) = 0;
-  virtual BgOpLog *OpLogIterNext(uint32_t *version) = 0;
+  // Apply to row_data the oplogs of the row that are of versions from
+  // start_version to end_version (inclusive), which have been sent.
+  virtual void ApplyOpLogs(int32_t table_id, int32_t row_id,
+                           uint32_t start_version, uint32_t end_version,
+                           AbstractRow *row_data) = 0;
+
+protected:
+  static void ApplyRowOpLog(RowOpLog *row_oplog, AbstractRow *row_data);
+
+  BgOpLogPool *oplog_pool_;
 };
 
 // Keep track of row requests that are sent to server or that could
@@ -105,15 +115,22 @@ public:
 // oplog cannot be deleted until all row requests sent prior to its version
 // (exclusive) have been replied.
 
+// Sent oplogs are kept by row rather than by version, so that a reply only
+// looks at the oplogs of its row and the BgOpLog is reused as soon as it is
+// sent. Kept oplogs take memory for the rows updated while requests are
+// pending, not for every row of every version.
+
 class SSPRowRequestOpLogMgr : public RowRequestOpLogMgr {
 public:
-  SSPRowRequestOpLogMgr() {}
+  explicit SSPRowRequestOpLogMgr(BgOpLogPool *oplog_pool):
+      RowRequestOpLogMgr(oplog_pool) {}
 
   ~SSPRowRequestOpLogMgr() {
-    for (auto iter = version_oplog_map_.begin();
-      iter != version_oplog_map_.end(); iter++) {
-      CHECK_NOTNULL(iter->second);
-      delete iter->second;
+    for (auto iter = row_oplogs_.begin(); iter != row_oplogs_.end(); iter++) {
+      for (auto oplog_iter = iter->second.begin();
+           oplog_iter != iter->second.end(); oplog_iter++) {
+        delete oplog_iter->second;
+      }
     }
   }
 
@@ -128,19 +145,21 @@ public:
   int32_t InformReply(int32_t table_id, int32_t row_id, int32_t clock,
     uint32_t curr_version, std::vector<int32_t> *app_thread_ids);
 
-  // Get OpLog of a particular version.
-  BgOpLog *GetOpLog(uint32_t version);
-
+  // Takes the row oplogs out of oplog if there are pending requests, never
+  // the oplog itself.
   bool AddOpLog(uint32_t version, BgOpLog *oplog);
 
   void InformVersionInc() { }
   // not supported
   void ServerAcknowledgeVersion(int32_t server_id, uint32_t version) { }
 
-  BgOpLog *OpLogIterInit(uint32_t start_version, uint32_t end_version);
-  BgOpLog *OpLogIterNext(uint32_t *version);
+  void ApplyOpLogs(int32_t table_id, int32_t row_id, uint32_t start_version,
+                   uint32_t end_version, AbstractRow *row_data);
 
 private:
+  // Delete the kept row oplogs of version.
+  void RemoveVersionOpLogs(uint32_t version);
+
   // When a row request of version V has been answered, oplogs with version
   // > V are not needed if there isn't and won't be any requests needing those
   // oplogs, so remove them.
@@ -157,23 +176,27 @@ private:
   std::map<std::pair<int32_t, int32_t>,
     std::list<RowRequestInfo> > pending_row_requests_;
 
-  // version -> (table_id, OpLogPartition)
+  // <table_id, row_id> -> (version, row oplog), in increasing order of
+  // version.
   // The version number of a request means that all oplogs up to and including
   // this version have been applied to this row.
-  // An OpLogPartition of version V is needed for requests sent before the oplog
+  // A row oplog of version V is needed for requests sent before the oplog
   // is sent. This means requests of version V - 1, V - 2, ...
-  std::map<uint32_t, BgOpLog* > version_oplog_map_;
+  std::map<std::pair<int32_t, int32_t>,
+    std::list<std::pair<uint32_t, RowOpLog*> > > row_oplogs_;
+
+  // Versions whose oplogs are kept -> rows updated in that version.
+  std::map<uint32_t, std::vector<std::pair<int32_t, int32_t> > >
+    version_rows_;
+
+  // Reused by AddOpLog().
+  std::vector<std::pair<int32_t, RowOpLog*> > released_row_oplogs_;
 
   // how many pending requests are in this version?
   // Map version to number of requests.
   // In increasing order of version number (need to consider version number wrap
   // around)
   std::map<uint32_t, int32_t> version_request_cnt_map_;
-
-  // used for OpLogIter
-  uint32_t oplog_iter_version_next_;
-  uint32_t oplog_iter_version_st_;
-  uint32_t oplog_iter_version_end_;
 };
 
 }  // namespace petuum
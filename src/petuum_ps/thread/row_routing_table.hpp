@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include <utility>
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+#include <glog/logging.h>
+
+#include "petuum_ps/thread/context.hpp"
+
+namespace petuum {
+
+// Maps rows to servers for a bg thread. Rows follow the table's static row
+// partitioning (GlobalContext::GetRowPartitionServerID()) unless they have
+// been migrated to another server. Each bg thread keeps its own table, so
+// a migration takes effect for a bg thread exactly when it applies the
+// RowMigrateMsg, before it acknowledges the migration to the servers.
+class RowRoutingTable : boost::noncopyable {
+public:
+  RowRoutingTable():
+      version_(0) { }
+
+  int32_t GetServerID(int32_t table_id, int32_t row_id) const {
+    if (!migrated_rows_.empty()) {
+      auto row_iter = migrated_rows_.find(std::make_pair(table_id, row_id));
+      if (row_iter != migrated_rows_.end())
+        return row_iter->second;
+    }
+    return GlobalContext::GetRowPartitionServerID(table_id, row_id);
+  }
+
+  // Route num_rows rows ((table id, row id) pairs in rows) to dst_server_id.
+  // Migrations are applied in the order of their versions.
+  void MigrateRows(int32_t version, const int32_t *rows, int32_t num_rows,
+    int32_t dst_server_id) {
+    CHECK_EQ(version_ + 1, version);
+    version_ = version;
+    for (int32_t i = 0; i < num_rows; ++i) {
+      int32_t table_id = rows[2*i];
+      int32_t row_id = rows[2*i + 1];
+      std::pair<int32_t, int32_t> row_key(table_id, row_id);
+      if (GlobalContext::GetRowPartitionServerID(table_id, row_id)
+          == dst_server_id)
+        migrated_rows_.erase(row_key);
+      else
+        migrated_rows_[row_key] = dst_server_id;
+    }
+  }
+
+  int32_t get_version() const {
+    return version_;
+  }
+
+private:
+  int32_t version_;
+  // (table id, row id) -> server id, for rows that are not on the server
+  // given by the static row partitioning.
+  boost::unordered_map<std::pair<int32_t, int32_t>, int32_t> migrated_rows_;
+};
+
+}  // namespace petuum
@@ -106,17 +106,17 @@ void SSPPushRowRequestOpLogMgr::ServerAcknowledgeVersion(int32_t server_id,
     if (version_to_remove > version_upper_bound) {
       if (version_oplog.first > version_upper_bound
 	  && version_oplog.first <= version_to_remove) {
-	delete version_oplog.second;
+	oplog_pool_->Put(version_oplog.second);
 	version_oplog_list_.pop_front();
       } else {
 	break;
       }
     } else {
       if (version_oplog.first > version_upper_bound) {
-	delete version_oplog.second;
+	oplog_pool_->Put(version_oplog.second);
 	version_oplog_list_.pop_front();
       } else if (version_oplog.first <= version_to_remove) {
-	delete version_oplog.second;
+	oplog_pool_->Put(version_oplog.second);
 	version_oplog_list_.pop_front();
       } else {
 	break;
@@ -130,6 +130,20 @@ void SSPPushRowRequestOpLogMgr::ServerAcknowledgeVersion(int32_t server_id,
 
 }
 
+void SSPPushRowRequestOpLogMgr::ApplyOpLogs(int32_t table_id, int32_t row_id,
+  uint32_t start_version, uint32_t end_version, AbstractRow *row_data) {
+  BgOpLog *bg_oplog = OpLogIterInit(start_version, end_version);
+  uint32_t oplog_version;
+
+  while (bg_oplog != NULL) {
+    BgOpLogPartition *bg_oplog_partition = bg_oplog->Get(table_id);
+    RowOpLog *row_oplog = bg_oplog_partition->FindOpLog(row_id);
+    if (row_oplog != 0)
+      ApplyRowOpLog(row_oplog, row_data);
+    bg_oplog = OpLogIterNext(&oplog_version);
+  }
+}
+
 BgOpLog *SSPPushRowRequestOpLogMgr::OpLogIterInit(uint32_t start_version,
                                                   uint32_t end_version) {
   oplog_iter_version_st_ = start_version;
@@ -25,7 +25,8 @@ namespace petuum {
 
 class SSPPushRowRequestOpLogMgr : public RowRequestOpLogMgr {
 public:
-  SSPPushRowRequestOpLogMgr() :
+  explicit SSPPushRowRequestOpLogMgr(BgOpLogPool *oplog_pool) :
+      RowRequestOpLogMgr(oplog_pool),
       server_version_mgr_(GlobalContext::get_server_ids()) { }
 
   ~SSPPushRowRequestOpLogMgr() {
@@ -54,6 +55,9 @@ public:
   // Remove oplogs that are before this version.
   void ServerAcknowledgeVersion(int32_t server_id, uint32_t version);
 
+  void ApplyOpLogs(int32_t table_id, int32_t row_id, uint32_t start_version,
+                   uint32_t end_version, AbstractRow *row_data);
+
   BgOpLog *OpLogIterInit(uint32_t start_version, uint32_t end_version);
   BgOpLog *OpLogIterNext(uint32_t *version);
 
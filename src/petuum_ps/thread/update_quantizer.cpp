@@ -0,0 +1,126 @@
+#include "petuum_ps/thread/update_quantizer.hpp"
+#include <glog/logging.h>
+#include <string.h>
+#include <cmath>
+#include <algorithm>
+
+namespace petuum {
+
+namespace {
+
+const float kMaxInt8 = 127;
+
+}  // anonymous namespace
+
+size_t UpdateQuantizer::GetQuantizedUpdateSize(UpdatePrecision precision) {
+  switch (precision) {
+    case HalfPrecision:
+      return sizeof(uint16_t);
+    case Int8Precision:
+      return sizeof(int8_t);
+    default:
+      LOG(FATAL) << "Unquantized update precision " << precision;
+  }
+  return 0;
+}
+
+void UpdateQuantizer::Quantize(UpdatePrecision precision, float *updates,
+  int32_t num_updates, float *residuals, void *mem) {
+  float max_magnitude = 0;
+  for (int32_t i = 0; i < num_updates; ++i) {
+    max_magnitude = std::max(max_magnitude, std::fabs(updates[i]));
+  }
+  // Half precision is most precise in [-1, 1] and does not overflow there.
+  float scale = (precision == Int8Precision) ? max_magnitude / kMaxInt8
+      : max_magnitude;
+  uint8_t *mem_uint8 = reinterpret_cast<uint8_t*>(mem);
+  memcpy(mem_uint8, &scale, sizeof(float));
+  mem_uint8 += sizeof(float);
+
+  for (int32_t i = 0; i < num_updates; ++i) {
+    float dequantized;
+    if (precision == Int8Precision) {
+      int8_t quantized = 0;
+      if (scale != 0) {
+        long rounded = std::lrint(updates[i] / scale);
+        quantized = static_cast<int8_t>(std::max(-127L,
+          std::min(127L, rounded)));
+      }
+      mem_uint8[i] = static_cast<uint8_t>(quantized);
+      dequantized = quantized*scale;
+    } else {
+      uint16_t quantized = (scale != 0) ? FloatToHalf(updates[i] / scale)
+          : 0;
+      memcpy(mem_uint8 + i*sizeof(uint16_t), &quantized, sizeof(uint16_t));
+      dequantized = HalfToFloat(quantized)*scale;
+    }
+    residuals[i] = updates[i] - dequantized;
+    updates[i] = dequantized;
+  }
+}
+
+void UpdateQuantizer::Dequantize(UpdatePrecision precision, const void *mem,
+  int32_t num_updates, float *updates) {
+  const uint8_t *mem_uint8 = reinterpret_cast<const uint8_t*>(mem);
+  float scale;
+  memcpy(&scale, mem_uint8, sizeof(float));
+  mem_uint8 += sizeof(float);
+
+  if (precision == Int8Precision) {
+    for (int32_t i = 0; i < num_updates; ++i) {
+      updates[i] = static_cast<int8_t>(mem_uint8[i])*scale;
+    }
+  } else {
+    for (int32_t i = 0; i < num_updates; ++i) {
+      uint16_t quantized;
+      memcpy(&quantized, mem_uint8 + i*sizeof(uint16_t), sizeof(uint16_t));
+      updates[i] = HalfToFloat(quantized)*scale;
+    }
+  }
+}
+
+uint16_t UpdateQuantizer::FloatToHalf(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(float));
+  uint16_t sign = (bits >> 16) & 0x8000;
+  uint32_t magnitude = bits & 0x7fffffff;
+
+  // Inf and NaN.
+  if (magnitude >= 0x7f800000)
+    return sign | 0x7c00 | ((magnitude > 0x7f800000) ? 0x200 : 0);
+  // Rounds to at least 65520, beyond the largest half.
+  if (magnitude >= 0x477ff000)
+    return sign | 0x7c00;
+  // Below 2^-14 halves are subnormal, in units of 2^-24.
+  if (magnitude < 0x38800000) {
+    float abs_value;
+    memcpy(&abs_value, &magnitude, sizeof(float));
+    return sign | static_cast<uint16_t>(std::nearbyint(abs_value*16777216.0f));
+  }
+  // Rebias the exponent from 127 to 15 and round the mantissa to 10 bits,
+  // to even on ties.
+  uint32_t mantissa_odd = (magnitude >> 13) & 1;
+  magnitude += 0xc8000fff + mantissa_odd;
+  return sign | static_cast<uint16_t>(magnitude >> 13);
+}
+
+float UpdateQuantizer::HalfToFloat(uint16_t value) {
+  uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+  uint32_t exponent = (value >> 10) & 0x1f;
+  uint32_t mantissa = value & 0x3ff;
+
+  if (exponent == 0) {
+    float magnitude = mantissa/16777216.0f;
+    return sign ? -magnitude : magnitude;
+  }
+  uint32_t bits;
+  if (exponent == 0x1f)
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  else
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  float result;
+  memcpy(&result, &bits, sizeof(float));
+  return result;
+}
+
+}  // namespace petuum
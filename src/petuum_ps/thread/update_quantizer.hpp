@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "petuum_ps/include/configs.hpp"
+
+namespace petuum {
+
+// Converts the float updates of a row oplog to and from the lower
+// precisions of UpdatePrecision. The quantized updates of a row are
+// 1. float : scale, the largest magnitude of the updates divided by the
+//    largest quantized magnitude
+// 2. an array of quantized updates, each GetQuantizedUpdateSize() bytes;
+//    update i is dequantized to quantized_i*scale
+class UpdateQuantizer {
+public:
+  static size_t GetQuantizedUpdateSize(UpdatePrecision precision);
+
+  // Number of bytes of num_updates quantized updates, including the scale.
+  static size_t GetQuantizedSize(UpdatePrecision precision,
+    int32_t num_updates) {
+    return sizeof(float) + GetQuantizedUpdateSize(precision)*num_updates;
+  }
+
+  // Quantize num_updates updates to mem. updates are replaced by their
+  // dequantized values and residuals are set to the differences.
+  static void Quantize(UpdatePrecision precision, float *updates,
+    int32_t num_updates, float *residuals, void *mem);
+
+  static void Dequantize(UpdatePrecision precision, const void *mem,
+    int32_t num_updates, float *updates);
+
+  // IEEE 754 half precision conversions, rounding to nearest even.
+  static uint16_t FloatToHalf(float value);
+  static float HalfToFloat(uint16_t value);
+};
+
+}  // namespace petuum
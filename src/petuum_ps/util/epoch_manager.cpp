@@ -0,0 +1,114 @@
+#include "petuum_ps/util/epoch_manager.hpp"
+#include <glog/logging.h>
+#include <algorithm>
+
+namespace petuum {
+
+std::atomic<uint64_t> EpochManager::global_epoch_(0);
+
+std::atomic<EpochManager::ThreadSlot*> EpochManager::slots_(0);
+
+boost::thread_specific_ptr<EpochManager::ThreadSlot>
+EpochManager::thread_slot_(&EpochManager::ReleaseSlot);
+
+std::mutex EpochManager::retired_mtx_;
+
+std::vector<EpochManager::RetiredObj> EpochManager::retired_;
+
+size_t EpochManager::reclaim_threshold_ = EpochManager::kReclaimBatchSize;
+
+EpochManager::ThreadSlot::ThreadSlot():
+  epoch(kQuiescent),
+  nesting(0),
+  in_use(true),
+  next(0) { }
+
+void EpochManager::Enter() {
+  ThreadSlot *slot = GetSlot();
+  if (slot->nesting++ == 0) {
+    // The fence makes the announcement visible to Retire() before any shared
+    // pointer is read.
+    slot->epoch.store(global_epoch_.load(), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+}
+
+void EpochManager::Exit() {
+  ThreadSlot *slot = thread_slot_.get();
+  CHECK(slot != 0 && slot->nesting > 0) << "Exit() without Enter()";
+  if (--slot->nesting == 0) {
+    slot->epoch.store(kQuiescent, std::memory_order_release);
+  }
+}
+
+void EpochManager::Retire(void *obj, void (*deleter)(void*)) {
+  // Readers that announce an epoch > retire_epoch could not have seen obj.
+  uint64_t retire_epoch = global_epoch_.fetch_add(1);
+  std::vector<RetiredObj> freeable;
+  {
+    std::lock_guard<std::mutex> lock(retired_mtx_);
+    retired_.push_back({obj, deleter, retire_epoch});
+    if (retired_.size() >= reclaim_threshold_)
+      CollectFreeable(&freeable);
+  }
+  for (const auto &retired : freeable) {
+    retired.deleter(retired.obj);
+  }
+}
+
+void EpochManager::Reclaim() {
+  std::vector<RetiredObj> freeable;
+  {
+    std::lock_guard<std::mutex> lock(retired_mtx_);
+    CollectFreeable(&freeable);
+  }
+  for (const auto &retired : freeable) {
+    retired.deleter(retired.obj);
+  }
+}
+
+// ================ Private Methods =================
+
+EpochManager::ThreadSlot *EpochManager::GetSlot() {
+  ThreadSlot *slot = thread_slot_.get();
+  if (slot != 0)
+    return slot;
+
+  // Reuse a slot released by an exited thread.
+  for (slot = slots_.load(); slot != 0; slot = slot->next) {
+    bool expected = false;
+    if (slot->in_use.compare_exchange_strong(expected, true)) {
+      thread_slot_.reset(slot);
+      return slot;
+    }
+  }
+
+  slot = new ThreadSlot;
+  slot->next = slots_.load();
+  while (!slots_.compare_exchange_weak(slot->next, slot)) { }
+  thread_slot_.reset(slot);
+  return slot;
+}
+
+void EpochManager::ReleaseSlot(ThreadSlot *slot) {
+  CHECK_EQ(0, slot->nesting) << "thread exited inside an epoch";
+  slot->epoch.store(kQuiescent);
+  slot->in_use.store(false);
+}
+
+void EpochManager::CollectFreeable(std::vector<RetiredObj> *freeable) {
+  uint64_t min_epoch = kQuiescent;
+  for (ThreadSlot *slot = slots_.load(); slot != 0; slot = slot->next) {
+    min_epoch = std::min(min_epoch, slot->epoch.load());
+  }
+  auto keep_end = std::partition(retired_.begin(), retired_.end(),
+      [min_epoch](const RetiredObj &retired) {
+        return retired.epoch >= min_epoch; });
+  freeable->assign(keep_end, retired_.end());
+  retired_.erase(keep_end, retired_.end());
+  reclaim_threshold_ = 2*retired_.size();
+  if (reclaim_threshold_ < kReclaimBatchSize)
+    reclaim_threshold_ = kReclaimBatchSize;
+}
+
+}  // namespace petuum
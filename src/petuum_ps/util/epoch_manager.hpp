@@ -0,0 +1,100 @@
+#pragma once
+
+#include <boost/thread/tss.hpp>
+#include <boost/utility.hpp>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace petuum {
+
+// Epoch-based reclamation for objects that are read without locks (e.g.
+// ClientRow and row data in ProcessStorage).
+//
+// A reader brackets its accesses with Enter() / Exit(), which only write to
+// a cache line owned by the calling thread. A writer first unlinks an object
+// so no new reader can reach it and then Retire()s it; the object is
+// deleted once every thread that was inside an epoch at that time has
+// called Exit(). Enter() / Exit() nest within a thread, and a thread must
+// Exit() as many times as it Enter()s.
+//
+// Reclamation never blocks: a thread that stays inside an epoch for long only
+// delays freeing the retired objects.
+class EpochManager : boost::noncopyable {
+public:
+  static void Enter();
+
+  static void Exit();
+
+  // Take ownership of obj, which must no longer be reachable by readers
+  // that Enter() from now on.
+  template<typename T>
+  static void Retire(T *obj) {
+    if (obj != 0)
+      Retire(obj, &Delete<T>);
+  }
+
+  static void Retire(void *obj, void (*deleter)(void*));
+
+  // Delete all retired objects that no reader can still reference.
+  static void Reclaim();
+
+private:
+  // One per thread. Slots are reused after their thread exits and are never
+  // freed.
+  struct ThreadSlot {
+    ThreadSlot();
+
+    // Epoch the thread entered, or kQuiescent.
+    std::atomic<uint64_t> epoch;
+    // Only accessed by the owning thread.
+    int32_t nesting;
+    std::atomic<bool> in_use;
+    ThreadSlot *next;
+    // Keeps the slots of different threads off each other's cache line.
+    uint8_t padding[64];
+  };
+
+  struct RetiredObj {
+    void *obj;
+    void (*deleter)(void*);
+    uint64_t epoch;
+  };
+
+  template<typename T>
+  static void Delete(void *obj) {
+    delete reinterpret_cast<T*>(obj);
+  }
+
+  static ThreadSlot *GetSlot();
+
+  // Cleanup function of thread_slot_.
+  static void ReleaseSlot(ThreadSlot *slot);
+
+  // Move the retired objects that are safe to free out of retired_. Caller
+  // holds retired_mtx_.
+  static void CollectFreeable(std::vector<RetiredObj> *freeable);
+
+  static const uint64_t kQuiescent = UINT64_MAX;
+
+  // Try reclaiming whenever this many objects are pending.
+  static const size_t kReclaimBatchSize = 64;
+
+  // Retire() collects once retired_ reaches this size, which is then set to
+  // twice the objects left, so that a reader holding an old epoch does not
+  // make every Retire() scan the whole list. Guarded by retired_mtx_.
+  static size_t reclaim_threshold_;
+
+  static std::atomic<uint64_t> global_epoch_;
+
+  static std::atomic<ThreadSlot*> slots_;
+
+  static boost::thread_specific_ptr<ThreadSlot> thread_slot_;
+
+  static std::mutex retired_mtx_;
+
+  static std::vector<RetiredObj> retired_;
+};
+
+}  // namespace petuum
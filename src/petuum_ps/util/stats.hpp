@@ -59,7 +59,14 @@ enum StatsType {
   SSPPUSH_BATCH_INC_THR_UPDATE_INDEX = 13,
   SSPPUSH_BATCH_INC_OPLOG = 14,
   SSPPUSH_BATCH_INC_PROCESS_STORAGE = 15,
-  SSPPUSH_THREAD_BATCH_INC = 16
+  SSPPUSH_THREAD_BATCH_INC = 16,
+  INC_ROW = 17,
+  SSP_INC_ROW = 18,
+  SSP_THREAD_INC_ROW = 19,
+  SSPPUSH_INC_ROW_THR_UPDATE_INDEX = 20,
+  SSPPUSH_INC_ROW_OPLOG = 21,
+  SSPPUSH_INC_ROW_PROCESS_STORAGE = 22,
+  SSPPUSH_THREAD_INC_ROW = 23
 };
 
 const std::vector<std::string> kStatsTypeName =
@@ -67,7 +74,9 @@ const std::vector<std::string> kStatsTypeName =
    "BG_CREATE_SEND_OPLOG", "BG_CREATE_OPLOG_PREP", "BG_CREATE_OPLOG_MKMEM",
    "BG_CREATE_OPLOG_SERIALIZE", "SERVER_HANDLE_OPLOG_MSG", "SORTED_VECTOR_MAP_BATCH_INC_UNSAFE",
    "SSPPUSH_BATCH_INC_THR_UPDATE_INDEX", "SSPPUSH_BATCH_INC_OPLOG", "SSPPUSH_BATCH_INC_PRCESS_STORAGE",
-   "SSPPUSH_THREAD_BATCH_INC"};
+   "SSPPUSH_THREAD_BATCH_INC", "INC_ROW", "SSP_INC_ROW", "SSP_THREAD_INC_ROW",
+   "SSPPUSH_INC_ROW_THR_UPDATE_INDEX", "SSPPUSH_INC_ROW_OPLOG",
+   "SSPPUSH_INC_ROW_PROCESS_STORAGE", "SSPPUSH_THREAD_INC_ROW"};
 
 
 class Stats {
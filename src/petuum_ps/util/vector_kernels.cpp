@@ -0,0 +1,92 @@
+#include "petuum_ps/util/vector_kernels.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PETUUM_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace petuum {
+
+namespace {
+
+template<typename V>
+inline void ScalarAddArray(V *dst, const V *src, int32_t num) {
+  for (int32_t i = 0; i < num; ++i) {
+    dst[i] += src[i];
+  }
+}
+
+#ifdef PETUUM_X86_KERNELS
+
+bool CPUHasAVX2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+const bool kHasAVX2 = CPUHasAVX2();
+
+__attribute__((target("avx2")))
+void AVX2AddArray(float *dst, const float *src, int32_t num) {
+  int32_t i = 0;
+  for (; i + 8 <= num; i += 8) {
+    __m256 d = _mm256_loadu_ps(dst + i);
+    __m256 s = _mm256_loadu_ps(src + i);
+    _mm256_storeu_ps(dst + i, _mm256_add_ps(d, s));
+  }
+  ScalarAddArray(dst + i, src + i, num - i);
+}
+
+__attribute__((target("avx2")))
+void AVX2AddArray(double *dst, const double *src, int32_t num) {
+  int32_t i = 0;
+  for (; i + 4 <= num; i += 4) {
+    __m256d d = _mm256_loadu_pd(dst + i);
+    __m256d s = _mm256_loadu_pd(src + i);
+    _mm256_storeu_pd(dst + i, _mm256_add_pd(d, s));
+  }
+  ScalarAddArray(dst + i, src + i, num - i);
+}
+
+__attribute__((target("avx2")))
+void AVX2AddArray(int32_t *dst, const int32_t *src, int32_t num) {
+  int32_t i = 0;
+  for (; i + 8 <= num; i += 8) {
+    __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+    __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                        _mm256_add_epi32(d, s));
+  }
+  ScalarAddArray(dst + i, src + i, num - i);
+}
+
+#endif
+
+template<typename V>
+inline void DispatchAddArray(V *dst, const V *src, int32_t num) {
+#ifdef PETUUM_X86_KERNELS
+  if (kHasAVX2) {
+    AVX2AddArray(dst, src, num);
+    return;
+  }
+#endif
+  ScalarAddArray(dst, src, num);
+}
+
+}   // anonymous namespace
+
+template<>
+void AddArray<float>(float *dst, const float *src, int32_t num) {
+  DispatchAddArray(dst, src, num);
+}
+
+template<>
+void AddArray<double>(double *dst, const double *src, int32_t num) {
+  DispatchAddArray(dst, src, num);
+}
+
+template<>
+void AddArray<int32_t>(int32_t *dst, const int32_t *src, int32_t num) {
+  DispatchAddArray(dst, src, num);
+}
+
+}   // namespace petuum
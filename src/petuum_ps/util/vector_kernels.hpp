@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace petuum {
+
+// dst[i] += src[i] for i in [0, num). dst and src must not overlap.
+//
+// float, double and int32_t are specialized with AVX2 kernels that are
+// selected at run time when the CPU supports AVX2, so the library does not
+// need to be compiled with -mavx2; otherwise the scalar loop is used.
+template<typename V>
+inline void AddArray(V *dst, const V *src, int32_t num) {
+  for (int32_t i = 0; i < num; ++i) {
+    dst[i] += src[i];
+  }
+}
+
+template<>
+void AddArray<float>(float *dst, const float *src, int32_t num);
+
+template<>
+void AddArray<double>(double *dst, const double *src, int32_t num);
+
+template<>
+void AddArray<int32_t>(int32_t *dst, const int32_t *src, int32_t num);
+
+// Length of the run of consecutive column ids starting at column_ids[0],
+// i.e. the largest n <= num such that column_ids[i] == column_ids[0] + i for
+// i < n.
+inline int32_t GetContiguousRunLength(const int32_t *column_ids,
+                                      int32_t num) {
+  int32_t n = 1;
+  while (n < num && column_ids[n] == column_ids[0] + n) {
+    ++n;
+  }
+  return n;
+}
+
+}   // namespace petuum
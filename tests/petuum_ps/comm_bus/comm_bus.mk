@@ -0,0 +1,10 @@
+COMM_BUS_TESTS_DIR = $(TESTS)/petuum_ps/comm_bus
+
+$(TESTS_BIN)/zmq_util_test: $(COMM_BUS_TESTS_DIR)/zmq_util_test.cpp \
+	$(SRC)/petuum_ps/comm_bus/zmq_util.cpp \
+	$(SRC)/petuum_ps/comm_bus/zmq_util.hpp
+	$(CXX) $(CXXFLAGS) $(INCFLAGS) $< \
+		$(SRC)/petuum_ps/comm_bus/zmq_util.cpp $(TESTS_LDFLAGS) -o $@
+
+zmq_util_test_run: $(TESTS_BIN)/zmq_util_test
+	GLOG_logtostderr=true $<
@@ -0,0 +1,128 @@
+// Copyright (c) 2014, Sailing Lab
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the <ORGANIZATION> nor the names of its contributors
+// may be used to endorse or promote products derived from this software
+// without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "petuum_ps/comm_bus/zmq_util.hpp"
+#include <gtest/gtest.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+
+namespace petuum {
+
+namespace {
+
+int32_t num_freed = 0;
+
+void FreeBuffer(void *data, void *hint) {
+  delete[] reinterpret_cast<uint8_t*>(data);
+  ++num_freed;
+}
+
+// A message that hands its buffer to ZMQ, as MemTransfer does for large
+// messages to remote receivers.
+void MakeZeroCopyMsg(size_t size, zmq::message_t *msg) {
+  uint8_t *data = new uint8_t[size];
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = static_cast<uint8_t>(i);
+  }
+  msg->rebuild(data, size, &FreeBuffer, NULL);
+}
+
+void ExpectMsgData(zmq::message_t &msg, size_t size) {
+  ASSERT_EQ(size, msg.size());
+  const uint8_t *data = reinterpret_cast<const uint8_t*>(msg.data());
+  for (size_t i = 0; i < size; ++i) {
+    ASSERT_EQ(static_cast<uint8_t>(i), data[i]) << "i = " << i;
+  }
+}
+
+}  // anonymous namespace
+
+TEST(ZMQUtilTest, SendMsgReturnsSize) {
+  zmq::context_t zmq_ctx(1);
+  zmq::socket_t recv_sock(zmq_ctx, ZMQ_PAIR);
+  zmq::socket_t send_sock(zmq_ctx, ZMQ_PAIR);
+  ZMQUtil::ZMQBind(&recv_sock, "inproc://zmq_util_test_pair");
+  send_sock.connect("inproc://zmq_util_test_pair");
+
+  const size_t kSize = 8192;
+  num_freed = 0;
+  {
+    zmq::message_t msg;
+    MakeZeroCopyMsg(kSize, &msg);
+    EXPECT_EQ(kSize, ZMQUtil::ZMQSend(&send_sock, msg));
+
+    zmq::message_t recv_msg;
+    ZMQUtil::ZMQRecv(&recv_sock, &recv_msg);
+    ExpectMsgData(recv_msg, kSize);
+  }
+  // Freed by ZMQ once the receiver is done with it.
+  EXPECT_EQ(1, num_freed);
+}
+
+TEST(ZMQUtilTest, SendMsgToZmqIdReturnsSize) {
+  zmq::context_t zmq_ctx(1);
+  zmq::socket_t router_sock(zmq_ctx, ZMQ_ROUTER);
+  zmq::socket_t dealer_sock(zmq_ctx, ZMQ_DEALER);
+  int32_t sock_mandatory = 1;
+  ZMQUtil::ZMQSetSockOpt(&router_sock, ZMQ_ROUTER_MANDATORY, &sock_mandatory,
+                         sizeof(sock_mandatory));
+  int32_t dealer_zmq_id = ZMQUtil::EntityID2ZmqID(1);
+  ZMQUtil::ZMQSetSockOpt(&dealer_sock, ZMQ_IDENTITY, &dealer_zmq_id,
+                         sizeof(dealer_zmq_id));
+  ZMQUtil::ZMQBind(&router_sock, "inproc://zmq_util_test_router");
+  dealer_sock.connect("inproc://zmq_util_test_router");
+
+  // Let the router learn the dealer's id.
+  int32_t hello = 0;
+  ASSERT_EQ(sizeof(hello),
+            ZMQUtil::ZMQSend(&dealer_sock, &hello, sizeof(hello)));
+  {
+    int32_t zmq_id;
+    zmq::message_t msg;
+    ZMQUtil::ZMQRecv(&router_sock, &zmq_id, &msg);
+    ASSERT_EQ(dealer_zmq_id, zmq_id);
+  }
+
+  const size_t kSize = 4096;
+  num_freed = 0;
+  {
+    zmq::message_t msg;
+    MakeZeroCopyMsg(kSize, &msg);
+    EXPECT_EQ(kSize, ZMQUtil::ZMQSend(&router_sock, dealer_zmq_id, msg));
+
+    zmq::message_t recv_msg;
+    ZMQUtil::ZMQRecv(&dealer_sock, &recv_msg);
+    ExpectMsgData(recv_msg, kSize);
+  }
+  EXPECT_EQ(1, num_freed);
+}
+
+}  // namespace petuum
@@ -0,0 +1,15 @@
+
+OPLOG_TESTS_DIR = $(TESTS)/petuum_ps/oplog
+
+$(TESTS_BIN)/row_oplog_test: $(OPLOG_TESTS_DIR)/row_oplog_test.cpp \
+	$(SRC)/petuum_ps/oplog/row_oplog.hpp \
+	$(SRC)/petuum_ps/oplog/oplog_partition.cpp \
+	$(SRC)/petuum_ps/oplog/oplog_partition.hpp
+	$(CXX) $(CXXFLAGS) $(INCFLAGS) $< \
+		$(SRC)/petuum_ps/oplog/oplog_partition.cpp \
+		$(SRC)/petuum_ps/thread/context.cpp \
+		$(SRC)/petuum_ps/util/vector_kernels.cpp \
+		$(SRC)/petuum_ps/util/lock.cpp $(TESTS_LDFLAGS) -o $@
+
+row_oplog_test_run: $(TESTS_BIN)/row_oplog_test
+	GLOG_logtostderr=true $<
@@ -0,0 +1,199 @@
+// Copyright (c) 2014, Sailing Lab
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the <ORGANIZATION> nor the names of its contributors
+// may be used to endorse or promote products derived from this software
+// without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "petuum_ps/oplog/row_oplog.hpp"
+#include "petuum_ps/oplog/oplog_partition.hpp"
+#include "petuum_ps/storage/dense_row.hpp"
+#include "petuum_ps/thread/context.hpp"
+#include <gtest/gtest.h>
+#include <map>
+#include <vector>
+
+namespace petuum {
+
+namespace {
+
+const int32_t kCapacity = 130;
+
+// column id -> update, checking that iteration visits GetSize() columns.
+std::map<int32_t, float> GetUpdates(RowOpLog *row_oplog) {
+  std::map<int32_t, float> updates;
+  int32_t column_id;
+  void *update = row_oplog->BeginIterate(&column_id);
+  while (update != 0) {
+    EXPECT_EQ(0u, updates.count(column_id));
+    updates[column_id] = *reinterpret_cast<float*>(update);
+    update = row_oplog->Next(&column_id);
+  }
+  EXPECT_EQ(row_oplog->GetSize(), static_cast<int32_t>(updates.size()));
+  return updates;
+}
+
+void Inc(const AbstractRow &sample_row, RowOpLog *row_oplog,
+  int32_t column_id, float delta) {
+  sample_row.AddUpdates(column_id, row_oplog->FindCreate(column_id), &delta);
+}
+
+// Updates to columns in different bitmap words of a DenseRowOpLog.
+void ExpectFindCreateAndIterate(RowOpLog *row_oplog) {
+  DenseRow<float> sample_row;
+  EXPECT_EQ(0, row_oplog->GetSize());
+  int32_t column_id;
+  EXPECT_TRUE(row_oplog->BeginIterate(&column_id) == 0);
+  EXPECT_TRUE(row_oplog->Find(3) == 0);
+
+  Inc(sample_row, row_oplog, 64, 1);
+  Inc(sample_row, row_oplog, 3, 2);
+  Inc(sample_row, row_oplog, 129, 3);
+  Inc(sample_row, row_oplog, 64, 0.5);
+  EXPECT_EQ(3, row_oplog->GetSize());
+  ASSERT_TRUE(row_oplog->Find(3) != 0);
+  EXPECT_EQ(row_oplog->Find(3), row_oplog->FindCreate(3));
+  EXPECT_TRUE(row_oplog->Find(63) == 0);
+
+  std::map<int32_t, float> updates = GetUpdates(row_oplog);
+  ASSERT_EQ(3u, updates.size());
+  EXPECT_EQ(2, updates[3]);
+  EXPECT_EQ(1.5, updates[64]);
+  EXPECT_EQ(3, updates[129]);
+}
+
+// IncRow() on a row oplog that already has an update past num_updates.
+void ExpectIncRow(RowOpLog *row_oplog) {
+  DenseRow<float> sample_row;
+  Inc(sample_row, row_oplog, 100, 7);
+  Inc(sample_row, row_oplog, 1, 1);
+  std::vector<float> deltas(70);
+  for (int32_t i = 0; i < 70; ++i) {
+    deltas[i] = i;
+  }
+  row_oplog->IncRow(deltas.data(), deltas.size());
+  EXPECT_EQ(71, row_oplog->GetSize());
+
+  std::map<int32_t, float> updates = GetUpdates(row_oplog);
+  EXPECT_EQ(2, updates[1]);
+  EXPECT_EQ(69, updates[69]);
+  EXPECT_EQ(7, updates[100]);
+}
+
+void InitContext() {
+  GlobalContext::Init(1, 1, 1, 1, 1, 1, 1, 1, std::vector<int32_t>(1, 1),
+    std::map<int32_t, HostInfo>(), 0, 1, SSP, false);
+}
+
+}  // anonymous namespace
+
+TEST(RowOpLogTest, CreateRowOpLog) {
+  DenseRow<float> sample_row;
+  RowOpLog *row_oplog = CreateRowOpLog(sizeof(float), &sample_row,
+    kCapacity);
+  EXPECT_TRUE(dynamic_cast<DenseRowOpLog*>(row_oplog) != 0);
+  delete row_oplog;
+
+  // Without a capacity the columns are unbounded.
+  row_oplog = CreateRowOpLog(sizeof(float), &sample_row, 0);
+  EXPECT_TRUE(dynamic_cast<MapRowOpLog*>(row_oplog) != 0);
+  delete row_oplog;
+}
+
+TEST(RowOpLogTest, DenseRowOpLog) {
+  DenseRow<float> sample_row;
+  {
+    DenseRowOpLog row_oplog(sizeof(float), &sample_row, kCapacity);
+    ExpectFindCreateAndIterate(&row_oplog);
+  }
+  {
+    DenseRowOpLog row_oplog(sizeof(float), &sample_row, kCapacity);
+    ExpectIncRow(&row_oplog);
+  }
+
+  // Iteration is in column order.
+  DenseRowOpLog row_oplog(sizeof(float), &sample_row, kCapacity);
+  Inc(sample_row, &row_oplog, 127, 1);
+  Inc(sample_row, &row_oplog, 0, 1);
+  Inc(sample_row, &row_oplog, 63, 1);
+  int32_t column_id;
+  std::vector<int32_t> column_ids;
+  for (void *update = row_oplog.BeginIterate(&column_id); update != 0;
+       update = row_oplog.Next(&column_id)) {
+    column_ids.push_back(column_id);
+  }
+  ASSERT_EQ(3u, column_ids.size());
+  EXPECT_EQ(0, column_ids[0]);
+  EXPECT_EQ(63, column_ids[1]);
+  EXPECT_EQ(127, column_ids[2]);
+}
+
+TEST(RowOpLogTest, MapRowOpLog) {
+  DenseRow<float> sample_row;
+  {
+    MapRowOpLog row_oplog(sizeof(float), &sample_row);
+    ExpectFindCreateAndIterate(&row_oplog);
+  }
+  MapRowOpLog row_oplog(sizeof(float), &sample_row);
+  ExpectIncRow(&row_oplog);
+}
+
+// Inc() and BatchInc() reach the row oplogs through OpLogPartition, and
+// GetEraseOpLog() resets a row: its next update starts a new row oplog.
+TEST(RowOpLogTest, OpLogPartitionIncAndErase) {
+  InitContext();
+  DenseRow<float> sample_row;
+  // DenseRowOpLog, then MapRowOpLog.
+  int32_t row_capacities[2] = {kCapacity, 0};
+  for (int32_t i = 0; i < 2; ++i) {
+    OpLogPartition partition(10, &sample_row, 0, row_capacities[i]);
+    const int32_t kRowID = 5;
+    float delta = 1;
+    partition.Inc(kRowID, 7, &delta);
+    int32_t column_ids[3] = {7, 70, 2};
+    float deltas[3] = {2, 3, 4};
+    partition.BatchInc(kRowID, column_ids, deltas, 3);
+
+    RowOpLog *row_oplog = 0;
+    ASSERT_TRUE(partition.GetEraseOpLog(kRowID, &row_oplog));
+    std::map<int32_t, float> updates = GetUpdates(row_oplog);
+    ASSERT_EQ(3u, updates.size());
+    EXPECT_EQ(3, updates[7]);
+    EXPECT_EQ(3, updates[70]);
+    EXPECT_EQ(4, updates[2]);
+    delete row_oplog;
+
+    EXPECT_FALSE(partition.GetEraseOpLog(kRowID, &row_oplog));
+    partition.Inc(kRowID, 70, &delta);
+    ASSERT_TRUE(partition.GetEraseOpLog(kRowID, &row_oplog));
+    updates = GetUpdates(row_oplog);
+    ASSERT_EQ(1u, updates.size());
+    EXPECT_EQ(1, updates[70]);
+    delete row_oplog;
+  }
+}
+
+}  // namespace petuum
@@ -0,0 +1,208 @@
+// Copyright (c) 2014, Sailing Lab
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the <ORGANIZATION> nor the names of its contributors
+// may be used to endorse or promote products derived from this software
+// without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "petuum_ps/server/server.hpp"
+#include "petuum_ps/storage/dense_row.hpp"
+#include "petuum_ps/thread/context.hpp"
+#include "petuum_ps/util/class_register.hpp"
+#include <gtest/gtest.h>
+#include <string.h>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace petuum {
+
+namespace {
+
+const int32_t kTableId = 0;
+const int32_t kRowCapacity = 4;
+const int32_t kSrcServerId = 1;
+const int32_t kDstServerId = 2;
+const int32_t kBgId0 = 100;
+const int32_t kBgId1 = 101;
+const int32_t kMigrationVersion = 1;
+// On the source server under ModuloPartition.
+const int32_t kRowId = 0;
+
+// One client with two bg threads and two servers.
+void InitContext() {
+  std::vector<int32_t> server_ids;
+  server_ids.push_back(kSrcServerId);
+  server_ids.push_back(kDstServerId);
+  GlobalContext::Init(2, 2, 1, 1, 2, 2, 1, 1, server_ids,
+    std::map<int32_t, HostInfo>(), 0, 1, SSP, false);
+  GlobalContext::SetNumServerApplyThreads(1);
+  ClassRegistry<AbstractRow>::GetRegistry().AddCreator(0,
+    CreateObj<AbstractRow, DenseRow<int> >);
+}
+
+void InitServer(Server *server) {
+  server->AddClientBgPair(0, kBgId0);
+  server->AddClientBgPair(0, kBgId1);
+  server->Init();
+  TableInfo table_info;
+  table_info.table_staleness = 0;
+  table_info.row_type = 0;
+  table_info.row_capacity = kRowCapacity;
+  server->CreateTable(kTableId, table_info);
+}
+
+// Serialized oplog that adds delta to column 0 of kRowId, or an empty oplog
+// if delta is 0.
+std::vector<uint8_t> MakeOpLog(int delta) {
+  std::vector<uint8_t> oplog(sizeof(int32_t));
+  if (delta == 0) {
+    *reinterpret_cast<int32_t*>(oplog.data()) = 0;
+    return oplog;
+  }
+  oplog.resize(sizeof(int32_t) + sizeof(int32_t) + sizeof(size_t)
+               + 4*sizeof(int32_t) + sizeof(int));
+  uint8_t *mem = oplog.data();
+  *reinterpret_cast<int32_t*>(mem) = 1;
+  mem += sizeof(int32_t);
+  *reinterpret_cast<int32_t*>(mem) = kTableId;
+  mem += sizeof(int32_t);
+  *reinterpret_cast<size_t*>(mem) = sizeof(int);
+  mem += sizeof(size_t);
+  int32_t *row_oplog = reinterpret_cast<int32_t*>(mem);
+  row_oplog[0] = 1;       // number of rows
+  row_oplog[1] = kRowId;
+  row_oplog[2] = 1;       // number of updates
+  row_oplog[3] = 0;       // column id
+  memcpy(row_oplog + 4, &delta, sizeof(int));
+  return oplog;
+}
+
+void ApplyOpLog(Server *server, int32_t bg_id, uint32_t version, int delta) {
+  std::vector<uint8_t> oplog = MakeOpLog(delta);
+  server->ApplyOpLog(oplog.data(), bg_id, version);
+}
+
+int GetColumn0(Server *server) {
+  ServerRow *server_row = server->FindCreateRow(kTableId, kRowId);
+  std::vector<uint8_t> bytes(server_row->SerializedSize());
+  size_t num_bytes = server_row->Serialize(bytes.data());
+  DenseRow<int> row;
+  row.Deserialize(bytes.data(), num_bytes);
+  return row[0];
+}
+
+// Both bg threads acknowledge the migration of kRowId to both servers, and
+// the source ships it.
+MigratedRowsMsg *MigrateRow(Server *src_server, Server *dst_server) {
+  const int32_t rows[] = {kTableId, kRowId};
+  EXPECT_FALSE(src_server->AckRowMigrateOut(kMigrationVersion, rows, 1));
+  dst_server->AckRowMigrateIn(kMigrationVersion, rows, 1);
+  EXPECT_TRUE(src_server->AckRowMigrateOut(kMigrationVersion, rows, 1));
+  dst_server->AckRowMigrateIn(kMigrationVersion, rows, 1);
+  EXPECT_TRUE(src_server->IsRowMigrating(kTableId, kRowId));
+  EXPECT_TRUE(dst_server->IsRowMigrating(kTableId, kRowId));
+
+  src_server->HoldRowRequest(kBgId1, kTableId, kRowId, 0);
+  MigratedRowsMsg *msg = src_server->CreateMigratedRowsMsg(kMigrationVersion,
+                                                          kDstServerId);
+  EXPECT_FALSE(src_server->IsRowMigrating(kTableId, kRowId));
+  return msg;
+}
+
+}  // anonymous namespace
+
+TEST(RowMigrationTest, RoundTrip) {
+  InitContext();
+  Server src_server;
+  Server dst_server;
+  InitServer(&src_server);
+  InitServer(&dst_server);
+
+  ApplyOpLog(&src_server, kBgId0, 0, 1);
+  ApplyOpLog(&dst_server, kBgId0, 0, 0);
+  ApplyOpLog(&src_server, kBgId1, 0, 0);
+  ApplyOpLog(&dst_server, kBgId1, 0, 0);
+
+  MigratedRowsMsg *msg = MigrateRow(&src_server, &dst_server);
+  std::vector<ServerRowRequest> requests;
+  EXPECT_TRUE(dst_server.InstallMigratedRows(*msg, &requests));
+  delete msg;
+
+  EXPECT_FALSE(dst_server.IsRowMigrating(kTableId, kRowId));
+  ASSERT_EQ(1u, requests.size());
+  EXPECT_EQ(kBgId1, requests[0].bg_id);
+  EXPECT_EQ(kTableId, requests[0].table_id);
+  EXPECT_EQ(kRowId, requests[0].row_id);
+  EXPECT_EQ(0, requests[0].clock);
+  EXPECT_EQ(1, GetColumn0(&dst_server));
+
+  // Later updates go to the destination.
+  ApplyOpLog(&dst_server, kBgId0, 1, 2);
+  EXPECT_EQ(3, GetColumn0(&dst_server));
+}
+
+TEST(RowMigrationTest, InstallWaitsForSourceVersions) {
+  InitContext();
+  Server src_server;
+  Server dst_server;
+  InitServer(&src_server);
+  InitServer(&dst_server);
+
+  ApplyOpLog(&src_server, kBgId0, 0, 1);
+  ApplyOpLog(&dst_server, kBgId0, 0, 0);
+  ApplyOpLog(&src_server, kBgId1, 0, 0);
+  ApplyOpLog(&dst_server, kBgId1, 0, 0);
+
+  // Sent by kBgId0 after it acknowledged. The source receives version 1
+  // before it ships the row, the destination after.
+  ApplyOpLog(&src_server, kBgId0, 1, 0);
+  MigratedRowsMsg *msg = MigrateRow(&src_server, &dst_server);
+
+  std::vector<ServerRowRequest> requests;
+  std::vector<int32_t> migration_versions;
+  EXPECT_FALSE(dst_server.InstallMigratedRows(*msg, &requests));
+  delete msg;
+  EXPECT_TRUE(requests.empty());
+  EXPECT_TRUE(dst_server.IsRowMigrating(kTableId, kRowId));
+  dst_server.InstallDeferredMigratedRows(&requests, &migration_versions);
+  EXPECT_TRUE(migration_versions.empty());
+
+  // Stashed, as the row is not installed yet.
+  ApplyOpLog(&dst_server, kBgId0, 1, 2);
+  dst_server.InstallDeferredMigratedRows(&requests, &migration_versions);
+  ASSERT_EQ(1u, migration_versions.size());
+  EXPECT_EQ(kMigrationVersion, migration_versions[0]);
+  ASSERT_EQ(1u, requests.size());
+  EXPECT_EQ(kBgId1, requests[0].bg_id);
+  EXPECT_FALSE(dst_server.IsRowMigrating(kTableId, kRowId));
+
+  // Replies carry version 1 of kBgId0, which the row includes.
+  EXPECT_EQ(1, dst_server.GetBgVersion(kBgId0));
+  EXPECT_EQ(3, GetColumn0(&dst_server));
+}
+
+}  // namespace petuum
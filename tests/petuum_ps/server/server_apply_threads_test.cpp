@@ -0,0 +1,113 @@
+// Copyright (c) 2014, Sailing Lab
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the <ORGANIZATION> nor the names of its contributors
+// may be used to endorse or promote products derived from this software
+// without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "petuum_ps/server/server_apply_threads.hpp"
+#include "petuum_ps/storage/dense_row.hpp"
+#include "petuum_ps/thread/context.hpp"
+#include "petuum_ps/util/class_register.hpp"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace petuum {
+
+namespace {
+
+const int32_t kNumApplyThreads = 4;
+const int32_t kNumRows = 100;
+const int32_t kRowCapacity = 8;
+
+void InitServerTableInfo(TableInfo *table_info) {
+  ClassRegistry<AbstractRow>::GetRegistry().AddCreator(0,
+    CreateObj<AbstractRow, DenseRow<int> >);
+  GlobalContext::SetNumServerApplyThreads(kNumApplyThreads);
+  table_info->table_staleness = 0;
+  table_info->row_type = 0;
+  table_info->row_capacity = kRowCapacity;
+}
+
+int GetColumn(ServerTable *server_table, int32_t row_id, int32_t column_id) {
+  ServerRow *server_row = server_table->FindRow(row_id);
+  EXPECT_TRUE(server_row != 0);
+  std::vector<uint8_t> bytes(server_row->SerializedSize());
+  size_t num_bytes = server_row->Serialize(bytes.data());
+  DenseRow<int> row;
+  row.Deserialize(bytes.data(), num_bytes);
+  return row[column_id];
+}
+
+}  // anonymous namespace
+
+TEST(ServerApplyThreadsTest, ShardsCoverAllThreads) {
+  TableInfo table_info;
+  InitServerTableInfo(&table_info);
+  ServerTable server_table(0, table_info);
+
+  std::vector<int32_t> num_rows_per_shard(kNumApplyThreads, 0);
+  // Rows of one server under ModuloPartition with 4 servers.
+  for (int32_t row_id = 0; row_id < 4*kNumRows; row_id += 4) {
+    int32_t shard_num = server_table.GetShardNum(row_id);
+    ASSERT_GE(shard_num, 0);
+    ASSERT_LT(shard_num, kNumApplyThreads);
+    ++num_rows_per_shard[shard_num];
+  }
+  for (int32_t i = 0; i < kNumApplyThreads; ++i) {
+    EXPECT_GT(num_rows_per_shard[i], 0);
+  }
+}
+
+TEST(ServerApplyThreadsTest, ApplyCreatesAndUpdatesRows) {
+  TableInfo table_info;
+  InitServerTableInfo(&table_info);
+  ServerTable server_table(0, table_info);
+  ServerApplyThreads apply_threads(kNumApplyThreads);
+  std::vector<std::vector<ServerRowOpLog> > slices(kNumApplyThreads);
+
+  const int32_t column_ids[] = {1, 3};
+  const int updates[] = {2, 5};
+  const int32_t num_msgs = 50;
+  for (int32_t i = 0; i < num_msgs; ++i) {
+    for (int32_t row_id = 0; row_id < kNumRows; ++row_id) {
+      ServerRowOpLog row_oplog = {&server_table, row_id, column_ids, updates,
+                                  2};
+      slices[server_table.GetShardNum(row_id)].push_back(row_oplog);
+    }
+    apply_threads.Apply(&slices);
+    for (int32_t j = 0; j < kNumApplyThreads; ++j) {
+      EXPECT_TRUE(slices[j].empty());
+    }
+  }
+
+  for (int32_t row_id = 0; row_id < kNumRows; ++row_id) {
+    EXPECT_EQ(0, GetColumn(&server_table, row_id, 0));
+    EXPECT_EQ(2*num_msgs, GetColumn(&server_table, row_id, 1));
+    EXPECT_EQ(5*num_msgs, GetColumn(&server_table, row_id, 3));
+  }
+}
+
+}  // namespace petuum
@@ -0,0 +1,111 @@
+// Copyright (c) 2014, Sailing Lab
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the <ORGANIZATION> nor the names of its contributors
+// may be used to endorse or promote products derived from this software
+// without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "petuum_ps/server/server_row_store.hpp"
+#include "petuum_ps/storage/dense_row.hpp"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace petuum {
+
+namespace {
+
+const int32_t kRowCapacity = 4;
+// Spans several slabs and index resizes.
+const int32_t kNumRows = 5000;
+
+ServerRow *InsertRow(ServerRowStore *store, int32_t row_id) {
+  AbstractRow *row_data = new DenseRow<int>();
+  row_data->Init(kRowCapacity);
+  return store->Insert(row_id, row_data);
+}
+
+}  // anonymous namespace
+
+TEST(ServerRowStoreTest, InsertFindErase) {
+  ServerRowStore store;
+  std::vector<ServerRow*> rows(kNumRows);
+  // Strided row ids, as a server gets under ModuloPartition.
+  for (int32_t i = 0; i < kNumRows; ++i) {
+    rows[i] = InsertRow(&store, i*8);
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumRows), store.size());
+  // Rows do not move when the store grows.
+  for (int32_t i = 0; i < kNumRows; ++i) {
+    EXPECT_EQ(rows[i], store.Find(i*8));
+    EXPECT_TRUE(store.Find(i*8 + 1) == 0);
+  }
+
+  for (int32_t i = 0; i < kNumRows; i += 2) {
+    store.Erase(i*8);
+  }
+  store.Erase(-1);
+  EXPECT_EQ(static_cast<size_t>(kNumRows/2), store.size());
+  for (int32_t i = 0; i < kNumRows; ++i) {
+    if (i % 2 == 0)
+      EXPECT_TRUE(store.Find(i*8) == 0);
+    else
+      EXPECT_EQ(rows[i], store.Find(i*8));
+  }
+
+  // Erased slots are reused.
+  for (int32_t i = 0; i < kNumRows; i += 2) {
+    rows[i] = InsertRow(&store, i*8);
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumRows), store.size());
+  for (int32_t i = 0; i < kNumRows; ++i) {
+    EXPECT_EQ(rows[i], store.Find(i*8));
+  }
+}
+
+TEST(ServerRowStoreTest, IterateSkipsErasedRows) {
+  ServerRowStore store;
+  EXPECT_TRUE(store.begin() == store.end());
+  for (int32_t row_id = 0; row_id < kNumRows; ++row_id) {
+    InsertRow(&store, row_id);
+  }
+  for (int32_t row_id = 0; row_id < kNumRows; row_id += 3) {
+    store.Erase(row_id);
+  }
+
+  std::vector<bool> visited(kNumRows, false);
+  size_t num_visited = 0;
+  for (auto row_iter = store.begin(); row_iter != store.end(); ++row_iter) {
+    int32_t row_id = row_iter.row_id();
+    ASSERT_NE(0, row_id % 3);
+    EXPECT_FALSE(visited[row_id]);
+    EXPECT_EQ(&row_iter.row(), store.Find(row_id));
+    visited[row_id] = true;
+    ++num_visited;
+  }
+  EXPECT_EQ(store.size(), num_visited);
+}
+
+}  // namespace petuum
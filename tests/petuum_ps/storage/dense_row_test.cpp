@@ -28,52 +28,192 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "petuum_ps/storage/dense_row.hpp"
-#include <boost/shared_array.hpp>
+#include "petuum_ps/util/vector_kernels.hpp"
 #include <gtest/gtest.h>
-
+#include <random>
+#include <vector>
 
 namespace petuum {
 
-TEST(DenseRowTest, Constructors) {
-  int num_cols = 100;
-  int init_iter = 10;
-  DenseRow<int> row(num_cols);
+namespace {
 
-  EXPECT_EQ(num_cols, row.get_num_columns());
-  EXPECT_EQ(0, row.get_iteration());
+// DenseRow sends runs of at least this many consecutive column ids to
+// AddArray() (DenseRow::kMinVectorRun).
+const int32_t kMinVectorRun = 8;
 
-  DenseRow<int> row2(num_cols, init_iter);
-  EXPECT_EQ(num_cols, row2.get_num_columns());
-  EXPECT_EQ(init_iter, row2.get_iteration());
-};
+// Apply the batch to row and, one update at a time, to expected_row, then
+// compare the two.
+template<typename V>
+void ExpectBatchIncMatchesScalar(const std::vector<int32_t> &column_ids,
+                                 int32_t capacity) {
+  std::vector<V> updates(column_ids.size());
+  for (size_t i = 0; i < updates.size(); ++i) {
+    updates[i] = V(i % 7) - V(3);
+  }
+  DenseRow<V> row;
+  row.Init(capacity);
+  row.ApplyBatchInc(column_ids.data(), updates.data(), column_ids.size());
+  DenseRow<V> unsafe_row;
+  unsafe_row.Init(capacity);
+  unsafe_row.ApplyBatchIncUnsafe(column_ids.data(), updates.data(),
+                                 column_ids.size());
+  DenseRow<V> expected_row;
+  expected_row.Init(capacity);
+  for (size_t i = 0; i < column_ids.size(); ++i) {
+    expected_row.ApplyInc(column_ids[i], &updates[i]);
+  }
+  for (int32_t col = 0; col < capacity; ++col) {
+    EXPECT_EQ(expected_row[col], row[col]) << "column " << col;
+    EXPECT_EQ(expected_row[col], unsafe_row[col]) << "column " << col;
+  }
+}
+
+// Compare AddArray() with the scalar loop for all lengths up to
+// max_num and both aligned and unaligned pointers, covering the tails of
+// the vector kernels.
+template<typename V>
+void ExpectAddArrayMatchesScalar(int32_t max_num) {
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<int32_t> dist(-1000, 1000);
+  for (int32_t offset = 0; offset < 2; ++offset) {
+    for (int32_t num = 0; num <= max_num; ++num) {
+      std::vector<V> dst(num + offset), src(num + offset);
+      for (int32_t i = 0; i < num + offset; ++i) {
+        dst[i] = V(dist(gen));
+        src[i] = V(dist(gen));
+      }
+      std::vector<V> expected(dst);
+      for (int32_t i = offset; i < num + offset; ++i) {
+        expected[i] += src[i];
+      }
+      AddArray(dst.data() + offset, src.data() + offset, num);
+      EXPECT_EQ(expected, dst) << "num = " << num << " offset = " << offset;
+    }
+  }
+}
 
-TEST(DenseRowTest, EntryAccessMutation) {
-  int num_cols = 100;
-  DenseRow<int> row(num_cols);
+}  // anonymous namespace
 
+TEST(DenseRowTest, InitAndInc) {
+  DenseRow<int> row;
+  row.Init(100);
+  EXPECT_EQ(100, row.get_capacity());
   EXPECT_EQ(0, row[3]);
-  row[3] = 5;
+  int update = 5;
+  row.ApplyInc(3, &update);
   EXPECT_EQ(5, row[3]);
-};
+}
 
 TEST(DenseRowTest, Serialization) {
-  int num_cols = 100;
-  DenseRow<int> row(num_cols);
-  row[0] = 1;
-  row[1] = 2;
-  row[2] = 3;
-  boost::shared_array<uint8_t> out_bytes;
-  int num_bytes = row.Serialize(out_bytes);
+  int32_t num_cols = 100;
+  DenseRow<int> row;
+  row.Init(num_cols);
+  for (int i = 0; i < 3; ++i) {
+    int update = i + 1;
+    row.ApplyInc(i, &update);
+  }
+  std::vector<uint8_t> bytes(row.SerializedSize());
+  size_t num_bytes = row.Serialize(bytes.data());
 
   DenseRow<int> recv_row;
-  recv_row.Deserialize(out_bytes, num_bytes);
-
-  EXPECT_EQ(row.get_num_columns(), recv_row.get_num_columns());
-  EXPECT_EQ(row[0], recv_row[0]);
-  EXPECT_EQ(row[1], recv_row[1]);
-  EXPECT_EQ(row[2], recv_row[2]);
-  for (int i = 3; i < num_cols; ++i) {
-    EXPECT_EQ(0, recv_row[i]);
+  EXPECT_TRUE(recv_row.Deserialize(bytes.data(), num_bytes));
+  EXPECT_EQ(num_cols, recv_row.get_capacity());
+  for (int i = 0; i < num_cols; ++i) {
+    EXPECT_EQ(row[i], recv_row[i]);
+  }
+}
+
+TEST(DenseRowTest, ContiguousRunLength) {
+  int32_t column_ids[] = {5, 6, 7, 9, 10, 10, 3, 4};
+  EXPECT_EQ(3, GetContiguousRunLength(column_ids, 8));
+  EXPECT_EQ(2, GetContiguousRunLength(column_ids, 2));
+  EXPECT_EQ(1, GetContiguousRunLength(column_ids, 1));
+  EXPECT_EQ(2, GetContiguousRunLength(column_ids + 3, 5));
+  // A repeated column id ends the run.
+  EXPECT_EQ(1, GetContiguousRunLength(column_ids + 5, 3));
+  EXPECT_EQ(2, GetContiguousRunLength(column_ids + 6, 2));
+
+  std::vector<int32_t> run(20);
+  for (int32_t i = 0; i < 20; ++i) {
+    run[i] = 40 + i;
+  }
+  EXPECT_EQ(20, GetContiguousRunLength(run.data(), 20));
+  EXPECT_EQ(12, GetContiguousRunLength(run.data() + 8, 12));
+  // Descending ids do not form a run.
+  std::vector<int32_t> descending(run.rbegin(), run.rend());
+  EXPECT_EQ(1, GetContiguousRunLength(descending.data(), 20));
+}
+
+TEST(DenseRowTest, AddArrayMatchesScalar) {
+  ExpectAddArrayMatchesScalar<float>(40);
+  ExpectAddArrayMatchesScalar<double>(40);
+  ExpectAddArrayMatchesScalar<int32_t>(40);
+  ExpectAddArrayMatchesScalar<int64_t>(40);
+}
+
+TEST(DenseRowTest, BatchIncMatchesScalar) {
+  const int32_t kCapacity = 128;
+  std::vector<std::vector<int32_t> > batches;
+  // One run covering the row.
+  batches.emplace_back();
+  for (int32_t i = 0; i < kCapacity; ++i) {
+    batches.back().push_back(i);
+  }
+  // Runs just below, at and above the AddArray() threshold, and a run
+  // cut short by the end of the batch.
+  batches.emplace_back();
+  for (int32_t len : {kMinVectorRun - 1, kMinVectorRun, kMinVectorRun + 1,
+                      kMinVectorRun * 3 + 5}) {
+    int32_t start = batches.back().empty() ? 0 : batches.back().back() + 2;
+    for (int32_t i = 0; i < len; ++i) {
+      batches.back().push_back(start + i);
+    }
+  }
+  // Non-contiguous and repeated column ids, and runs that restart at a
+  // lower column.
+  batches.push_back({3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 5, 0, 0, 127});
+  batches.emplace_back();
+  for (int32_t rep = 0; rep < 3; ++rep) {
+    for (int32_t i = 0; i < kMinVectorRun + rep; ++i) {
+      batches.back().push_back(10 + i);
+    }
+  }
+  // Random ids with occasional long runs.
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<int32_t> col_dist(0, kCapacity - 1);
+  batches.emplace_back();
+  while (batches.back().size() < 200) {
+    int32_t start = col_dist(gen);
+    int32_t len = std::min(kCapacity - start, col_dist(gen) % 20 + 1);
+    for (int32_t i = 0; i < len; ++i) {
+      batches.back().push_back(start + i);
+    }
+  }
+
+  for (const auto &column_ids : batches) {
+    ExpectBatchIncMatchesScalar<float>(column_ids, kCapacity);
+    ExpectBatchIncMatchesScalar<double>(column_ids, kCapacity);
+    ExpectBatchIncMatchesScalar<int32_t>(column_ids, kCapacity);
+  }
+}
+
+TEST(DenseRowTest, DenseBatchIncMatchesScalar) {
+  for (int32_t num_updates : {0, 1, kMinVectorRun - 1, 33, 64}) {
+    std::vector<float> updates(num_updates);
+    for (int32_t i = 0; i < num_updates; ++i) {
+      updates[i] = 0.5f * i - 3;
+    }
+    DenseRow<float> row;
+    row.Init(64);
+    row.ApplyDenseBatchInc(updates.data(), num_updates);
+    DenseRow<float> unsafe_row;
+    unsafe_row.Init(64);
+    unsafe_row.ApplyDenseBatchIncUnsafe(updates.data(), num_updates);
+    for (int32_t col = 0; col < 64; ++col) {
+      float expected = (col < num_updates) ? updates[col] : 0;
+      EXPECT_EQ(expected, row[col]);
+      EXPECT_EQ(expected, unsafe_row[col]);
+    }
   }
 }
 
@@ -0,0 +1,142 @@
+// Copyright (c) 2014, Sailing Lab
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the <ORGANIZATION> nor the names of its contributors
+// may be used to endorse or promote products derived from this software
+// without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "petuum_ps/storage/flat_sparse_row.hpp"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace petuum {
+
+namespace {
+
+void IncEntry(FlatSparseRow<int>* row, int32_t col_id, int update) {
+  row->ApplyInc(col_id, reinterpret_cast<void*>(&update));
+}
+
+}  // anonymous namespace
+
+TEST(FlatSparseRowTest, Constructors) {
+  FlatSparseRow<int> row;
+  EXPECT_EQ(0, row.num_entries());
+
+  // Reading shouldn't add non-zeros.
+  int unused = row[5];
+  EXPECT_EQ(0, unused);
+  EXPECT_EQ(0, row.num_entries());
+
+  IncEntry(&row, 5, 3);
+  EXPECT_EQ(1, row.num_entries());
+  EXPECT_EQ(3, row[5]);
+
+  // Cancelling an entry removes it.
+  IncEntry(&row, 5, -3);
+  EXPECT_EQ(0, row.num_entries());
+}
+
+TEST(FlatSparseRowTest, Iterator) {
+  FlatSparseRow<int> row;
+  for (int i = 99; i >= 0; --i) {
+    IncEntry(&row, i, i * 10 + 1);
+  }
+
+  int prev_key = -1;
+  int num_entries = 0;
+  for (FlatSparseRow<int>::const_iterator it = row.cbegin();
+      !it.is_end(); ++it) {
+    int key = it->first;
+    EXPECT_LT(prev_key, key);
+    EXPECT_EQ(key * 10 + 1, it->second);
+    EXPECT_EQ(key * 10 + 1, *it);
+    prev_key = key;
+    ++num_entries;
+  }
+  EXPECT_EQ(100, num_entries);
+}
+
+TEST(FlatSparseRowTest, Serialization) {
+  FlatSparseRow<double> row;
+  for (int i = 0; i < 3; ++i) {
+    double update = i + 0.5;
+    row.ApplyInc(i * 7, &update);
+  }
+  std::vector<uint8_t> out_bytes(row.SerializedSize());
+  int num_bytes = row.Serialize(out_bytes.data());
+
+  FlatSparseRow<double> recv_row;
+  recv_row.Deserialize(out_bytes.data(), num_bytes);
+
+  EXPECT_EQ(row.num_entries(), recv_row.num_entries());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(row[i], recv_row[i]);
+  }
+}
+
+TEST(FlatSparseRowTest, SerializeEmpty) {
+  // Init() allocates nothing for the columns of a huge row.
+  FlatSparseRow<double> row;
+  row.Init(1 << 30);
+  EXPECT_EQ(0u, row.SerializedSize());
+  EXPECT_EQ(0u, row.Serialize(0));
+
+  FlatSparseRow<double> recv_row;
+  double update = 1;
+  recv_row.ApplyInc(3, &update);
+  EXPECT_TRUE(recv_row.Deserialize(0, 0));
+  EXPECT_EQ(0, recv_row.num_entries());
+}
+
+TEST(FlatSparseRowTest, BatchInc) {
+  FlatSparseRow<int> row;
+  for (int i = 0; i < 20; i += 2) {
+    IncEntry(&row, i, 1);
+  }
+
+  // Sorted batch, merged in one pass; column 4 is cancelled.
+  std::vector<int32_t> col_ids = {1, 2, 3, 4, 5, 30};
+  std::vector<int> updates = {1, 2, 3, -1, 5, 6};
+  row.ApplyBatchInc(col_ids.data(), updates.data(), col_ids.size());
+  EXPECT_EQ(1, row[1]);
+  EXPECT_EQ(3, row[2]);
+  EXPECT_EQ(0, row[4]);
+  EXPECT_EQ(6, row[30]);
+  EXPECT_EQ(10 - 1 + 4, row.num_entries());
+
+  // Unsorted batch with duplicate column ids.
+  col_ids = {30, 7, 1, 30, 6, 9};
+  updates = {-2, 7, -1, -4, 2, 9};
+  row.ApplyBatchInc(col_ids.data(), updates.data(), col_ids.size());
+  EXPECT_EQ(0, row[1]);
+  EXPECT_EQ(3, row[6]);
+  EXPECT_EQ(7, row[7]);
+  EXPECT_EQ(9, row[9]);
+  EXPECT_EQ(0, row[30]);
+  EXPECT_EQ(13 - 2 + 2, row.num_entries());
+}
+
+}   // namespace petuum
@@ -0,0 +1,196 @@
+// Copyright (c) 2014, Sailing Lab
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the <ORGANIZATION> nor the names of its contributors
+// may be used to endorse or promote products derived from this software
+// without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "petuum_ps/storage/hybrid_count_row.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace petuum {
+
+namespace {
+
+void IncEntry(HybridCountRow<int>* row, int32_t col_id, int update) {
+  row->ApplyInc(col_id, reinterpret_cast<void*>(&update));
+}
+
+}  // anonymous namespace
+
+TEST(HybridCountRowTest, SparseToDenseAndBack) {
+  HybridCountRow<int> row;
+  row.Init(64);
+  EXPECT_FALSE(row.is_dense());
+
+  // 64 / 8 = 8 entries still fit the sparse form.
+  for (int i = 0; i < 8; ++i) {
+    IncEntry(&row, i * 2, i + 1);
+  }
+  EXPECT_FALSE(row.is_dense());
+  IncEntry(&row, 63, 1);
+  EXPECT_TRUE(row.is_dense());
+  EXPECT_EQ(9, row.num_entries());
+  EXPECT_EQ(5, row[8]);
+  EXPECT_EQ(0, row[9]);
+
+  // Back to sparse below 64 / 16 = 4 entries.
+  for (int i = 0; i < 6; ++i) {
+    IncEntry(&row, i * 2, -(i + 1));
+  }
+  EXPECT_FALSE(row.is_dense());
+  EXPECT_EQ(3, row.num_entries());
+  EXPECT_EQ(7, row[12]);
+  EXPECT_EQ(8, row[14]);
+  EXPECT_EQ(1, row[63]);
+  EXPECT_EQ(0, row[0]);
+}
+
+TEST(HybridCountRowTest, IterateByDescendingCount) {
+  HybridCountRow<int> row;
+  row.Init(16);
+  IncEntry(&row, 3, 2);
+  IncEntry(&row, 7, 9);
+  IncEntry(&row, 1, 5);
+  IncEntry(&row, 10, 1);  // dense from here.
+  EXPECT_TRUE(row.is_dense());
+
+  std::vector<int> expected_cols = {7, 1, 3, 10};
+  std::vector<int> expected_counts = {9, 5, 2, 1};
+  int i = 0;
+  for (HybridCountRow<int>::const_iterator it = row.cbegin();
+      !it.is_end(); ++it) {
+    EXPECT_EQ(expected_cols[i], it->first);
+    EXPECT_EQ(expected_counts[i], it->second);
+    ++i;
+  }
+  EXPECT_EQ(4, i);
+
+  // Increments move the entries they change.
+  int32_t col_ids[] = {3, 7};
+  int updates[] = {10, -9};
+  row.ApplyBatchInc(col_ids, updates, 2);
+  HybridCountRow<int>::const_iterator it = row.cbegin();
+  EXPECT_EQ(3, it->first);
+  EXPECT_EQ(12, *it);
+  ++it;
+  EXPECT_EQ(1, it->first);
+  ++it;
+  EXPECT_EQ(10, it->first);
+  ++it;
+  EXPECT_TRUE(it.is_end());
+}
+
+// Checks that row iterates its entries in descending order of count with
+// the counts of row[].
+void ExpectSortedByCount(const HybridCountRow<int> &row) {
+  int num_iterated = 0;
+  int prev_count = 0;
+  for (HybridCountRow<int>::const_iterator it = row.cbegin();
+      !it.is_end(); ++it) {
+    EXPECT_NE(0, it->second);
+    EXPECT_EQ(row[it->first], it->second);
+    if (num_iterated > 0) {
+      EXPECT_GE(prev_count, it->second);
+    }
+    prev_count = it->second;
+    ++num_iterated;
+  }
+  EXPECT_EQ(row.num_entries(), num_iterated);
+}
+
+TEST(HybridCountRowTest, IncrementsKeepSortedOrder) {
+  // Sampler-like +/-1 moves of counts between columns, sorting once and
+  // then only checking the order that the increments maintain.
+  const int32_t kCapacity = 64;
+  HybridCountRow<int> row;
+  row.Init(kCapacity);
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<int32_t> col_dist(0, kCapacity - 1);
+  std::vector<int> counts(kCapacity, 0);
+  for (int i = 0; i < 4; ++i) {
+    IncEntry(&row, i, 3);
+    counts[i] = 3;
+  }
+  ExpectSortedByCount(row);
+
+  bool was_dense = false;
+  bool was_sparse_again = false;
+  for (int iter = 0; iter < 5000; ++iter) {
+    // Shrink back toward the sparse form in the second half.
+    int32_t from_col = col_dist(gen);
+    if (counts[from_col] == 0)
+      continue;
+    int32_t to_col = (iter < 2500) ? col_dist(gen) : col_dist(gen) % 4;
+    int32_t col_ids[] = {from_col, to_col};
+    int updates[] = {-1, 1};
+    row.ApplyBatchInc(col_ids, updates, 2);
+    --counts[from_col];
+    ++counts[to_col];
+    was_dense = was_dense || row.is_dense();
+    was_sparse_again = was_sparse_again || (was_dense && !row.is_dense());
+    if (iter % 97 == 0)
+      ExpectSortedByCount(row);
+  }
+  EXPECT_TRUE(was_dense);
+  EXPECT_TRUE(was_sparse_again);
+  ExpectSortedByCount(row);
+  for (int32_t i = 0; i < kCapacity; ++i) {
+    EXPECT_EQ(counts[i], row[i]);
+  }
+}
+
+TEST(HybridCountRowTest, SerializeDeserialize) {
+  HybridCountRow<int> row;
+  row.Init(16);
+  for (int i = 0; i < 10; ++i) {
+    IncEntry(&row, i, i + 1);
+  }
+  EXPECT_TRUE(row.is_dense());
+
+  std::vector<uint8_t> buf(row.SerializedSize());
+  EXPECT_EQ(buf.size(), row.Serialize(buf.data()));
+
+  // Capacity travels with the row, so no Init() on the receiving side.
+  HybridCountRow<int> row2;
+  EXPECT_TRUE(row2.Deserialize(buf.data(), buf.size()));
+  EXPECT_TRUE(row2.is_dense());
+  EXPECT_EQ(10, row2.num_entries());
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_EQ(row[i], row2[i]);
+  }
+
+  HybridCountRow<int> empty_row;
+  std::vector<uint8_t> buf2(empty_row.SerializedSize());
+  empty_row.Serialize(buf2.data());
+  HybridCountRow<int> row3;
+  EXPECT_TRUE(row3.Deserialize(buf2.data(), buf2.size()));
+  EXPECT_EQ(0, row3.num_entries());
+  EXPECT_FALSE(row3.is_dense());
+}
+
+}  // namespace petuum
@@ -30,10 +30,13 @@
 // Date: 2014.02.01
 
 #include "petuum_ps/storage/process_storage.hpp"
-#include "petuum_ps/storage/sparse_row.hpp"
-#include "petuum_ps/storage/client_row.hpp"
+#include "petuum_ps/storage/dense_row.hpp"
+#include "petuum_ps/client/client_row.hpp"
+#include "petuum_ps/util/epoch_manager.hpp"
 #include <gtest/gtest.h>
 #include <glog/logging.h>
+#include <unistd.h>
+#include <atomic>
 #include <thread>
 #include <vector>
 #include <random>
@@ -42,12 +45,14 @@
 
 namespace petuum {
 
-typedef SparseRow<int> SparseRowInt;
+typedef DenseRow<int> DenseRowInt;
 
 namespace {
 
-void UpdateEntry(SparseRowInt* row, int32_t col_id, int update) {
-  row->ApplyUpdate(col_id, reinterpret_cast<void*>(&update));
+const int32_t kRowCapacity = 12;
+
+void UpdateEntry(DenseRowInt* row, int32_t col_id, int update) {
+  row->ApplyInc(col_id, &update);
 }
 
 }  // anonymous namespace
@@ -59,15 +64,16 @@ TEST(ProcessStorageTest, SmokeTest) {
   RowAccessor acc;
   EXPECT_FALSE(storage.Find(0, &acc));
 
-  SparseRowInt* row = new SparseRowInt;
+  DenseRowInt* row = new DenseRowInt;
+  row->Init(kRowCapacity);
   UpdateEntry(row, 2, 100);
   UpdateEntry(row, 5, 101);
   UpdateEntry(row, 11, 102);
 
-  ClientRow* client_row = new ClientRow(row);
+  ClientRow* client_row = new ClientRow(0, row);
   int row_id = 1;
   storage.Insert(row_id, client_row, &acc);
-  const SparseRowInt& row_ref = acc.Get<SparseRowInt>();
+  const DenseRowInt& row_ref = acc.Get<DenseRowInt>();
   EXPECT_EQ(100, row_ref[2]);
   EXPECT_EQ(101, row_ref[5]);
   EXPECT_EQ(102, row_ref[11]);
@@ -77,16 +83,48 @@ TEST(ProcessStorageTest, SmokeTest) {
 
 // Just create the same row.
 ClientRow* CreateClientRow() {
-  SparseRowInt* row = new SparseRowInt;
+  DenseRowInt* row = new DenseRowInt;
+  row->Init(kRowCapacity);
   UpdateEntry(row, 2, 100);
   UpdateEntry(row, 5, 101);
   UpdateEntry(row, 11, 102);
-  ClientRow* client_row = new ClientRow(row);
+  ClientRow* client_row = new ClientRow(0, row);
   return client_row;
 }
 
 namespace {
 
+int num_deleted = 0;
+
+struct Tracked {
+  ~Tracked() {
+    ++num_deleted;
+  }
+};
+
+}  // anonymous namespace
+
+// A RowAccessor reused for another row must leave the epoch of the row it
+// held, or objects retired meanwhile are never reclaimed.
+TEST(ProcessStorageTest, ReusedAccessorLeavesOldEpoch) {
+  ProcessStorage storage(10);
+  RowAccessor acc;
+  storage.Insert(0, CreateClientRow(), &acc);
+  storage.Insert(1, CreateClientRow(), &acc);
+
+  num_deleted = 0;
+  EXPECT_TRUE(storage.Find(0, &acc));
+  EpochManager::Retire(new Tracked);
+  EpochManager::Reclaim();
+  EXPECT_EQ(0, num_deleted);
+
+  EXPECT_TRUE(storage.Find(1, &acc));
+  EpochManager::Reclaim();
+  EXPECT_EQ(1, num_deleted);
+}
+
+namespace {
+
 std::atomic<int> seq_number;
 
 int kNumIter = 1e4;
@@ -33,6 +33,34 @@ $(TESTS_BIN)/sparse_row_test: $(STORAGE_TESTS_DIR)/sparse_row_test.cpp \
 sparse_row_test_run: $(TESTS_BIN)/sparse_row_test
 	env HEAPCHECK=normal GLOG_v=3 GLOG_logtostderr=true $<
 
+$(TESTS_BIN)/flat_sparse_row_test: $(STORAGE_TESTS_DIR)/flat_sparse_row_test.cpp \
+	$(SRC)/petuum_ps/storage/flat_sparse_row.hpp \
+	$(SRC)/petuum_ps/util/lock.o $(SRC)/petuum_ps/util/lock.cpp
+	$(CXX) $(CXXFLAGS) $(INCFLAGS) $< $(SRC)/petuum_ps/util/lock.o \
+		$(TESTS_LDFLAGS)  -o $@
+
+flat_sparse_row_test_run: $(TESTS_BIN)/flat_sparse_row_test
+	env HEAPCHECK=normal GLOG_v=3 GLOG_logtostderr=true $<
+
+$(TESTS_BIN)/hybrid_count_row_test: $(STORAGE_TESTS_DIR)/hybrid_count_row_test.cpp \
+	$(SRC)/petuum_ps/storage/hybrid_count_row.hpp \
+	$(SRC)/petuum_ps/util/lock.o $(SRC)/petuum_ps/util/lock.cpp
+	$(CXX) $(CXXFLAGS) $(INCFLAGS) $< $(SRC)/petuum_ps/util/lock.o \
+		$(TESTS_LDFLAGS)  -o $@
+
+hybrid_count_row_test_run: $(TESTS_BIN)/hybrid_count_row_test
+	env HEAPCHECK=normal GLOG_v=3 GLOG_logtostderr=true $<
+
+$(TESTS_BIN)/dense_row_test: $(STORAGE_TESTS_DIR)/dense_row_test.cpp \
+	$(SRC)/petuum_ps/storage/dense_row.hpp \
+	$(SRC)/petuum_ps/util/vector_kernels.o \
+	$(SRC)/petuum_ps/util/lock.o $(SRC)/petuum_ps/util/lock.cpp
+	$(CXX) $(CXXFLAGS) $(INCFLAGS) $< $(SRC)/petuum_ps/util/lock.o \
+		$(SRC)/petuum_ps/util/vector_kernels.o $(TESTS_LDFLAGS) -o $@
+
+dense_row_test_run: $(TESTS_BIN)/dense_row_test
+	env HEAPCHECK=normal GLOG_v=3 GLOG_logtostderr=true $<
+
 $(TESTS_BIN)/sorted_vector_map_row_test: \
 	$(STORAGE_TESTS_DIR)/sorted_vector_map_row_test.cpp \
 	$(SRC)/petuum_ps/storage/sorted_vector_map_row.hpp \
@@ -46,17 +74,20 @@ sorted_vector_map_row_test_run: $(TESTS_BIN)/sorted_vector_map_row_test
 $(TESTS_BIN)/process_storage_test: $(STORAGE_TESTS_DIR)/process_storage_test.cpp \
 	$(SRC)/petuum_ps/storage/process_storage.o \
 	$(SRC)/petuum_ps/storage/clock_lru.o \
-	$(SRC)/petuum_ps/storage/sparse_row.hpp \
+	$(SRC)/petuum_ps/storage/dense_row.hpp \
 	$(SRC)/petuum_ps/include/row_access.hpp \
-	$(SRC)/petuum_ps/storage/client_row.o \
+	$(SRC)/petuum_ps/client/client_row.hpp \
 	$(SRC)/petuum_ps/thread/context.o \
+	$(SRC)/petuum_ps/util/epoch_manager.o \
+	$(SRC)/petuum_ps/util/vector_kernels.o \
 	$(SRC)/petuum_ps/util/lock.o \
 	$(SRC)/petuum_ps/util/striped_lock.hpp
 	$(CXX) $(CXXFLAGS) $(INCFLAGS) \
 		$(SRC)/petuum_ps/storage/process_storage.o \
-		$(SRC)/petuum_ps/storage/client_row.o \
 		$(SRC)/petuum_ps/storage/clock_lru.o \
 		$(SRC)/petuum_ps/thread/context.o \
+		$(SRC)/petuum_ps/util/epoch_manager.o \
+		$(SRC)/petuum_ps/util/vector_kernels.o \
 		$(SRC)/petuum_ps/util/lock.o \
 		$< $(TESTS_LDFLAGS) -o $@
 
@@ -88,13 +119,6 @@ process_storage_test_run: $(TESTS_BIN)/process_storage_test
 #	GLOG_v=0 GLOG_logtostderr=false \
 #	LD_LIBRARY_PATH=$(THIRD_PARTY_INSTALLED)/lib $(TESTS_BIN)/$<
 #
-#dense_row_test: $(STORAGE_TESTS_DIR)/dense_row_test.cpp
-#	$(CXX) $(INCFLAGS) $(CXXFLAGS) $^ -lgtest_main $(PETUUM_LIB) \
-#		-o $(TESTS_BIN)/$@
-#
-#dense_row_test_run: dense_row_test
-#	LD_LIBRARY_PATH=$(THIRD_PARTY_INSTALLED)/lib $(TESTS_BIN)/$<
-#
 #sparse_row_test: $(STORAGE_TESTS_DIR)/sparse_row_test.cpp
 #	$(CXX) $(INCFLAGS) $(CPPFLAGS_TESTS) $^ -lgtest_main $(PETUUM_LIB) \
 #		-o $(TESTS_BIN)/$@
@@ -0,0 +1,108 @@
+// Copyright (c) 2014, Sailing Lab
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the <ORGANIZATION> nor the names of its contributors
+// may be used to endorse or promote products derived from this software
+// without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "petuum_ps/thread/app_request_ring.hpp"
+#include "petuum_ps/thread/completion_slot.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace petuum {
+
+TEST(AppRequestRingTest, OnlyFirstAnnouncedRequestWakesUp) {
+  AppRequestRing ring(4);
+  AppRequest request;
+  request.row_id = 1;
+  EXPECT_TRUE(ring.Push(request));
+  request.row_id = 2;
+  EXPECT_FALSE(ring.Push(request));
+  ASSERT_EQ(2, ring.get_num_announced());
+
+  ring.Pop(&request);
+  EXPECT_EQ(1, request.row_id);
+  ring.Pop(&request);
+  EXPECT_EQ(2, request.row_id);
+  EXPECT_EQ(0, ring.Consumed(2));
+
+  request.row_id = 3;
+  EXPECT_TRUE(ring.Push(request));
+}
+
+TEST(AppRequestRingTest, KeepsOrderOfEachAppThread) {
+  const int32_t kNumThreads = 4;
+  const int32_t kNumRequests = 10000;
+  // Smaller than the number of requests so that app threads wait for space.
+  AppRequestRing ring(64);
+  std::vector<std::thread> threads;
+  for (int32_t t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&ring, t]() {
+        for (int32_t i = 0; i < kNumRequests; ++i) {
+          AppRequest request;
+          request.app_thread_id = t;
+          request.row_id = i;
+          ring.Push(request);
+        }
+      });
+  }
+
+  std::vector<int32_t> next_row_ids(kNumThreads, 0);
+  int32_t num_popped = 0;
+  while (num_popped < kNumThreads*kNumRequests) {
+    int64_t num_announced = ring.get_num_announced();
+    for (int64_t i = 0; i < num_announced; ++i) {
+      AppRequest request;
+      ring.Pop(&request);
+      ASSERT_EQ(next_row_ids[request.app_thread_id], request.row_id);
+      ++next_row_ids[request.app_thread_id];
+    }
+    ring.Consumed(num_announced);
+    num_popped += num_announced;
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, ring.get_num_announced());
+}
+
+TEST(CompletionSlotTest, CountsReplies) {
+  CompletionSlot slot;
+  std::thread replier([&slot]() {
+      for (int32_t i = 0; i < 3; ++i) {
+        slot.Post();
+      }
+    });
+  for (int32_t i = 0; i < 3; ++i) {
+    slot.Wait();
+  }
+  replier.join();
+}
+
+}  // namespace petuum
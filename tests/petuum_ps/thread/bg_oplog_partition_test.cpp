@@ -0,0 +1,133 @@
+// Copyright (c) 2014, Sailing Lab
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the <ORGANIZATION> nor the names of its contributors
+// may be used to endorse or promote products derived from this software
+// without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "petuum_ps/thread/bg_oplog_partition.hpp"
+#include "petuum_ps/oplog/oplog.hpp"
+#include "petuum_ps/oplog/oplog_index.hpp"
+#include "petuum_ps/storage/dense_row.hpp"
+#include "petuum_ps/thread/context.hpp"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <map>
+#include <vector>
+
+namespace petuum {
+
+namespace {
+
+const int32_t kTableID = 0;
+const int32_t kServerID = 1;
+const int32_t kNumRows = 16;
+const int32_t kRowCapacity = 4;
+
+void InitContext(UpdatePrecision precision) {
+  std::vector<int32_t> server_ids(1, kServerID);
+  GlobalContext::Init(1, 1, 1, 1, 1, 1, 1, 1, server_ids,
+    std::map<int32_t, HostInfo>(), 0, 1, SSP, false);
+  TableInfo table_info;
+  table_info.update_precision = precision;
+  GlobalContext::SetTableMsgFormat(kTableID, table_info);
+}
+
+// Serialize the indexed rows of table_oplog like a bg thread at a clock and
+// add the updates the server receives to received.
+void Flush(TableOpLog *table_oplog, TableOpLogIndex *oplog_index,
+  const RowRoutingTable &routing_table, std::vector<float> *received,
+  std::vector<int32_t> *flushed_row_ids) {
+  BgOpLogPartition partition(kTableID, sizeof(float));
+  oplog_index->ResetPartition(0, flushed_row_ids);
+  size_t size = sizeof(int32_t);
+  for (auto iter = flushed_row_ids->cbegin();
+       iter != flushed_row_ids->cend(); iter++) {
+    RowOpLog *row_oplog = 0;
+    ASSERT_TRUE(table_oplog->GetEraseOpLog(*iter, &row_oplog));
+    size += partition.GetMaxSerializedRowOpLogSize(row_oplog->GetSize());
+    partition.InsertOpLog(*iter, row_oplog);
+  }
+
+  std::vector<uint8_t> bytes(size);
+  std::map<int32_t, void*> bytes_by_server;
+  bytes_by_server[kServerID] = bytes.data();
+  std::map<int32_t, size_t> size_by_server;
+  std::vector<int32_t> residual_row_ids;
+  partition.SerializeByServer(&bytes_by_server, routing_table,
+    &size_by_server, table_oplog, &residual_row_ids);
+  oplog_index->AddIndex(0, residual_row_ids);
+
+  // Serialized row oplogs hold what the server receives.
+  for (auto iter = flushed_row_ids->cbegin();
+       iter != flushed_row_ids->cend(); iter++) {
+    RowOpLog *row_oplog = partition.FindOpLog(*iter);
+    int32_t column_id;
+    void *update = row_oplog->BeginIterate(&column_id);
+    while (update != 0) {
+      (*received)[column_id] += *reinterpret_cast<float*>(update);
+      update = row_oplog->Next(&column_id);
+    }
+  }
+}
+
+}  // anonymous namespace
+
+TEST(BgOpLogPartitionTest, ResidualsAreSentWithoutNewUpdates) {
+  InitContext(Int8Precision);
+  DenseRow<float> sample_row;
+  TableOpLog table_oplog(kTableID, kNumRows, &sample_row, kRowCapacity);
+  TableOpLogIndex oplog_index(kNumRows, kNumRows);
+  RowRoutingTable routing_table;
+
+  const int32_t kRowID = 3;
+  int32_t column_ids[kRowCapacity] = {0, 1, 2, 3};
+  float updates[kRowCapacity] = {1, 0.3, 0.001, -0.7};
+  table_oplog.BatchInc(kRowID, column_ids, updates, kRowCapacity);
+  oplog_index.AddIndex(0, std::vector<int32_t>(1, kRowID));
+
+  std::vector<float> received(kRowCapacity, 0);
+  std::vector<int32_t> flushed_row_ids;
+  Flush(&table_oplog, &oplog_index, routing_table, &received,
+    &flushed_row_ids);
+  ASSERT_EQ(1u, flushed_row_ids.size());
+  EXPECT_GT(std::abs(received[2] - updates[2]), 1e-6);
+
+  // No further updates: the row is sent again for its residuals only.
+  for (int32_t i = 0; i < 4; ++i) {
+    Flush(&table_oplog, &oplog_index, routing_table, &received,
+      &flushed_row_ids);
+    if (i == 0) {
+      ASSERT_EQ(1u, flushed_row_ids.size());
+      EXPECT_EQ(kRowID, flushed_row_ids[0]);
+    }
+  }
+  for (int32_t i = 0; i < kRowCapacity; ++i) {
+    EXPECT_NEAR(updates[i], received[i], 1e-6) << "column " << i;
+  }
+}
+
+}  // namespace petuum
@@ -0,0 +1,235 @@
+// Copyright (c) 2014, Sailing Lab
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the <ORGANIZATION> nor the names of its contributors
+// may be used to endorse or promote products derived from this software
+// without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "petuum_ps/thread/msg_codec.hpp"
+#include "petuum_ps/oplog/serialized_oplog_reader.hpp"
+#include "petuum_ps/thread/context.hpp"
+#include "petuum_ps/thread/update_quantizer.hpp"
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace petuum {
+
+namespace {
+
+// Encode bytes as a pushed row and check that it decodes to the same bytes.
+size_t RowRoundTrip(const std::vector<uint8_t> &row) {
+  std::vector<uint8_t> encoded(MsgCompressor::GetMaxEncodedRowSize(
+      row.size()));
+  size_t encoded_size = MsgCompressor::EncodeRow(row.data(), row.size(),
+    encoded.data());
+  EXPECT_LE(encoded_size, encoded.size());
+  EXPECT_EQ(row.size(), MsgCompressor::GetDecodedRowSize(encoded.data()));
+  std::vector<uint8_t> decoded(row.size());
+  MsgCompressor::DecodeRow(encoded.data(), decoded.data());
+  EXPECT_TRUE(decoded == row);
+  return encoded_size;
+}
+
+}  // anonymous namespace
+
+TEST(MsgCodecTest, RowRoundTrip) {
+  EXPECT_EQ(1u, RowRoundTrip(std::vector<uint8_t>()));
+
+  // Mostly zero, e.g. a dense row of small counts.
+  std::vector<int32_t> counts(1000, 0);
+  counts[3] = 7;
+  counts[500] = -1;
+  counts[999] = 1;
+  std::vector<uint8_t> row(reinterpret_cast<uint8_t*>(counts.data()),
+    reinterpret_cast<uint8_t*>(counts.data() + counts.size()));
+  EXPECT_LT(RowRoundTrip(row), row.size()/100);
+
+  // Worst cases for the zero runs stay within the bound.
+  srand(0);
+  for (size_t pattern = 0; pattern < 8; ++pattern) {
+    for (size_t i = 0; i < row.size(); ++i) {
+      if (pattern == 0)
+        row[i] = rand() % 256;
+      else
+        row[i] = (i % (pattern + 1) == 0) ? 1 : 0;
+    }
+    RowRoundTrip(row);
+  }
+}
+
+TEST(MsgCodecTest, RowOpLogRoundTrip) {
+  const int32_t column_ids[] = {5, 6, 7, 1000, 2, -3};
+  const float updates[] = {1.5, 0, 0, 0, -2, 3};
+  const int32_t num_updates = 6;
+  std::vector<uint8_t> mem(MsgCompressor::GetMaxEncodedRowOpLogSize(
+      num_updates, num_updates*sizeof(float)));
+  size_t size = MsgCompressor::EncodeRowOpLog(100, 42, column_ids,
+    num_updates, updates, num_updates*sizeof(float), mem.data());
+  EXPECT_LE(size, mem.size());
+  EXPECT_LT(size, 2*sizeof(int32_t) + num_updates*(sizeof(int32_t)
+                                                   + sizeof(float)));
+
+  int32_t row_id, decoded_num_updates;
+  const void *ptr = MsgCompressor::DecodeRowOpLogHeader(mem.data(), 100,
+    &row_id, &decoded_num_updates);
+  EXPECT_EQ(42, row_id);
+  ASSERT_EQ(num_updates, decoded_num_updates);
+  int32_t decoded_column_ids[num_updates];
+  float decoded_updates[num_updates];
+  ptr = MsgCompressor::DecodeRowOpLogUpdates(ptr, num_updates,
+    num_updates*sizeof(float), decoded_column_ids, decoded_updates);
+  EXPECT_EQ(mem.data() + size, ptr);
+  for (int32_t i = 0; i < num_updates; ++i) {
+    EXPECT_EQ(column_ids[i], decoded_column_ids[i]);
+    EXPECT_EQ(updates[i], decoded_updates[i]);
+  }
+}
+
+TEST(MsgCodecTest, SerializedOpLogReaderDecodes) {
+  const int32_t kRawTableId = 0;
+  const int32_t kCompactTableId = 1;
+  TableInfo table_info;
+  table_info.msg_codec = CompactCodec;
+  GlobalContext::SetTableMsgFormat(kCompactTableId, table_info);
+
+  const int32_t row_ids[] = {7, 3, 1 << 30};
+  const int32_t column_ids[] = {0, 2};
+  const int updates[] = {4, 9};
+
+  std::vector<uint8_t> mem(1024);
+  std::map<int32_t, size_t> table_size_map;
+  table_size_map[kRawTableId] = sizeof(int32_t);
+  table_size_map[kCompactTableId] = 512;
+  OpLogSerializer serializer;
+  serializer.Init(table_size_map);
+  serializer.AssignMem(mem.data());
+
+  // An empty raw table.
+  uint8_t *table_ptr
+      = reinterpret_cast<uint8_t*>(serializer.GetTablePtr(kRawTableId));
+  *reinterpret_cast<int32_t*>(table_ptr) = kRawTableId;
+  *reinterpret_cast<size_t*>(table_ptr + sizeof(int32_t)) = sizeof(int);
+  *reinterpret_cast<int32_t*>(table_ptr + sizeof(int32_t) + sizeof(size_t))
+      = 0;
+
+  table_ptr
+      = reinterpret_cast<uint8_t*>(serializer.GetTablePtr(kCompactTableId));
+  *reinterpret_cast<int32_t*>(table_ptr) = kCompactTableId;
+  *reinterpret_cast<size_t*>(table_ptr + sizeof(int32_t)) = sizeof(int);
+  uint8_t *rows_ptr = table_ptr + sizeof(int32_t) + sizeof(size_t);
+  *reinterpret_cast<int32_t*>(rows_ptr) = 3;
+  size_t rows_size = sizeof(int32_t);
+  int32_t prev_row_id = 0;
+  for (int32_t i = 0; i < 3; ++i) {
+    rows_size += MsgCompressor::EncodeRowOpLog(prev_row_id, row_ids[i],
+      column_ids, 2, updates, 2*sizeof(int), rows_ptr + rows_size);
+    prev_row_id = row_ids[i];
+  }
+  table_size_map[kCompactTableId] = rows_size;
+  size_t total_size = serializer.Compact(table_size_map);
+  EXPECT_EQ(sizeof(int32_t) + 2*(sizeof(int32_t) + sizeof(size_t))
+            + sizeof(int32_t) + rows_size, total_size);
+
+  SerializedOpLogReader reader(mem.data());
+  ASSERT_TRUE(reader.Restart());
+  int32_t table_id, row_id, num_updates;
+  const int32_t *read_column_ids;
+  bool started_new_table;
+  std::vector<const void*> read_updates;
+  for (int32_t i = 0; i < 3; ++i) {
+    const void *row_updates = reader.Next(&table_id, &row_id,
+      &read_column_ids, &num_updates, &started_new_table);
+    ASSERT_TRUE(row_updates != 0);
+    EXPECT_EQ(kCompactTableId, table_id);
+    EXPECT_EQ(row_ids[i], row_id);
+    ASSERT_EQ(2, num_updates);
+    EXPECT_EQ(column_ids[1], read_column_ids[1]);
+    read_updates.push_back(row_updates);
+  }
+  EXPECT_TRUE(reader.Next(&table_id, &row_id, &read_column_ids,
+    &num_updates, &started_new_table) == 0);
+  // Decoded updates stay valid while the reader lives.
+  for (int32_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(0, memcmp(updates, read_updates[i], sizeof(updates)));
+  }
+}
+
+TEST(MsgCodecTest, SerializedOpLogReaderDequantizes) {
+  const int32_t kQuantizedTableId = 2;
+  TableInfo table_info;
+  table_info.update_precision = Int8Precision;
+  GlobalContext::SetTableMsgFormat(kQuantizedTableId, table_info);
+
+  const int32_t column_ids[] = {1, 4, 9};
+  float updates[] = {1.27, -0.5, 0.01};
+  float residuals[3];
+  std::vector<uint8_t> quantized(UpdateQuantizer::GetQuantizedSize(
+      Int8Precision, 3));
+  UpdateQuantizer::Quantize(Int8Precision, updates, 3, residuals,
+    quantized.data());
+
+  std::map<int32_t, size_t> table_size_map;
+  table_size_map[kQuantizedTableId] = 3*sizeof(int32_t)
+      + sizeof(column_ids) + quantized.size();
+  OpLogSerializer serializer;
+  std::vector<uint8_t> mem(serializer.Init(table_size_map));
+  serializer.AssignMem(mem.data());
+  uint8_t *table_ptr
+      = reinterpret_cast<uint8_t*>(serializer.GetTablePtr(kQuantizedTableId));
+  *reinterpret_cast<int32_t*>(table_ptr) = kQuantizedTableId;
+  table_ptr += sizeof(int32_t);
+  *reinterpret_cast<size_t*>(table_ptr) = sizeof(float);
+  table_ptr += sizeof(size_t);
+  const int32_t row_header[] = {1, 17, 3};
+  memcpy(table_ptr, row_header, sizeof(row_header));
+  table_ptr += sizeof(row_header);
+  memcpy(table_ptr, column_ids, sizeof(column_ids));
+  table_ptr += sizeof(column_ids);
+  memcpy(table_ptr, quantized.data(), quantized.size());
+
+  SerializedOpLogReader reader(mem.data());
+  ASSERT_TRUE(reader.Restart());
+  int32_t table_id, row_id, num_updates;
+  const int32_t *read_column_ids;
+  bool started_new_table;
+  const float *read_updates = reinterpret_cast<const float*>(reader.Next(
+      &table_id, &row_id, &read_column_ids, &num_updates,
+      &started_new_table));
+  ASSERT_TRUE(read_updates != 0);
+  EXPECT_EQ(sizeof(float), reader.get_update_size());
+  EXPECT_EQ(17, row_id);
+  ASSERT_EQ(3, num_updates);
+  for (int32_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(column_ids[i], read_column_ids[i]);
+    EXPECT_EQ(updates[i], read_updates[i]);
+  }
+  EXPECT_TRUE(reader.Next(&table_id, &row_id, &read_column_ids,
+    &num_updates, &started_new_table) == 0);
+}
+
+}  // namespace petuum
@@ -0,0 +1,128 @@
+// Copyright (c) 2014, Sailing Lab
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the <ORGANIZATION> nor the names of its contributors
+// may be used to endorse or promote products derived from this software
+// without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "petuum_ps/thread/oplog_send_budget.hpp"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace petuum {
+
+namespace {
+
+OpLogSendBudget::RowOpLogInfo MakeRowOpLogInfo(int32_t row_id, size_t size,
+  double magnitude, int32_t max_deferred_clocks) {
+  OpLogSendBudget::RowOpLogInfo info;
+  info.table_id = 0;
+  info.row_id = row_id;
+  info.size = size;
+  info.magnitude = magnitude;
+  info.max_deferred_clocks = max_deferred_clocks;
+  return info;
+}
+
+}  // anonymous namespace
+
+TEST(OpLogSendBudgetTest, SendsLargestMagnitudesFirst) {
+  OpLogSendBudget budget;
+  budget.Init(100);
+  std::vector<OpLogSendBudget::RowOpLogInfo> row_oplogs;
+  row_oplogs.push_back(MakeRowOpLogInfo(0, 60, 1, 10));
+  row_oplogs.push_back(MakeRowOpLogInfo(1, 60, 5, 10));
+  row_oplogs.push_back(MakeRowOpLogInfo(2, 30, 2, 10));
+  row_oplogs.push_back(MakeRowOpLogInfo(3, 30, 0.5, 10));
+  std::vector<bool> send;
+  budget.Select(row_oplogs, &send);
+  // Neither row 0 nor the smaller row 3 fits after rows 1 and 2.
+  EXPECT_FALSE(send[0]);
+  EXPECT_TRUE(send[1]);
+  EXPECT_TRUE(send[2]);
+  EXPECT_FALSE(send[3]);
+
+  std::vector<int32_t> row_ids;
+  budget.GetDeferredRows(0, &row_ids);
+  ASSERT_EQ(2u, row_ids.size());
+  budget.GetDeferredRows(1, &row_ids);
+  EXPECT_TRUE(row_ids.empty());
+}
+
+TEST(OpLogSendBudgetTest, SendsOverdueRows) {
+  OpLogSendBudget budget;
+  budget.Init(10);
+  std::vector<OpLogSendBudget::RowOpLogInfo> row_oplogs;
+  row_oplogs.push_back(MakeRowOpLogInfo(0, 20, 1, 2));
+  // Never deferred.
+  row_oplogs.push_back(MakeRowOpLogInfo(1, 20, 1, 0));
+  std::vector<bool> send;
+  // The counters are process-wide.
+  int64_t rows_deferred = OpLogSendBudget::get_rows_deferred();
+  int64_t bytes_deferred = OpLogSendBudget::get_bytes_deferred();
+
+  budget.Select(row_oplogs, &send);
+  EXPECT_FALSE(send[0]);
+  EXPECT_TRUE(send[1]);
+  budget.Select(row_oplogs, &send);
+  EXPECT_FALSE(send[0]);
+  // Deferred for 2 clocks.
+  budget.Select(row_oplogs, &send);
+  EXPECT_TRUE(send[0]);
+  EXPECT_TRUE(send[1]);
+
+  std::vector<int32_t> row_ids;
+  budget.GetDeferredRows(0, &row_ids);
+  EXPECT_TRUE(row_ids.empty());
+  EXPECT_EQ(rows_deferred + 2, OpLogSendBudget::get_rows_deferred());
+  EXPECT_EQ(bytes_deferred + 40, OpLogSendBudget::get_bytes_deferred());
+}
+
+TEST(OpLogSendBudgetTest, DeferralStaysWithinStaleness) {
+  for (int32_t staleness = 0; staleness < 8; ++staleness) {
+    int32_t max_deferred_clocks
+        = OpLogSendBudget::GetMaxDeferredClocks(staleness);
+    int32_t read_staleness = OpLogSendBudget::GetReadStaleness(staleness);
+    EXPECT_GE(read_staleness, 0);
+    EXPECT_EQ(staleness, read_staleness + max_deferred_clocks);
+
+    // A row that never fits is sent after max_deferred_clocks clocks.
+    OpLogSendBudget budget;
+    budget.Init(1);
+    std::vector<OpLogSendBudget::RowOpLogInfo> row_oplogs;
+    row_oplogs.push_back(MakeRowOpLogInfo(0, 10, 1, max_deferred_clocks));
+    std::vector<bool> send;
+    for (int32_t clock = 0; clock < max_deferred_clocks; ++clock) {
+      budget.Select(row_oplogs, &send);
+      EXPECT_FALSE(send[0]);
+    }
+    budget.Select(row_oplogs, &send);
+    EXPECT_TRUE(send[0]);
+  }
+  EXPECT_EQ(0, OpLogSendBudget::GetMaxDeferredClocks(1));
+}
+
+}  // namespace petuum
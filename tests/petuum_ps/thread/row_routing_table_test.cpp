@@ -0,0 +1,94 @@
+// Copyright (c) 2014, Sailing Lab
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the <ORGANIZATION> nor the names of its contributors
+// may be used to endorse or promote products derived from this software
+// without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "petuum_ps/thread/row_routing_table.hpp"
+#include <gtest/gtest.h>
+#include <map>
+#include <vector>
+
+namespace petuum {
+
+namespace {
+
+const int32_t kTableId = 0;
+
+// Two servers, rows are on server_ids[row_id % 2].
+void InitContext() {
+  std::vector<int32_t> server_ids;
+  server_ids.push_back(1);
+  server_ids.push_back(2);
+  GlobalContext::Init(2, 1, 1, 1, 1, 1, 1, 1, server_ids,
+    std::map<int32_t, HostInfo>(), 0, 1, SSP, false);
+  TableInfo table_info;
+  table_info.row_partition_type = ModuloPartition;
+  GlobalContext::SetRowPartition(kTableId, table_info);
+}
+
+}  // anonymous namespace
+
+TEST(RowRoutingTableTest, RoutesByPartitionByDefault) {
+  InitContext();
+  RowRoutingTable routing_table;
+  EXPECT_EQ(0, routing_table.get_version());
+  EXPECT_EQ(1, routing_table.GetServerID(kTableId, 0));
+  EXPECT_EQ(2, routing_table.GetServerID(kTableId, 1));
+  EXPECT_EQ(1, routing_table.GetServerID(kTableId, 4));
+}
+
+TEST(RowRoutingTableTest, MigrateRows) {
+  InitContext();
+  RowRoutingTable routing_table;
+  const int32_t rows[] = {kTableId, 0, kTableId, 4};
+  routing_table.MigrateRows(1, rows, 2, 2);
+  EXPECT_EQ(1, routing_table.get_version());
+  EXPECT_EQ(2, routing_table.GetServerID(kTableId, 0));
+  EXPECT_EQ(2, routing_table.GetServerID(kTableId, 4));
+  // Other rows are not affected.
+  EXPECT_EQ(1, routing_table.GetServerID(kTableId, 2));
+  EXPECT_EQ(2, routing_table.GetServerID(kTableId, 1));
+}
+
+TEST(RowRoutingTableTest, MigrateRowsBackHome) {
+  InitContext();
+  RowRoutingTable routing_table;
+  const int32_t rows[] = {kTableId, 0, kTableId, 1};
+  routing_table.MigrateRows(1, rows, 1, 2);
+  // Row 1 already is on server 2.
+  routing_table.MigrateRows(2, rows + 2, 1, 2);
+  EXPECT_EQ(2, routing_table.GetServerID(kTableId, 0));
+  EXPECT_EQ(2, routing_table.GetServerID(kTableId, 1));
+
+  routing_table.MigrateRows(3, rows, 2, 1);
+  EXPECT_EQ(3, routing_table.get_version());
+  EXPECT_EQ(1, routing_table.GetServerID(kTableId, 0));
+  EXPECT_EQ(1, routing_table.GetServerID(kTableId, 1));
+}
+
+}  // namespace petuum
@@ -4,7 +4,8 @@ UTIL_SRC_HPP = $(PS_DIR)/util/mem_block.hpp
 UTIL_SRC_CPP = $(PS_DIR)/util/vector_clock.cpp
 
 SERVER_SRC_HPP = $(PS_DIR)/server/server_threads.hpp $(PS_DIR)/server/server.hpp
-SERVER_SRC_CPP = $(PS_DIR)/server/server_threads.cpp $(PS_DIR)/server/server.cpp
+SERVER_SRC_CPP = $(PS_DIR)/server/server_threads.cpp $(PS_DIR)/server/server.cpp \
+	$(PS_DIR)/server/server_apply_threads.cpp
 
 STORAGE_SRC_HPP = $(PS_DIR)/storage/process_storage.hpp $(PS_DIR)/storage/clock_lru.hpp \
 	$(PS_DIR)/storage/client_row.hpp $(PS_DIR)/storage/dense_row.hpp \
@@ -22,9 +23,14 @@ PS_INCLUDE_HPP = $(PS_DIR)/include/table_group.hpp $(PS_DIR)/include/table.hpp \
 	$(PS_DIR)/include/abstract_row.hpp
 
 THREADS_SRC_HPP = $(PS_DIR)/thread/bg_workers.hpp $(PS_DIR)/thread/context.hpp \
-	$(PS_DIR)/thread/ps_msgs.hpp $(PS_DIR)/thread/msg_tracker.hpp
+	$(PS_DIR)/thread/ps_msgs.hpp $(PS_DIR)/thread/msg_tracker.hpp \
+	$(PS_DIR)/thread/msg_codec.hpp $(PS_DIR)/thread/update_quantizer.hpp \
+	$(PS_DIR)/thread/oplog_send_budget.hpp \
+	$(PS_DIR)/thread/app_request_ring.hpp $(PS_DIR)/thread/completion_slot.hpp
 THREADS_SRC_CPP = $(PS_DIR)/thread/bg_workers.cpp $(PS_DIR)/thread/context.cpp \
-	$(PS_DIR)/thread/msg_tracker.cpp
+	$(PS_DIR)/thread/msg_tracker.cpp $(PS_DIR)/thread/msg_codec.cpp \
+	$(PS_DIR)/thread/update_quantizer.cpp $(PS_DIR)/thread/oplog_send_budget.cpp \
+	$(PS_DIR)/thread/app_request_ring.cpp
 
 tests_bg: $(TESTS)/petuum_ps/thread/bg_workers_tests.cpp $(UTIL_SRC_HPP) \
 	$(STORAGE_SRC_HPP) $(STORAGE_SRC_CPP) $(OPLOG_SRC_HPP) $(OPLOG_SRC_CPP) \
@@ -37,4 +43,81 @@ tests_bg: $(TESTS)/petuum_ps/thread/bg_workers_tests.cpp $(UTIL_SRC_HPP) \
 
 tests_bg_workers: $(THREADS_SRC_HPP) $(THREADS_SRC_CPP)
 	$(CXX) $(INCFLAGS) $(CXXFLAGS) bg_workers_tests.cpp \
-	$(THREADS_SRC_CPP) $(LDFLAGS) -o $(BIN)/$@
\ No newline at end of file
+	$(THREADS_SRC_CPP) $(LDFLAGS) -o $(BIN)/$@
+
+THREAD_TESTS_DIR = $(TESTS)/petuum_ps/thread
+
+$(TESTS_BIN)/msg_codec_test: $(THREAD_TESTS_DIR)/msg_codec_test.cpp \
+	$(SRC)/petuum_ps/thread/msg_codec.cpp \
+	$(SRC)/petuum_ps/thread/msg_codec.hpp \
+	$(SRC)/petuum_ps/thread/update_quantizer.cpp \
+	$(SRC)/petuum_ps/thread/update_quantizer.hpp \
+	$(SRC)/petuum_ps/oplog/serialized_oplog_reader.hpp
+	$(CXX) $(CXXFLAGS) $(INCFLAGS) $< \
+		$(SRC)/petuum_ps/thread/msg_codec.cpp \
+		$(SRC)/petuum_ps/thread/update_quantizer.cpp \
+		$(SRC)/petuum_ps/thread/context.cpp $(TESTS_LDFLAGS) -o $@
+
+msg_codec_test_run: $(TESTS_BIN)/msg_codec_test
+	GLOG_logtostderr=true $<
+
+$(TESTS_BIN)/update_quantizer_test: \
+	$(THREAD_TESTS_DIR)/update_quantizer_test.cpp \
+	$(SRC)/petuum_ps/thread/update_quantizer.cpp \
+	$(SRC)/petuum_ps/thread/update_quantizer.hpp
+	$(CXX) $(CXXFLAGS) $(INCFLAGS) $< \
+		$(SRC)/petuum_ps/thread/update_quantizer.cpp $(TESTS_LDFLAGS) -o $@
+
+update_quantizer_test_run: $(TESTS_BIN)/update_quantizer_test
+	GLOG_logtostderr=true $<
+
+$(TESTS_BIN)/oplog_send_budget_test: \
+	$(THREAD_TESTS_DIR)/oplog_send_budget_test.cpp \
+	$(SRC)/petuum_ps/thread/oplog_send_budget.cpp \
+	$(SRC)/petuum_ps/thread/oplog_send_budget.hpp
+	$(CXX) $(CXXFLAGS) $(INCFLAGS) $< \
+		$(SRC)/petuum_ps/thread/oplog_send_budget.cpp $(TESTS_LDFLAGS) -o $@
+
+oplog_send_budget_test_run: $(TESTS_BIN)/oplog_send_budget_test
+	GLOG_logtostderr=true $<
+
+$(TESTS_BIN)/app_request_ring_test: \
+	$(THREAD_TESTS_DIR)/app_request_ring_test.cpp \
+	$(SRC)/petuum_ps/thread/app_request_ring.cpp \
+	$(SRC)/petuum_ps/thread/app_request_ring.hpp \
+	$(SRC)/petuum_ps/thread/completion_slot.hpp
+	$(CXX) $(CXXFLAGS) $(INCFLAGS) $< \
+		$(SRC)/petuum_ps/thread/app_request_ring.cpp $(TESTS_LDFLAGS) -o $@
+
+app_request_ring_test_run: $(TESTS_BIN)/app_request_ring_test
+	GLOG_logtostderr=true $<
+
+$(TESTS_BIN)/row_routing_table_test: \
+	$(THREAD_TESTS_DIR)/row_routing_table_test.cpp \
+	$(SRC)/petuum_ps/thread/row_routing_table.hpp \
+	$(SRC)/petuum_ps/thread/context.cpp
+	$(CXX) $(CXXFLAGS) $(INCFLAGS) $< \
+		$(SRC)/petuum_ps/thread/context.cpp $(TESTS_LDFLAGS) -o $@
+
+row_routing_table_test_run: $(TESTS_BIN)/row_routing_table_test
+	GLOG_logtostderr=true $<
+
+$(TESTS_BIN)/bg_oplog_partition_test: \
+	$(THREAD_TESTS_DIR)/bg_oplog_partition_test.cpp \
+	$(SRC)/petuum_ps/thread/bg_oplog_partition.cpp \
+	$(SRC)/petuum_ps/thread/bg_oplog_partition.hpp \
+	$(SRC)/petuum_ps/oplog/oplog_partition.cpp \
+	$(SRC)/petuum_ps/oplog/oplog_index.cpp \
+	$(SRC)/petuum_ps/oplog/oplog_index.hpp
+	$(CXX) $(CXXFLAGS) $(INCFLAGS) $< \
+		$(SRC)/petuum_ps/thread/bg_oplog_partition.cpp \
+		$(SRC)/petuum_ps/oplog/oplog_partition.cpp \
+		$(SRC)/petuum_ps/oplog/oplog_index.cpp \
+		$(SRC)/petuum_ps/thread/context.cpp \
+		$(SRC)/petuum_ps/thread/msg_codec.cpp \
+		$(SRC)/petuum_ps/thread/update_quantizer.cpp \
+		$(SRC)/petuum_ps/util/vector_kernels.cpp \
+		$(SRC)/petuum_ps/util/lock.cpp $(TESTS_LDFLAGS) -o $@
+
+bg_oplog_partition_test_run: $(TESTS_BIN)/bg_oplog_partition_test
+	GLOG_logtostderr=true $<
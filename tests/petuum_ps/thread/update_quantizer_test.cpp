@@ -0,0 +1,115 @@
+// Copyright (c) 2014, Sailing Lab
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the <ORGANIZATION> nor the names of its contributors
+// may be used to endorse or promote products derived from this software
+// without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "petuum_ps/thread/update_quantizer.hpp"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace petuum {
+
+namespace {
+
+// Quantize updates, check the quantized size and that the residuals make up
+// the difference, and return the largest residual magnitude relative to the
+// largest update magnitude.
+float QuantizeRoundTrip(UpdatePrecision precision,
+  const std::vector<float> &updates) {
+  int32_t num_updates = updates.size();
+  std::vector<float> values(updates);
+  std::vector<float> residuals(num_updates);
+  std::vector<uint8_t> mem(UpdateQuantizer::GetQuantizedSize(precision,
+      num_updates));
+  UpdateQuantizer::Quantize(precision, values.data(), num_updates,
+    residuals.data(), mem.data());
+
+  std::vector<float> dequantized(num_updates);
+  UpdateQuantizer::Dequantize(precision, mem.data(), num_updates,
+    dequantized.data());
+  float max_update = 0;
+  float max_residual = 0;
+  for (int32_t i = 0; i < num_updates; ++i) {
+    EXPECT_EQ(values[i], dequantized[i]);
+    EXPECT_EQ(updates[i], values[i] + residuals[i]);
+    max_update = std::max(max_update, std::fabs(updates[i]));
+    max_residual = std::max(max_residual, std::fabs(residuals[i]));
+  }
+  return max_update == 0 ? max_residual : max_residual / max_update;
+}
+
+}  // anonymous namespace
+
+TEST(UpdateQuantizerTest, Int8RoundTrip) {
+  EXPECT_EQ(sizeof(float) + 3, UpdateQuantizer::GetQuantizedSize(
+      Int8Precision, 3));
+  std::vector<float> updates = {0.5, -0.25, 0.001, 0, 3.75, -3.75};
+  // Rounding to a multiple of scale is off by at most half of it.
+  EXPECT_LE(QuantizeRoundTrip(Int8Precision, updates), 0.5/127);
+
+  std::vector<float> zeros(8, 0);
+  EXPECT_EQ(0, QuantizeRoundTrip(Int8Precision, zeros));
+}
+
+TEST(UpdateQuantizerTest, HalfRoundTrip) {
+  EXPECT_EQ(sizeof(float) + 2*3, UpdateQuantizer::GetQuantizedSize(
+      HalfPrecision, 3));
+  std::vector<float> updates = {1e-6, -2e3, 7.125, 1e-30, -1e30};
+  EXPECT_LE(QuantizeRoundTrip(HalfPrecision, updates), 1.0/2048);
+}
+
+TEST(UpdateQuantizerTest, HalfConversion) {
+  EXPECT_EQ(0x0000, UpdateQuantizer::FloatToHalf(0));
+  EXPECT_EQ(0x8000, UpdateQuantizer::FloatToHalf(-0.0f));
+  EXPECT_EQ(0x3c00, UpdateQuantizer::FloatToHalf(1));
+  EXPECT_EQ(0xc000, UpdateQuantizer::FloatToHalf(-2));
+  EXPECT_EQ(0x7bff, UpdateQuantizer::FloatToHalf(65504));
+  EXPECT_EQ(0x7c00, UpdateQuantizer::FloatToHalf(65520));
+  EXPECT_EQ(0xfc00, UpdateQuantizer::FloatToHalf(
+      -std::numeric_limits<float>::infinity()));
+  // Smallest subnormal and smallest normal halves.
+  EXPECT_EQ(0x0001, UpdateQuantizer::FloatToHalf(std::ldexp(1.0f, -24)));
+  EXPECT_EQ(0x0400, UpdateQuantizer::FloatToHalf(std::ldexp(1.0f, -14)));
+  // Ties round to even: 1 + 2^-11 is halfway between 1 and 1 + 2^-10.
+  EXPECT_EQ(0x3c00, UpdateQuantizer::FloatToHalf(1 + std::ldexp(1.0f, -11)));
+  EXPECT_EQ(0x3c02, UpdateQuantizer::FloatToHalf(1 + 3*std::ldexp(1.0f, -11)));
+  EXPECT_TRUE(std::isnan(UpdateQuantizer::HalfToFloat(
+      UpdateQuantizer::FloatToHalf(std::numeric_limits<float>::quiet_NaN()))));
+
+  // Every finite half converts back to itself.
+  for (uint32_t half = 0; half < 0x10000; ++half) {
+    if ((half & 0x7c00) == 0x7c00)
+      continue;
+    EXPECT_EQ(half, UpdateQuantizer::FloatToHalf(
+        UpdateQuantizer::HalfToFloat(half)));
+  }
+}
+
+}  // namespace petuum
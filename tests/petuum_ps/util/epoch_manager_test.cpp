@@ -0,0 +1,148 @@
+// Copyright (c) 2014, Sailing Lab
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the <ORGANIZATION> nor the names of its contributors
+// may be used to endorse or promote products derived from this software
+// without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "petuum_ps/util/epoch_manager.hpp"
+#include <gtest/gtest.h>
+#include <glog/logging.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace petuum {
+
+namespace {
+
+std::atomic<int> num_deleted(0);
+
+struct Tracked {
+  explicit Tracked(int v) : value(v) { }
+  ~Tracked() {
+    value = -1;
+    ++num_deleted;
+  }
+  int value;
+};
+
+}  // anonymous namespace
+
+TEST(EpochManagerTest, RetireWithoutReaders) {
+  num_deleted = 0;
+  EpochManager::Retire(new Tracked(1));
+  EpochManager::Reclaim();
+  EXPECT_EQ(1, num_deleted);
+}
+
+TEST(EpochManagerTest, ReaderDefersReclamation) {
+  num_deleted = 0;
+  Tracked *obj = new Tracked(2);
+
+  std::atomic<bool> entered(false);
+  std::atomic<bool> done(false);
+  std::thread reader([&] {
+      EpochManager::Enter();
+      // Nested Enter()/Exit() keeps the outer epoch.
+      EpochManager::Enter();
+      EpochManager::Exit();
+      entered = true;
+      while (!done) { }
+      EXPECT_EQ(2, obj->value);
+      EpochManager::Exit();
+    });
+  while (!entered) { }
+
+  EpochManager::Retire(obj);
+  EpochManager::Reclaim();
+  EXPECT_EQ(0, num_deleted);
+
+  done = true;
+  reader.join();
+  EpochManager::Reclaim();
+  EXPECT_EQ(1, num_deleted);
+}
+
+TEST(EpochManagerTest, LateReaderDoesNotBlock) {
+  num_deleted = 0;
+  Tracked *obj = new Tracked(3);
+  EpochManager::Retire(obj);
+
+  // A reader that enters after Retire() cannot see obj.
+  EpochManager::Enter();
+  EpochManager::Reclaim();
+  EXPECT_EQ(1, num_deleted);
+  EpochManager::Exit();
+}
+
+TEST(EpochManagerTest, RetireWhileInsideEpoch) {
+  num_deleted = 0;
+  const int kNumRetired = 1000;
+  EpochManager::Enter();
+  for (int i = 0; i < kNumRetired; ++i) {
+    EpochManager::Retire(new Tracked(i));
+  }
+  EXPECT_EQ(0, num_deleted);
+  EpochManager::Exit();
+
+  // Retire() alone frees them once the reader has left.
+  for (int i = 0; i < 2*kNumRetired; ++i) {
+    EpochManager::Retire(new Tracked(i));
+  }
+  EXPECT_LE(kNumRetired, num_deleted);
+  EpochManager::Reclaim();
+  EXPECT_EQ(3*kNumRetired, num_deleted);
+}
+
+TEST(EpochManagerTest, MTTest) {
+  num_deleted = 0;
+  const int kNumIter = 10000;
+  int num_threads = std::max(2u, std::thread::hardware_concurrency());
+  std::atomic<Tracked*> shared(new Tracked(0));
+
+  std::vector<std::thread> thread_pool;
+  for (int t = 0; t < num_threads; ++t) {
+    thread_pool.emplace_back([&, t] {
+        for (int i = 0; i < kNumIter; ++i) {
+          if (t == 0) {
+            EpochManager::Retire(shared.exchange(new Tracked(i + 1)));
+          } else {
+            EpochManager::Enter();
+            EXPECT_LE(0, shared.load()->value);
+            EpochManager::Exit();
+          }
+        }
+      });
+  }
+  for (auto &thr : thread_pool) {
+    thr.join();
+  }
+  delete shared.load();
+  EpochManager::Reclaim();
+  EXPECT_EQ(kNumIter + 1, num_deleted);
+}
+
+}  // namespace petuum
@@ -38,3 +38,12 @@ $(TESTS_BIN)/striped_lock_test: $(UTIL_TESTS_DIR)/striped_lock_test.cpp \
 
 striped_lock_test_run: $(TESTS_BIN)/striped_lock_test
 	$<
+
+$(TESTS_BIN)/epoch_manager_test: $(UTIL_TESTS_DIR)/epoch_manager_test.cpp \
+	$(SRC)/petuum_ps/util/epoch_manager.cpp \
+	$(SRC)/petuum_ps/util/epoch_manager.hpp
+	$(CXX) $(CXXFLAGS) $(INCFLAGS) $< $(SRC)/petuum_ps/util/epoch_manager.cpp \
+		$(TESTS_LDFLAGS) -o $@
+
+epoch_manager_test_run: $(TESTS_BIN)/epoch_manager_test
+	GLOG_logtostderr=true $<